@@ -1,19 +1,28 @@
 #ifndef APP_H
 #define APP_H
 
+#include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 
+#include "app/SceneFile.h"
+#include "app/SceneResidency.h"
 #include "app/Window.h"
 #include "util/Camera.h"
+#include "util/RenderContext.h"
 
 
 #ifndef WINDOW_NAME
 #define WINDOW_NAME "HW3"
 #endif
 
+class AssetStreamer;
+class BufferUploader;
 class Shader;
+class ShaderWatcher;
 class Renderable;
 
 
@@ -39,38 +48,116 @@ private:
     static constexpr int kWindowWidth {1000};
     static constexpr int kWindowHeight {1000};
 
+    // Screen-space adaptive tessellation of the parametric shapes (modes 4 and 7).
+    static constexpr float kTessPixelsPerEdge {8.0f};
+    static constexpr float kTessMinLevel {1.0f};  // per patch edge; shapes are split into many patches
+    static constexpr float kTessMaxLevel {64.0f};  // GL_MAX_TESS_GEN_LEVEL is at least 64
+
+    // tessLevelOuter the CPU fallback bakes the adaptively tessellated shapes at.
+    static constexpr float kBakedTessLevel {64.0f};
+
+    // Scenes of every rendering mode; HW3_SCENE in the environment names another file.
+    static constexpr char kSceneFile[] {"var/scene.json"};
+
+    // Budget for the GPU buffers of all resident modes, the one shown always staying; HW3_GPU_BUDGET_MB overrides.
+    static constexpr std::size_t kGpuBudgetMegabytes {256};
+
+    // Vertex data of streamed-in shapes uploaded per frame, at least one shape, when there is
+    // no upload thread (HW3_UPLOAD_THREAD=0 or no shared context).
+    static constexpr std::size_t kUploadBudgetKilobytes {4096};
+
 private:
     App();
 
     void initializeShadersAndObjects();
-    void initializeObjects2();
-    void initializeObjects3();
-    void initializeObjects4();
-    void initializeObjects5();
-    void initializeObjects6();
-    void initializeObjects7();
 
-    void render();
+    // Appends the Renderables of one scene object at model; level is the tessLevelOuter baked shapes get.
+    void addObject(
+            const SceneFile::Object & object,
+            const glm::mat4 & model,
+            float level,
+            std::vector<std::unique_ptr<Renderable>> & shapes
+    );
+
+    // "+": subdivides the mode's icospheres and dodecahedra and doubles its tessLevel.
+    void refineMode(int mode);
+
+    // True if the parametric shapes should be baked on the CPU (ParametricMesh) instead of
+    // tessellated per frame (Sphere): no tessellation support, a software rasterizer,
+    // or HW3_CPU_TESSELLATION set in the environment ("0" forces the GPU path).
+    static bool detectCpuTessellation();
+
+    // Sphere or ParametricMesh, depending on useCpuTessellation.
+    // level is the tessLevelOuter a baked shape is evaluated at.
+    std::unique_ptr<Renderable> makeParametricShape(
+            const glm::vec3 & center,
+            float radius,
+            const glm::vec3 & color,
+            const glm::mat4 & model,
+            int shapeType,
+            float level
+    );
+
+    // Re-bakes the CPU-tessellated shapes in the given list for a new tessLevelOuter.
+    static void setBakedLevel(std::vector<std::unique_ptr<Renderable>> & shapes, float level);
+
+    // One frame in flight: the view it was set up with and what the world's systems made of it.
+    struct Frame
+    {
+        SceneResidency::Scene * pScene {nullptr};
+        RenderContext context;
+        glm::vec3 viewPos {0.0f};
+        glm::vec3 lightPos {0.0f};
+        glm::vec3 sphereLightPos {0.0f};
+        glm::vec3 lightColor {1.0f};
+        float tessLevelOuter {64.0f};
+        float tessPixelsPerEdge {0.0f};
+        float timeElapsed {0.0f};
+        RenderWorld::Frame culled;
+    };
+
+    // Main thread: activates the mode and records the camera and lights in frame.
+    void beginFrame(Frame & frame);
+
+    // Any thread: culling, LOD selection and the draw list of frame. Only reads the scene.
+    void prepareFrame(Frame & frame);
+
+    // Main thread: uniforms and draws of a prepared frame.
+    void submitFrame(const Frame & frame);
 
     // Shaders.
     std::unique_ptr<Shader> pLineShader;
     std::unique_ptr<Shader> pMeshShader;
-    std::unique_ptr<Shader> pSphereShader;
+    std::unique_ptr<Shader> pSphereShader;       // null when useCpuTessellation
+    std::unique_ptr<Shader> pParametricShader;   // mesh shader lit like pSphereShader, for baked shapes
 
-    // Objects to render.
-    std::vector<std::unique_ptr<Renderable>> shapes;
-    std::vector<std::unique_ptr<Renderable>> shapes_mode_2;
-    std::vector<std::unique_ptr<Renderable>> shapes_mode_3;
-    std::vector<std::unique_ptr<Renderable>> shapes_mode_4;
-    std::vector<std::unique_ptr<Renderable>> shapes_mode_5;
-    std::vector<std::unique_ptr<Renderable>> shapes_mode_6;
-    std::vector<std::unique_ptr<Renderable>> shapes_mode_7;
+    bool useCpuTessellation {false};
+
+    // Rebuilds the shaders above when their files under src/shader/ change.
+    std::unique_ptr<ShaderWatcher> pShaderWatcher;
+
+    // 0 = Phong, 1 = Gouraud, 2 = normals (F4/F2/F3).
+    // Kept here and sent every frame, so it survives shader reloads.
+    int displayMode {0};
+
+    // Objects to render, per mode, created when first needed; file-based shapes load in the background.
+    SceneFile scene;
+    std::unique_ptr<BufferUploader> pUploader;  // null without a shared context
+    std::unique_ptr<AssetStreamer> pStreamer;
+    std::unique_ptr<SceneResidency> pResidency;
 
     // Viewing
     Camera camera {{0.0f, 0.0f, 10.0f}};
     glm::mat4 view = glm::mat4(1.0f);
     glm::mat4 projection = glm::mat4(1.0f);
 
+    // View state of the frame being submitted, for shapes culling their own meshlets.
+    RenderContext renderContext;
+
+    // Frame N is submitted while frame N + 1 is prepared, then they swap.
+    Frame frames[2];
+    std::size_t frameIndex {0};
+
     glm::vec3 lightColor {1.0f, 1.0f, 1.0f};
     glm::vec3 lightPos {-10.0f, 4.0f, 7.0f};
 
@@ -81,8 +168,9 @@ private:
     bool mousePressed {false};
     glm::dvec2 mousePos {0.0, 0.0};
 
-    KeyFrameCamera* HorizontalCamera;
-    KeyFrameCamera* VerticalCamera;
+    // Keyframe camera paths of the scene file, by name; H and V pick "horizontal" and "vertical".
+    std::map<std::string, std::unique_ptr<KeyFrameCamera>> keyFrameCameras;
+    KeyFrameCamera * pKeyFrameCamera {nullptr};
 
     // Used for camera movement from mouse dragging.
     // Note lastMouseLeftClickPos is different from lastMouseLeftPressPos.
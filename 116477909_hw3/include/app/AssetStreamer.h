@@ -0,0 +1,90 @@
+#ifndef ASSETSTREAMER_H
+#define ASSETSTREAMER_H
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "shape/Renderable.h"
+#include "util/JobSystem.h"
+
+
+class BufferUploader;
+class StreamedMesh;
+
+
+/// Loads shapes without stalling the frame loop.
+/// File I/O, parsing and other CPU preparation run as JobSystem background jobs, which the
+/// main thread does not pick up while it waits for a frame. With a BufferUploader
+/// their vertex buffers are then filled on its context, and update() creates each shape
+/// around its buffer once the GPU has it. Without one, results queue up for the main thread,
+/// where update() creates the GL objects of at most budgetBytes of vertex data per frame
+/// (always at least one shape, however large). Either way each shape goes to the StreamedMesh
+/// drawing a placeholder in its place. Results for StreamedMeshes destroyed meanwhile, e.g.
+/// by SceneResidency releasing their mode, are dropped.
+class AssetStreamer
+{
+public:
+    /// What a job prepared: the bytes the shape will upload and the main-thread step creating it.
+    struct Prepared
+    {
+        std::size_t bytes {0};
+
+        // Writes the shape's vertex buffer, bytes long; any thread. Null if it has none.
+        std::function<void(void * pDestination)> fill;
+
+        // Creates the shape around a buffer fill wrote, or with buffer 0 uploading itself.
+        std::function<std::unique_ptr<Renderable>(GLuint buffer)> create;
+    };
+
+    // Runs on a worker; must not call GL.
+    using Prepare = std::function<Prepared()>;
+
+    // pUploader, if not null, must outlive this object.
+    AssetStreamer(std::size_t budgetBytes, BufferUploader * pUploader);
+
+    AssetStreamer(const AssetStreamer &) = delete;
+    AssetStreamer & operator=(const AssetStreamer &) = delete;
+
+    // Waits for the jobs still preparing, since they finish into this object.
+    ~AssetStreamer() noexcept;
+
+    // Main thread. Prepares pTarget's shape in the background.
+    void request(StreamedMesh * pTarget, Prepare prepare);
+
+    // Main thread, once per frame. Creates prepared shapes within the budget.
+    // Rethrows the first exception of a failed preparation.
+    void update();
+
+    // Requests not yet handed over.
+    [[nodiscard]] std::size_t pending() const { return requested; }
+
+private:
+    struct Result
+    {
+        StreamedMesh * pTarget {nullptr};
+        std::weak_ptr<void> target;
+        Prepared prepared;
+        std::exception_ptr error;
+    };
+
+    // Main thread: hands result's shape, around buffer, to its StreamedMesh if that still exists.
+    void deliver(Result & result, GLuint buffer);
+
+    std::size_t budgetBytes;
+    BufferUploader * pUploader;
+    std::size_t requested {0};
+
+    JobSystem::Counter preparing;
+
+    std::mutex readyMutex;
+    std::vector<Result> ready;
+};
+
+
+#endif  // ASSETSTREAMER_H
@@ -0,0 +1,81 @@
+#ifndef BUFFERUPLOADER_H
+#define BUFFERUPLOADER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+
+
+class GLFWwindow;
+
+
+/// Creates and fills GL buffers on a thread of its own, so large uploads do not stall frames.
+///
+/// The thread owns the context of a hidden window sharing objects with the main window.
+/// It maps each new buffer, lets the caller write the data straight into it, and fences the
+/// upload; poll() on the main thread hands over every buffer whose fence has signaled.
+/// Buffers are shared between the contexts, vertex arrays are not, so the receiver binds the
+/// buffer to its own VAO (see Mesh::adoptVertexBuffer()).
+class BufferUploader
+{
+public:
+    // Writes exactly the requested number of bytes to pDestination.
+    using Fill = std::function<void(void * pDestination)>;
+
+    // Receives the filled buffer on the main thread, and owns it from then on.
+    using Done = std::function<void(GLuint buffer)>;
+
+    // Must be called on the main thread, with pShare's context current.
+    // Throws std::runtime_error if no shared context can be created.
+    explicit BufferUploader(GLFWwindow * pShare);
+
+    BufferUploader(const BufferUploader &) = delete;
+    BufferUploader & operator=(const BufferUploader &) = delete;
+
+    // Main thread. Buffers not yet handed over are deleted.
+    ~BufferUploader() noexcept;
+
+    // Any thread. Queues a GL_ARRAY_BUFFER of bytes filled by fill; done receives it in poll().
+    void upload(std::size_t bytes, Fill fill, Done done);
+
+    // Main thread, once per frame. Calls done for every upload the GPU has finished.
+    void poll();
+
+private:
+    struct Request
+    {
+        std::size_t bytes {0};
+        Fill fill;
+        Done done;
+    };
+
+    struct Upload
+    {
+        GLuint buffer {0U};
+        GLsync fence {nullptr};
+        Done done;
+    };
+
+    void uploadLoop();
+
+    GLFWwindow * pContext {nullptr};
+    std::thread worker;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Request> requests;
+    std::vector<Upload> fenced;
+    bool running {true};
+
+    // Main thread only: fenced uploads whose fences have not signaled yet.
+    std::vector<Upload> inFlight;
+};
+
+
+#endif  // BUFFERUPLOADER_H
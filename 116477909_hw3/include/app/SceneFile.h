@@ -0,0 +1,121 @@
+#ifndef SCENEFILE_H
+#define SCENEFILE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "shape/Line.h"
+#include "util/SceneGraph.h"
+
+
+/// Typed contents of a scene file (var/scene.json): the objects, light and camera of every
+/// rendering mode plus the keyframe camera paths. load() only parses and validates; App
+/// creates the GL objects of a mode the first time it is shown.
+///
+/// Transforms are {"translate": [x, y, z], "rotate": {"angle": degrees, "axis": [x, y, z]},
+/// "scale": [x, y, z] or s}, all optional, applied as translate * rotate * scale.
+/// Any object may list "children", placed relative to it; a "group" is an object that only
+/// holds children.
+/// Shape types are named ("sphere", "cylinder", "cone", "torus", "superquadric") or numbered.
+/// Boxes and meshes with "compressed": true keep their vertices in Mesh::VertexFormat::kCompressed.
+/// Meshes with "lod": true are simplified into an LodMesh chain when loaded (not compressed).
+class SceneFile
+{
+public:
+    struct Instance
+    {
+        glm::vec3 center {0.0f};
+        float radius {1.0f};
+        glm::vec3 color {1.0f};
+        int shapeType {0};
+    };
+
+    struct Object
+    {
+        enum class Type
+        {
+            kGroup,              // "group": children only
+            kLine,               // "line": vertices [{position, color}]
+            kBox,                // "box": unit cube of one color; compressed
+            kMesh,               // "mesh": triangle file, as Tetrahedron reads it; compressed or lod, crossFade
+            kIcosphere,          // "icosphere": icosahedron file, subdivided; scale, crossFade
+            kSubdivisionMesh,    // "dodecahedron": docadehedron file; shapeType
+            kParametric,         // "parametric": center, radius, color, shapeType, level
+            kParametricBatch,    // "parametricBatch": instances sharing model and level
+        };
+
+        Type type {Type::kMesh};
+
+        // Relative to the parent, an earlier object of the mode (-1 for none).
+        SceneGraph::Transform transform;
+        int parent {-1};
+
+        std::string file;
+        glm::vec3 color {1.0f};
+        glm::vec3 scale {1.0f};
+        bool crossFade {false};
+        bool compressed {false};
+        bool lod {false};
+
+        std::vector<Line::Vertex> lineVertices;
+
+        // Parametric shapes; a single kParametric is instances[0].
+        std::vector<Instance> instances;
+
+        // tessLevelOuter of CPU-baked shapes; 0 for the mode's.
+        float level {0.0f};
+    };
+
+    struct Mode
+    {
+        // Depth-first: children follow their parent.
+        std::vector<Object> objects;
+
+        glm::vec3 lightPosition {-10.0f, 4.0f, 7.0f};
+        glm::vec3 lightColor {1.0f};
+
+        // Parametric shapes are lit from the keyframe camera instead.
+        bool parametricLightFollowsCamera {false};
+
+        // Keyframe camera path the mode's key selects; empty for the free camera.
+        std::string cameraPath;
+
+        // Fixed tessLevelOuter that "+" doubles; 0 to follow on-screen size.
+        float tessLevel {0.0f};
+
+        // "+" subdivides the mode's icospheres and dodecahedra.
+        bool refinable {false};
+    };
+
+    struct CameraPath
+    {
+        struct Frame
+        {
+            glm::vec3 position {0.0f};
+            glm::quat rotation {1.0f, 0.0f, 0.0f, 0.0f};
+            float duration {0.0f};  // seconds from the previous frame
+        };
+
+        glm::vec3 position {0.0f};
+        glm::quat rotation {1.0f, 0.0f, 0.0f, 0.0f};
+        std::vector<Frame> frames;
+
+        // Played at one speed over the total duration; false reaches each frame after its duration.
+        bool constantSpeed {true};
+    };
+
+    // Throws std::runtime_error naming the file and the offending entry.
+    static SceneFile load(const std::string & file);
+
+    // One of modes; the lowest if the file names none.
+    int initialMode {1};
+    std::map<int, Mode> modes;
+    std::map<std::string, CameraPath> cameraPaths;
+};
+
+
+#endif  // SCENEFILE_H
@@ -0,0 +1,121 @@
+#ifndef SCENERESIDENCY_H
+#define SCENERESIDENCY_H
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "app/SceneFile.h"
+#include "shape/Renderable.h"
+#include "shape/RenderWorld.h"
+#include "util/SceneGraph.h"
+
+
+/// Decides which rendering modes have their objects resident on the GPU.
+///
+/// A mode's objects are created the first time it is activated. Modes no longer shown stay
+/// resident until the measured GPU bytes of all modes exceed the budget; then the least
+/// recently shown ones are released, modes never shown (prefetched only) first.
+/// prefetch() creates one object per call of the mode most likely shown next (the most
+/// frequent successor of the current mode so far, else its neighbours), spreading loading
+/// over frames instead of stalling the first frame of the next mode.
+/// Each mode's objects hang off a SceneGraph built from the scene file; moving a node moves
+/// every shape created from it or its descendants on the next activate(). The shapes are
+/// entities of the mode's RenderWorld, which culls them and lists what to draw.
+/// Shapes streamed in by AssetStreamer count, and are culled, as placeholders until they arrive.
+class SceneResidency
+{
+public:
+    struct Scene
+    {
+        std::vector<std::unique_ptr<Renderable>> shapes;
+
+        // One node per scene file object, kept across eviction.
+        SceneGraph graph;
+        std::vector<SceneGraph::NodeId> nodes;
+
+        // Entities of the shapes, and the node placing each.
+        RenderWorld world;
+        std::vector<std::pair<SceneGraph::NodeId, RenderWorld::Entity>> placed;
+
+        // The mode's fixed tessLevel, as "+" left it; kept across eviction.
+        float tessLevel {0.0f};
+
+        // Scene file objects created so far, out of the mode's objects.size().
+        std::size_t loadedObjects {0};
+
+        // Sum of gpuBytes() over shapes, and the largest seen, so a mode known not
+        // to fit is not prefetched again.
+        std::size_t gpuBytes {0};
+        std::size_t peakGpuBytes {0};
+
+        // activate() count at the last activation; 0 if only prefetched.
+        std::size_t lastUsed {0};
+    };
+
+    // Appends the Renderables of one scene file object to shapes, given its world matrix
+    // and the level CPU-baked parametric shapes get.
+    using ObjectFactory = std::function<void(const SceneFile::Object & object,
+                                             const glm::mat4 & model,
+                                             float level,
+                                             std::vector<std::unique_ptr<Renderable>> & shapes)>;
+
+    // level is what parametric shapes of modes without a tessLevel are baked at.
+    SceneResidency(const SceneFile & sceneFile, std::size_t budgetBytes, float level, ObjectFactory factory);
+
+    // The scene of mode with every object created and placed where its graph says,
+    // or null if the scene file lacks the mode.
+    Scene * activate(int mode);
+
+    // The scene of mode if any of it is resident, without loading or touching it.
+    [[nodiscard]] Scene * find(int mode);
+
+    // Call after the objects of a resident mode changed their buffers (e.g. "+").
+    void remeasure(int mode);
+
+    // Loads one object of a likely next mode if the budget allows. Call once per frame.
+    void prefetch();
+
+    // Remeasures the modes whose StreamedMeshes received their shapes since the last call.
+    // Call once per frame, while nothing reads the scenes.
+    void update();
+
+    [[nodiscard]] std::size_t residentBytes() const { return totalBytes; }
+
+private:
+    // The entry of mode, with its graph built on first use.
+    Scene & entry(int mode);
+
+    // Creates the next object of mode.
+    void loadObject(int mode, Scene & scene);
+
+    // Releases least recently used modes other than the active one while over budget.
+    void evict();
+
+    // Resident sizes above, updated as objects are created, remeasured or released.
+    void setBytes(Scene & scene, std::size_t bytes);
+
+    const SceneFile & sceneFile;
+    std::size_t budgetBytes;
+    float level;
+    ObjectFactory factory;
+
+    std::map<int, Scene> scenes;
+    std::size_t totalBytes {0};
+
+    int activeMode {-1};
+    std::size_t activations {0};
+
+    // How often each (from, to) mode switch happened.
+    std::map<std::pair<int, int>, unsigned> transitions;
+
+    // Modes with shapes streamed in since the last update().
+    std::set<int> streamed;
+};
+
+
+#endif  // SCENERESIDENCY_H
@@ -2,6 +2,7 @@
 #define DOCA_H
 
 #include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 
@@ -9,12 +10,21 @@
 
 
 class Shader;
+struct RenderContext;
 
 
 class docadehedron : public Mesh
 {
 public:
-    docadehedron(Shader* pShader, const std::string& vertexFile, const glm::mat4& model, int shapetype);
+    // pContext, if given, lets the mesh be culled per meshlet once subdivided enough.
+    docadehedron(Shader* pShader, const std::string& vertexFile, const glm::mat4& model, int shapetype, const RenderContext* pContext = nullptr);
+
+    // From vertices made by load(); filledVbo, if given, already holds them.
+    docadehedron(Shader* pShader, std::vector<Vertex> vertices, const glm::mat4& model, int shapetype, const RenderContext* pContext = nullptr, GLuint filledVbo = 0U);
+
+    // Reads vertexFile, computes normals and puts the triangles in meshlet order; no GL calls,
+    // so any thread may call it.
+    static std::vector<Vertex> load(const std::string& vertexFile);
 
     ~docadehedron() noexcept override = default;
 
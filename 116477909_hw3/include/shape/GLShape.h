@@ -3,6 +3,8 @@
 #ifndef GLSHAPE_H
 #define GLSHAPE_H
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 #include <glad/glad.h>
@@ -26,19 +28,73 @@ public:
 
     virtual ~GLShape() noexcept = 0;
 
+    // Replaces the model matrix and refreshes the cached normal matrix.
+    virtual void setModel(const glm::mat4 & newModel);
+
+    // Object-space sphere (center xyz, radius w) enclosing the shape, for culling.
+    // A negative radius means unknown: the shape is never culled.
+    [[nodiscard]] virtual glm::vec4 boundingSphere() const;
+
+    // Radius in pixels the bounding sphere projects to in the frame about to be drawn,
+    // for shapes choosing their own detail. Called before each render(); ignored by default.
+    virtual void setScreenRadius(float pixels);
+
+    [[nodiscard]] Shader * shader() const { return pShader; }
+
 protected:
     GLShape(Shader * pShader, const glm::mat4 & model);
 
     GLShape(GLShape &&) noexcept;
     GLShape & operator=(GLShape &&) noexcept;
 
+    // Size of the data store of buffer; binds GL_ARRAY_BUFFER to query it.
+    static std::size_t bufferBytes(GLuint buffer);
+
+    // Sphere around the bounding box center of the vertex positions (radius -1 if none).
+    template <typename Vertex>
+    static glm::vec4 enclosingSphere(const std::vector<Vertex> & vertices);
+
     Shader * pShader {nullptr};
 
     GLuint vao {0U};
     GLuint vbo {0U};
 
     glm::mat4 model {glm::mat4(1.0f)};
+
+    // transpose(inverse(mat3(model))), computed once per model change
+    // instead of once per vertex in the shaders.
+    glm::mat3 normalMatrix {glm::mat3(1.0f)};
 };
 
 
+template <typename Vertex>
+glm::vec4 GLShape::enclosingSphere(const std::vector<Vertex> & vertices)
+{
+    if (vertices.empty())
+    {
+        return {0.0f, 0.0f, 0.0f, -1.0f};
+    }
+
+    glm::vec3 lower = vertices.front().position;
+    glm::vec3 upper = lower;
+
+    for (const Vertex & v : vertices)
+    {
+        lower = glm::min(lower, v.position);
+        upper = glm::max(upper, v.position);
+    }
+
+    glm::vec3 center = 0.5f * (lower + upper);
+    float radiusSquared = 0.0f;
+
+    for (const Vertex & v : vertices)
+    {
+        glm::vec3 d = v.position - center;
+        radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+    }
+
+    return {center, std::sqrt(radiusSquared)};
+}
+
+
 #endif  // GLSHAPE_H
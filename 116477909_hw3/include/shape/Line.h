@@ -25,6 +25,10 @@ public:
 
     void render(float timeElapsedSinceLastFrame) override;
 
+    [[nodiscard]] std::size_t gpuBytes() const override;
+
+    [[nodiscard]] glm::vec4 boundingSphere() const override;
+
 private:
     std::vector<Vertex> vertices;
 };
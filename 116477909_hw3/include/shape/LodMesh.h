@@ -0,0 +1,121 @@
+#ifndef LODMESH_H
+#define LODMESH_H
+
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "shape/Mesh.h"
+
+
+class Meshlets;
+struct RenderContext;
+
+
+/// Mesh with a chain of detail levels, coarsest first, all resident in one VBO.
+/// Each frame the coarsest level whose geometric error projects to at most kPixelError
+/// pixels is drawn, scaled by the screen radius the frame hands over (setScreenRadius()).
+/// Switching to a coarser level needs the error to drop well below that (kCoarsenFactor),
+/// so objects sitting at a threshold do not flicker between levels.
+/// With cross-fade on, a level change dithers from the old level to the new over kFadeSeconds.
+/// Levels of at least Meshlets::kMinTriangles triangles are drawn as culled meshlets; their
+/// vertices must be in Meshlets::order() order.
+class LodMesh : public Mesh
+{
+public:
+    struct Level
+    {
+        std::vector<Vertex> vertices;  // triangle list
+        float error {0.0f};            // object-space deviation from the true surface
+    };
+
+    static constexpr float kPixelError {1.0f};
+    static constexpr float kCoarsenFactor {0.5f};
+    static constexpr float kFadeSeconds {0.25f};
+
+    // Puts each level in Meshlets::order() order and uploads them, unless filledVbo already
+    // holds pack(levels) of levels ordered so.
+    LodMesh(
+        Shader * pShader,
+        const RenderContext * pContext,
+        std::vector<Level> levels,
+        const glm::mat4 & model,
+        GLuint filledVbo = 0U
+    );
+
+    ~LodMesh() noexcept override;
+
+    void render(float timeElapsedSinceLastFrame) override;
+
+    void setScreenRadius(float pixels) override;
+
+    void setCrossFade(bool enabled);
+
+    // Error budget in pixels, kPixelError unless changed; lower values draw finer levels.
+    void setPixelError(float pixels);
+
+    [[nodiscard]] float getPixelError() const { return pixelError; }
+
+    // Around the origin, enclosing every level.
+    [[nodiscard]] glm::vec4 boundingSphere() const override;
+
+    [[nodiscard]] int getLevel() const;
+
+    // The VBO contents uploadLevels() makes of levels: their vertices one level after another.
+    static std::size_t packedBytes(const std::vector<Level> & levels);
+    static void pack(const std::vector<Level> & levels, void * pDestination);
+
+protected:
+    // Used for children building their own levels, e.g., icosahedron
+    LodMesh(Shader * pShader, const RenderContext * pContext, const glm::mat4 & model);
+
+    // Uploads all levels into the VBO, or adopts filledVbo already holding pack(levels);
+    // call after changing levels.
+    void uploadLevels(GLuint filledVbo = 0U);
+
+    // Adds a finer level. Only its vertices are written when the VBO has room; otherwise
+    // everything is uploaded, and a streamed VBO keeps room for one more level grown alike.
+    void appendLevel(Level level);
+
+    std::vector<Level> levels;
+
+private:
+    // Level the view asks for, given the level currently drawn.
+    [[nodiscard]] int selectLevel() const;
+
+    void drawLevel(int level);
+
+    // Respecifies the VBO with every level, keeping room for reserveBytes if streamed.
+    void uploadPacked(std::size_t reserveBytes);
+
+    // Records where the first level not indexed yet lies in the VBO, its meshlets and extent.
+    void indexNextLevel();
+
+    // Start of each level in the VBO, in vertices.
+    std::vector<GLint> firstVertex;
+
+    // Per level, null for levels too small to be worth culling.
+    std::vector<std::unique_ptr<Meshlets>> levelMeshlets;
+
+    // Object-space radius around the origin enclosing every level.
+    float boundingRadius {0.0f};
+
+    // Pixels boundingRadius projects to this frame; negative until the first frame, which
+    // then draws the finest level.
+    float screenRadius {-1.0f};
+
+    float pixelError {kPixelError};
+
+    int currentLevel {-1};
+
+    // Level being faded out, -1 if none.
+    int fadingLevel {-1};
+    float fadeProgress {1.0f};
+    bool crossFade {false};
+
+    Shader::VariantCache fadeVariant;
+};
+
+
+#endif  // LODMESH_H
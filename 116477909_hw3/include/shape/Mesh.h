@@ -1,17 +1,31 @@
 #ifndef MESH_H
 #define MESH_H
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 #include <glm/glm.hpp>
 
 #include "shape/GLShape.h"
+#include "util/DynamicBuffer.h"
+#include "util/Shader.h"
 
 
-class Shader;
+class Meshlets;
+struct RenderContext;
 
 
 /// Generic triangular mesh object.
+/// Given a RenderContext, meshes of at least Meshlets::kMinTriangles triangles are split into
+/// meshlets and only the ones that can be visible are drawn each frame. Vertices handed over
+/// in an already filled VBO must be in Meshlets::order() order.
+/// With VertexFormat::kCompressed the VBO holds CompressedVertex data (decoded in mesh.vert.glsl)
+/// plus 8-bit colors, or no colors at all when every vertex has the same one. The VBO is then
+/// the only copy of the vertices: the CPU one is dropped once uploaded, so compressed meshes
+/// can be redrawn and moved but not edited.
+/// Deforming meshes mark their vertex buffer streamed and change vertices through
+/// updateVertices(); only the changed ranges are uploaded, at the next render().
 class Mesh : public Renderable, public GLShape
 {
 public:
@@ -24,21 +38,123 @@ public:
         glm::vec3 color {1.0f, 1.0f, 1.0f};
     };
 
+    enum class VertexFormat
+    {
+        kFull,
+        kCompressed,
+    };
+
+    // 12 bytes against the 36 of Vertex.
+    struct CompressedVertex
+    {
+        std::uint16_t position[4];  // xyz normalized to the mesh bounding box, w unused
+        std::int16_t normal[2];     // octahedral encoding, snorm
+    };
+
+    // What the VBO of a compressed mesh holds and what decoding it takes.
+    struct CompressedVertices
+    {
+        // CompressedVertex per vertex, then RGBA8 colors unless uniformColor.
+        std::vector<std::uint8_t> bytes;
+        std::size_t count {0};
+
+        // position = positionOffset + aPosition * positionScale.
+        glm::vec3 positionOffset {0.0f};
+        glm::vec3 positionScale {1.0f};
+
+        // Per-draw color instead of the color attribute.
+        bool uniformColor {false};
+        glm::vec3 materialColor {1.0f};
+    };
+
     Mesh(
         Shader * pShader,
         const std::vector<Vertex> & vertices,
-        const glm::mat4 & model
+        const glm::mat4 & model,
+        const RenderContext * pContext = nullptr,
+        VertexFormat format = VertexFormat::kFull
     );
 
-    ~Mesh() noexcept override = default;
+    ~Mesh() noexcept override;
 
     void render(float timeElapsedSinceLastFrame) override;
 
+    [[nodiscard]] std::size_t gpuBytes() const override;
+
+    [[nodiscard]] glm::vec4 boundingSphere() const override;
+
+    // Whether the vertices change often; takes effect when the VBO is next respecified.
+    void setBufferUsage(DynamicBuffer::Usage usage);
+
+    // Replaces every vertex; the count may change.
+    void setVertices(std::vector<Vertex> newVertices);
+
+    // Overwrites the vertices from first on with replacement. Only full-format meshes not
+    // split into meshlets (whose bounds would go stale) can be updated in part.
+    void updateVertices(std::size_t first, const std::vector<Vertex> & replacement);
+
+    // Packs vertices for a kCompressed VBO; no GL calls, so any thread may call it.
+    static CompressedVertices compress(const std::vector<Vertex> & vertices);
+
+    // Sets up the Vertex attributes (locations 0-2) for the bound VAO and VBO.
+    static void configureVertexAttributes();
+
+    // Sets up CompressedVertex attributes (locations 0-1) for the bound VAO and VBO, and the
+    // 8-bit color attribute (location 2) stored after vertexCount of them unless colored is false.
+    static void configureCompressedVertexAttributes(GLsizei vertexCount, bool colored);
+
 protected:
     // Used for children inheriting this class, e.g., Tetrahedron
-    Mesh(Shader * shader, const glm::mat4 & model);
+    Mesh(Shader * shader, const glm::mat4 & model, const RenderContext * pContext = nullptr);
+
+    // Replaces the VBO with buffer, which already holds Vertex data (e.g. filled by
+    // BufferUploader on its own context), and points the VAO at it.
+    void adoptVertexBuffer(GLuint buffer);
+
+    // Respecifies the VBO from vertices, in the mesh's vertex format.
+    void uploadVertices();
+
+    // Switches to kCompressed with packed as the VBO contents: adopts filledVbo if given,
+    // which already holds packed.bytes, else uploads them. Call after buildMeshlets(),
+    // since the CPU vertices are dropped.
+    void useCompressedVertices(CompressedVertices packed, GLuint filledVbo = 0U);
+
+    // Splits vertices, in Meshlets::order() order, into meshlets if there is a context and
+    // they are enough to be worth it; drops the old ones either way.
+    void buildMeshlets();
+
+    // Draws the meshlets that survive culling against the current view.
+    void drawMeshlets(Meshlets & meshlets);
 
     std::vector<Vertex> vertices;
+
+    // Tracks the VBO; static unless setBufferUsage() says otherwise.
+    DynamicBuffer vertexBuffer {GL_ARRAY_BUFFER, DynamicBuffer::Usage::kStatic};
+
+    const RenderContext * pContext {nullptr};
+
+    // The generic variant of pShader, kept by render().
+    Shader::VariantCache plainVariant;
+
+private:
+    std::unique_ptr<Meshlets> pMeshlets;
+
+    // Holds the culled draw commands when glMultiDrawArraysIndirect is available, created
+    // on the first meshlet draw; rewritten every frame, so streamed.
+    GLuint indirectBuffer {0U};
+    DynamicBuffer indirectCommands {GL_DRAW_INDIRECT_BUFFER, DynamicBuffer::Usage::kStreamed};
+
+    // The culled commands as glMultiDrawArrays arguments otherwise, kept across frames.
+    std::vector<GLint> meshletFirst;
+    std::vector<GLsizei> meshletCount;
+
+    VertexFormat vertexFormat {VertexFormat::kFull};
+
+    // Layout of a compressed VBO, without its bytes, and the bounds of the dropped vertices.
+    CompressedVertices compressedLayout;
+    glm::vec4 compressedBounds {0.0f, 0.0f, 0.0f, -1.0f};
+
+    Shader::VariantCache compressedVariant;
 };
 
 
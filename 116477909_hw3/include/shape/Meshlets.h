@@ -0,0 +1,76 @@
+#ifndef MESHLETS_H
+#define MESHLETS_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shape/Mesh.h"
+
+
+/// Splits a large triangle list into meshlets: runs of at most kMaxTriangles spatially
+/// close triangles, each with a bounding sphere and a normal cone. Every frame the
+/// meshlets outside the view frustum or facing entirely away from the eye are culled and
+/// the rest are emitted as a compacted list of indirect draw commands.
+/// Bounds live in structure-of-arrays form so the culling loop runs four meshlets per SSE step.
+class Meshlets
+{
+public:
+    // Layout fixed by glMultiDrawArraysIndirect.
+    struct DrawCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint first;
+        GLuint baseInstance;
+    };
+
+    static constexpr std::size_t kMaxTriangles {124};
+
+    // Meshes with fewer triangles are cheaper to draw whole than to cull.
+    static constexpr std::size_t kMinTriangles {4096};
+
+    // Reorders the triangles of worthwhile() meshes in place so consecutive runs of
+    // kMaxTriangles are spatially compact; call before uploading them. No GL calls.
+    static void order(std::vector<Mesh::Vertex> & vertices);
+
+    [[nodiscard]] static bool worthwhile(std::size_t vertexCount);
+
+    // Meshlets of vertices in order() order, which start at baseVertex in the VBO.
+    // Normal cones need closed surfaces wound counter-clockwise from outside; for other
+    // meshes only the frustum culls.
+    explicit Meshlets(const std::vector<Mesh::Vertex> & vertices, GLuint baseVertex = 0U);
+
+    // Draw commands for the visible meshlets, adjacent ones merged into one command.
+    // modelViewProjection maps object space to clip space; eye is the camera in object space.
+    // The list is reused by the next call.
+    const std::vector<DrawCommand> & cull(const glm::mat4 & modelViewProjection, const glm::vec3 & eye);
+
+    [[nodiscard]] std::size_t size() const;
+
+private:
+    void setVisible(std::size_t meshlet);
+
+    // Bounding spheres.
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> radius;
+
+    // Normal cones: unit axis and sine of the half-angle; a cutoff of 1 never culls.
+    std::vector<float> axisX;
+    std::vector<float> axisY;
+    std::vector<float> axisZ;
+    std::vector<float> cutoff;
+
+    // Vertex range of each meshlet.
+    std::vector<GLuint> firstVertex;
+    std::vector<GLuint> vertexCount;
+
+    std::vector<DrawCommand> commands;
+};
+
+
+#endif  // MESHLETS_H
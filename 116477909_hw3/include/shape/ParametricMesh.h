@@ -0,0 +1,89 @@
+#ifndef PARAMETRICMESH_H
+#define PARAMETRICMESH_H
+
+#include <map>
+#include <memory>
+#include <tuple>
+
+#include <glm/glm.hpp>
+
+#include "shape/GLShape.h"
+#include "shape/ParametricSurface.h"
+#include "util/Shader.h"
+
+
+
+/// CPU-tessellated counterpart of Sphere: the same parametric surfaces, baked once into
+/// indexed triangle buffers and drawn with the mesh shader. Used where the tessellation
+/// stages are missing or slow (software rasterizers), see App::useCpuTessellation.
+/// Baked buffers are shared between all shapes with the same (shapeType, radius, minorradius, level).
+class ParametricMesh : public Renderable, public GLShape
+{
+public:
+    ParametricMesh(
+        Shader * pShader,
+        const glm::vec3 & center,
+        float radius,
+        const glm::vec3 & color,
+        const glm::mat4 & model,
+        int shapetype,
+        float level,
+        float minorradius = 0.5f
+    );
+
+    ~ParametricMesh() noexcept override = default;
+
+    void render(float timeElapsedSinceLastFrame) override;
+
+    [[nodiscard]] std::size_t gpuBytes() const override;
+
+    [[nodiscard]] glm::vec4 boundingSphere() const override;
+
+    // model as passed to the constructor; the shape stays at center within it.
+    void setModel(const glm::mat4 & newModel) override;
+
+    // Re-bakes (or fetches from the cache) the surface for a new tessLevelOuter.
+    void setLevel(float level);
+
+    // Segments per parameter direction the GPU path produces for tessLevelOuter = level
+    // with the default Sphere patch grid, so both paths show the same facets.
+    static int segmentsForLevel(float level);
+
+private:
+    // Shared vertex and index buffers of one baked surface.
+    struct Geometry
+    {
+        Geometry() = default;
+        Geometry(const Geometry &) = delete;
+        Geometry & operator=(const Geometry &) = delete;
+        ~Geometry() noexcept;
+
+        GLuint vbo {0U};
+        GLuint ebo {0U};
+        GLsizei indexCount {0};
+    };
+
+    // (shapeType, radius, minorradius, segments)
+    using Key = std::tuple<int, float, float, int>;
+
+    static std::shared_ptr<const Geometry> acquire(const Key & key);
+    static std::shared_ptr<const Geometry> bake(const Key & key);
+
+    // Entries expire with the last shape using them, e.g. after "+" raises the level.
+    inline static std::map<Key, std::weak_ptr<const Geometry>> cache;
+
+    glm::vec3 center {0.0f};
+    glm::vec3 color {1.0f, 0.5f, 0.31f};
+    int shapetype {ParametricSurface::kSphere};
+    float radius {1.0f};
+    float minorradius {0.5f};
+    int segments {0};
+
+    // GLShape's vbo stays empty; the VAO points into the shared geometry instead.
+    std::shared_ptr<const Geometry> pGeometry;
+
+    Shader::VariantCache variantCache;
+};
+
+
+#endif  // PARAMETRICMESH_H
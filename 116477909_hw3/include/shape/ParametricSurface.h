@@ -0,0 +1,58 @@
+#ifndef PARAMETRICSURFACE_H
+#define PARAMETRICSURFACE_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+
+/// CPU mirror of the parametric surfaces evaluated in sphere.tese.glsl,
+/// so the application can reason about (and bake) the shapes the GPU tessellates.
+/// Keep the two in sync.
+struct ParametricSurface
+{
+    enum ShapeType : int
+    {
+        kSphere = 0,
+        kCylinder = 1,
+        kCone = 2,
+        kTorus = 3,
+        kSuperQuadric = 4,
+        kPentagon = 5
+    };
+
+    // Position at parameters (u, v) in [0, 1]^2, in object space.
+    [[nodiscard]] glm::vec3 evaluate(float u, float v) const;
+
+    // Shading normal the tessellation evaluation shader uses (radial from center).
+    [[nodiscard]] glm::vec3 normal(const glm::vec3 & position) const;
+
+    // Radius of a sphere around center enclosing the whole surface.
+    [[nodiscard]] float boundingRadius() const;
+
+    // Whether v = 1 is the same curve as v = 0 (u always wraps around).
+    [[nodiscard]] bool wrapsV() const;
+
+    // Structure-of-arrays grid of surface points, row-major in v.
+    struct Grid
+    {
+        int columns {0};  // samples along u, at u = i / columns (u = 1 is column 0 again)
+        int rows {0};     // samples along v, at v = j / segmentsV; segmentsV + 1 rows unless v wraps
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+    };
+
+    // Evaluates the surface on a segmentsU x segmentsV grid. Every shape is a ring in u
+    // scaled and offset by a profile in v, so the trigonometry is tabulated per row and column
+    // and the per-point work is a vectorizable multiply-add over contiguous floats.
+    [[nodiscard]] Grid evaluateGrid(int segmentsU, int segmentsV) const;
+
+    int shapeType {kSphere};
+    glm::vec3 center {0.0f, 0.0f, 0.0f};
+    float radius {1.0f};
+    float minorradius {0.5f};
+};
+
+
+#endif  // PARAMETRICSURFACE_H
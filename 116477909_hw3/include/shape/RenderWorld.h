@@ -0,0 +1,130 @@
+#ifndef RENDERWORLD_H
+#define RENDERWORLD_H
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "util/RenderContext.h"
+
+
+class GLShape;
+class Renderable;
+class Shader;
+
+
+/// Data-oriented store of the per-object state the frame loop touches.
+///
+/// Each entity has a transform, a world-space bounding sphere, a mesh handle (the shape
+/// object that owns the GL buffers and issues the draw), a material (its shader) and
+/// flags, each kept in a dense array indexed alike, so the systems below run over contiguous
+/// memory instead of chasing one heap object per shape. Entity ids map to dense slots through
+/// a sparse table; destroying an entity moves the last one into its slot.
+///
+/// The systems are const and write their results to a Frame, so one frame can be prepared
+/// on a worker thread while another is drawn, as long as the world is not modified meanwhile.
+///
+/// Shapes such as Mesh or Sphere stay the facades the application builds: the world only
+/// references them, and setTransform() keeps their model matrix in step.
+class RenderWorld
+{
+public:
+    // Low 24 bits slot, high 8 bits generation, so stale ids of reused slots are told apart.
+    using Entity = std::uint32_t;
+
+    static constexpr Entity kNull {~0U};
+
+    enum Flags : std::uint8_t
+    {
+        kHidden = 1U << 0U,     // never drawn
+        kUnbounded = 1U << 1U,  // no bounds, never culled
+    };
+
+    // What the systems computed for one view, by dense index.
+    struct Frame
+    {
+        RenderContext context;
+        std::vector<std::uint8_t> visible;
+        std::vector<float> screenRadii;
+        std::vector<std::uint32_t> drawOrder;
+        std::vector<Renderable *> drawList;
+
+        // Per drawList entry: its shape (null if none) and screenRadii entry, which the
+        // shape is handed before drawing so it need not project its bounds again.
+        std::vector<GLShape *> drawShapes;
+        std::vector<float> drawRadii;
+    };
+
+    // Objects projecting to a smaller radius, in pixels, are not drawn.
+    static constexpr float kMinScreenRadius {0.5f};
+
+    // pShape may be null for renderables without one; they are never culled.
+    Entity create(Renderable * pRenderable, GLShape * pShape, const glm::mat4 & model);
+
+    void destroy(Entity entity);
+
+    void clear();
+
+    [[nodiscard]] bool alive(Entity entity) const;
+
+    [[nodiscard]] std::size_t size() const { return entities.size(); }
+
+    // Moves the entity and its shape.
+    void setTransform(Entity entity, const glm::mat4 & model);
+
+    // Rereads the shape's bounding sphere and shader, e.g. after its geometry changed.
+    void refreshBounds(Entity entity);
+
+    void setHidden(Entity entity, bool hidden);
+
+    [[nodiscard]] bool visible(const Frame & frame, Entity entity) const;
+
+    // Projected radius in pixels, at the depth of the bounding sphere's nearest point.
+    [[nodiscard]] float screenRadius(const Frame & frame, Entity entity) const;
+
+    // Runs the systems below in order for context, reusing frame's storage.
+    void prepare(const RenderContext & context, Frame & frame) const;
+
+    // Frustum test of every bounding sphere against frame.context.
+    void cull(Frame & frame) const;
+
+    // Projected size of every visible entity; drops those below kMinScreenRadius.
+    void selectLod(Frame & frame) const;
+
+    // Visible mesh handles grouped by material, so consecutive draws share a program.
+    void buildDrawList(Frame & frame) const;
+
+private:
+    static constexpr std::uint32_t kSlotBits {24U};
+    static constexpr std::uint32_t kSlotMask {(1U << kSlotBits) - 1U};
+
+    // Entities per job of cull() and selectLod(); smaller worlds stay on one thread.
+    static constexpr std::size_t kGrain {1024};
+
+    [[nodiscard]] std::uint32_t denseIndex(Entity entity) const;
+
+    // Updates the world bounds of dense slot i from its transform and local bounds.
+    void updateBounds(std::size_t i);
+
+    // Dense components.
+    std::vector<Entity> entities;
+    std::vector<glm::mat4> transforms;
+    std::vector<glm::vec4> localBounds;
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> radii;
+    std::vector<Renderable *> meshes;
+    std::vector<GLShape *> shapes;
+    std::vector<const Shader *> materials;
+    std::vector<std::uint8_t> flags;
+
+    // Sparse table, by entity slot.
+    std::vector<std::uint32_t> denseOf;
+    std::vector<std::uint8_t> generations;
+    std::vector<std::uint32_t> freeSlots;
+};
+
+
+#endif  // RENDERWORLD_H
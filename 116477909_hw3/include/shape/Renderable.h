@@ -3,6 +3,8 @@
 #ifndef RENDERABLE_H
 #define RENDERABLE_H
 
+#include <cstddef>
+
 
 /// Abstract class (interface) representing an object-to-render.
 /// All shapes should public-inherit this class.
@@ -15,6 +17,10 @@ public:
     virtual ~Renderable() noexcept = 0;
 
     virtual void render(float timeElapsedSinceLastFrame) = 0;
+
+    // Bytes of GPU buffer storage the object keeps alive (0 unless overridden).
+    // Buffers shared between objects count for each of them.
+    [[nodiscard]] virtual std::size_t gpuBytes() const;
 };
 
 
@@ -1,17 +1,34 @@
 #ifndef SPHERE_H
 #define SPHERE_H
 
+#include <vector>
+
 #include <glm/glm.hpp>
 
 #include "shape/GLShape.h"
+#include "shape/ParametricSurface.h"
+#include "util/Shader.h"
 
 
-class Shader;
-
 
+/// Parametric shape (sphere, cylinder, cone, torus, superquadric) tessellated on the GPU.
+/// The (u, v) parameter domain is split into a grid of quad patches, each tessellated
+/// (and frustum-culled) independently by sphere.tesc.glsl, so detail is not capped
+/// at GL_MAX_TESS_GEN_LEVEL for the whole shape.
 class Sphere : public Renderable, public GLShape
 {
 public:
+    // One patch corner. Corners are emitted 4 per patch: (u0, v0), (u1, v0), (u1, v1), (u0, v1).
+    struct PatchVertex
+    {
+        glm::vec3 position;  // surface point at this corner, object space
+        glm::vec2 uv;        // parameters of this corner
+        glm::vec4 bound;     // bounding sphere of the whole patch (xyz center, w radius), object space
+    };
+
+    static constexpr int kDefaultPatchesU {8};
+    static constexpr int kDefaultPatchesV {8};
+
     Sphere(
         Shader* pShader,
         const glm::vec3& center,
@@ -26,8 +43,23 @@ public:
 
     void render(float timeElapsedSinceLastFrame) override;
 
-private:
-    static constexpr float kNull {0.0f};
+    [[nodiscard]] std::size_t gpuBytes() const override;
+
+    [[nodiscard]] glm::vec4 boundingSphere() const override;
+
+    // Re-splits the parameter domain into patchesU x patchesV patches.
+    void setPatchGrid(int patchesU, int patchesV);
+
+    // Object-space radius of a sphere around center that encloses the shape.
+    [[nodiscard]] float boundingRadius() const;
+
+    [[nodiscard]] ParametricSurface surface() const;
+
+    // Patch corners for the given grid (4 per patch), shared with the batched renderer.
+    static std::vector<PatchVertex> buildPatches(const ParametricSurface & surface, int patchesU, int patchesV);
+
+    // Sets up the PatchVertex attributes (locations 0-2) for the bound VAO and VBO.
+    static void configurePatchAttributes();
 
 private:
     glm::vec3 center {0.0f, 0.0f, 0.0f};
@@ -35,6 +67,10 @@ private:
     float minorradius{0.50f};
     glm::vec3 color {1.0f, 0.5f, 0.31f};
     int shapetype;//use sphere class for rendering Other Parametric shapes in Tesselationshaders
+
+    GLsizei patchVertexCount {0};
+
+    Shader::VariantCache variantCache;
 };
 
 
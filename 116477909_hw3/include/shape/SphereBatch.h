@@ -0,0 +1,82 @@
+#ifndef SPHEREBATCH_H
+#define SPHEREBATCH_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "shape/GLShape.h"
+#include "shape/ParametricSurface.h"
+#include "util/Shader.h"
+
+
+
+/// Many parametric shapes sharing one model matrix, drawn with one instanced patch draw
+/// per shape type instead of one Sphere (uniform updates plus a draw) each.
+/// The per-shape parameters live in a per-instance attribute buffer that the
+/// tessellation stages read per patch (sphere.*.glsl compiled with SPHERE_BATCH).
+class SphereBatch : public Renderable, public GLShape
+{
+public:
+    // Per-instance attributes (divisor 1), locations 3-5.
+    struct Instance
+    {
+        glm::vec4 centerRadius;      // center xyz, radius
+        glm::vec4 colorMinorRadius;  // color rgb, minorradius
+        float boundingRadius;        // around center, for culling and level selection
+    };
+
+    // Instances are usually small on screen; fewer patches keep the per-instance cost low.
+    static constexpr int kDefaultPatchesU {2};
+    static constexpr int kDefaultPatchesV {2};
+
+    SphereBatch(Shader * pShader, const glm::mat4 & model);
+
+    ~SphereBatch() noexcept override;
+
+    void render(float timeElapsedSinceLastFrame) override;
+
+    [[nodiscard]] std::size_t gpuBytes() const override;
+
+    [[nodiscard]] glm::vec4 boundingSphere() const override;
+
+    // Shape types 0-4 (sphere to superquadric); the pentagon needs its own control points.
+    void add(
+        const glm::vec3 & center,
+        float radius,
+        const glm::vec3 & color,
+        int shapetype = ParametricSurface::kSphere,
+        float minorradius = 0.5f
+    );
+
+    void clear();
+
+    [[nodiscard]] std::size_t size() const;
+
+    // Re-splits every instance's parameter domain into patchesU x patchesV patches.
+    void setPatchGrid(int patchesU, int patchesV);
+
+private:
+    static constexpr int kShapeTypes {ParametricSurface::kSuperQuadric + 1};
+
+    // Points the instance attributes at byte offset in instanceVbo (bound).
+    static void configureInstanceAttributes(std::size_t offset);
+
+    // Copies the instances, grouped by shape type, into instanceVbo.
+    void upload();
+
+    // Grouped by shape type so each group draws with its own SHAPE_TYPE variant.
+    std::array<std::vector<Instance>, kShapeTypes> instances;
+    bool instancesDirty {false};
+
+    GLuint instanceVbo {0U};
+    GLsizei patchVertexCount {0};
+
+    // Per shape type, like instances.
+    std::array<Shader::VariantCache, kShapeTypes> variantCaches;
+};
+
+
+#endif  // SPHEREBATCH_H
@@ -0,0 +1,55 @@
+#ifndef STREAMEDMESH_H
+#define STREAMEDMESH_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "shape/Mesh.h"
+
+
+class Shader;
+
+
+/// Stands in for a shape whose data is still being loaded (see AssetStreamer).
+/// Draws placeholder vertices at its model until setLoaded() hands over the real shape;
+/// from then on it draws, bounds and moves that shape instead.
+class StreamedMesh : public Mesh
+{
+public:
+    StreamedMesh(Shader * pShader, const std::vector<Vertex> & placeholder, const glm::mat4 & model);
+
+    ~StreamedMesh() noexcept override = default;
+
+    void render(float timeElapsedSinceLastFrame) override;
+
+    [[nodiscard]] std::size_t gpuBytes() const override;
+
+    [[nodiscard]] glm::vec4 boundingSphere() const override;
+
+    void setModel(const glm::mat4 & newModel) override;
+
+    void setScreenRadius(float pixels) override;
+
+    // Takes over pShape, placed at this model, then calls onLoaded.
+    void setLoaded(std::unique_ptr<Renderable> pShape);
+
+    // The real shape, or null while loading.
+    [[nodiscard]] Renderable * loaded() const { return pLoaded.get(); }
+
+    // Expires with this object, so results arriving after it is gone can be dropped.
+    [[nodiscard]] std::weak_ptr<void> lifetime() const { return alive; }
+
+    std::function<void()> onLoaded;
+
+private:
+    std::unique_ptr<Renderable> pLoaded;
+    GLShape * pLoadedShape {nullptr};
+
+    std::shared_ptr<void> alive {std::make_shared<char>()};
+};
+
+
+#endif  // STREAMEDMESH_H
@@ -2,6 +2,7 @@
 #define TETRAHEDRON_H
 
 #include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 
@@ -9,12 +10,43 @@
 
 
 class Shader;
+struct RenderContext;
 
 
 class Tetrahedron : public Mesh
 {
 public:
-    Tetrahedron(Shader * pShader, const std::string & vertexFile, const glm::mat4 & model);
+    // pContext, if given, lets large meshes be culled per meshlet.
+    Tetrahedron(
+        Shader * pShader,
+        const std::string & vertexFile,
+        const glm::mat4 & model,
+        const RenderContext * pContext = nullptr
+    );
+
+    // From vertices made by load(); filledVbo, if given, already holds them.
+    Tetrahedron(
+        Shader * pShader,
+        std::vector<Vertex> vertices,
+        const glm::mat4 & model,
+        const RenderContext * pContext = nullptr,
+        GLuint filledVbo = 0U
+    );
+
+    // From vertices made by load(), stored as packed, which is compress(vertices); filledVbo,
+    // if given, already holds packed.bytes. The vertices only serve to build meshlets.
+    Tetrahedron(
+        Shader * pShader,
+        std::vector<Vertex> vertices,
+        CompressedVertices packed,
+        const glm::mat4 & model,
+        const RenderContext * pContext = nullptr,
+        GLuint filledVbo = 0U
+    );
+
+    // Reads vertexFile, computes normals and puts the triangles in meshlet order; no GL calls,
+    // so any thread may call it.
+    static std::vector<Vertex> load(const std::string & vertexFile);
 
     ~Tetrahedron() noexcept override = default;
 
@@ -2,22 +2,52 @@
 #define icosahedron_h
 
 #include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 
-#include "shape/Mesh.h"
+#include "shape/LodMesh.h"
 
 
 class Shader;
+struct RenderContext;
 
 
-class icosahedron : public Mesh
+/// Geodesic sphere: an icosahedron loaded from file, refined by subdivision.
+/// The subdivision levels form its LOD chain, so distant ones stay coarse.
+class icosahedron : public LodMesh
 {
 public:
-    icosahedron(Shader* pShader, const std::string& vertexFile, const glm::mat4& model, glm::vec3 scale = glm::vec3(1.0f));
+    // Levels built up front; "+" (subDivide) appends finer ones.
+    static constexpr int kDefaultSubdivisions {4};
+
+    icosahedron(
+        Shader* pShader,
+        const RenderContext* pContext,
+        const std::string& vertexFile,
+        const glm::mat4& model,
+        glm::vec3 scale = glm::vec3(1.0f)
+    );
+
+    // From levels made by load() with the same scale; filledVbo, if given, already holds
+    // LodMesh::pack(levels).
+    icosahedron(
+        Shader* pShader,
+        const RenderContext* pContext,
+        std::vector<Level> levels,
+        const glm::mat4& model,
+        glm::vec3 scale = glm::vec3(1.0f),
+        GLuint filledVbo = 0U
+    );
+
+    // Reads vertexFile and builds the first kDefaultSubdivisions levels; no GL calls,
+    // so any thread may call it.
+    static std::vector<Level> load(const std::string& vertexFile, glm::vec3 scale = glm::vec3(1.0f));
 
     ~icosahedron() noexcept override = default;
 
+    // Appends one more subdivision of the finest level to the LOD chain and lowers the pixel
+    // error budget by the same factor as the error, so views draw one level finer.
     void subDivide();
 
     void render(float timeElapsedSinceLastFrame) override;
@@ -25,6 +55,9 @@ public:
     void ConfigurePipeline();
 
 private:
+    // Largest distance between a triangle's flat center and the surface above it.
+    static float sphericalError(const std::vector<Vertex> & triangles);
+
     static constexpr glm::vec3 kColor{ 0.31f, 0.5f, 1.0f };
     glm::vec3 Scale;
 };
@@ -3,13 +3,19 @@
 #ifndef CAMERA_H
 #define CAMERA_H
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <optional>
 #include <vector>
 #include <string>
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
+#include "util/CameraPath.h"
+
 
 class Camera
 {
@@ -216,6 +222,8 @@ private:
 };
 
 
+/// Plays a camera along keyframes: a CameraPath through them, by default at constant speed
+/// over the total duration; setConstantSpeed(false) reaches each keyframe at its own time.
 class KeyFrameCamera
 {
     struct KeyFrame
@@ -225,55 +233,49 @@ class KeyFrameCamera
         float Time_from_start;
     };
 
-    float Convert_time_to_T()
+    // Fraction of the segment begin_frame_index that current_elapsed_Time has passed.
+    // The index follows playback one key at a time; after a jump it is found by binary search.
+    float Convert_time_to_T(float current_elapsed_Time)
     {
-        begin_frame_index = 0;
-        float current_elapsed_Time = KeyFrameCamera_timer.elapsed();
-        KeyFrame var2;
+        const std::size_t last = Frames.size() - 1;
 
-        for (KeyFrame var : Frames)
-        {
-            if (!(begin_frame_index + 1 >= Frames.size()))
-            {
-                var2 = Frames[begin_frame_index + 1];
-            }
-            else
-            {
-                is_at_last = true;
-                continue;
-            }
-
-            if (current_elapsed_Time > var.Time_from_start && current_elapsed_Time < var2.Time_from_start)
-            {
-                break;
-            }
+        is_at_last = last == 0 || Frames[last].Time_from_start <= current_elapsed_Time;
 
-            begin_frame_index++;
+        if (is_at_last)
+        {
+            return 1.0f;
         }
 
+        bool behind = current_elapsed_Time < Frames[begin_frame_index].Time_from_start;
+        bool farAhead = begin_frame_index + 2 <= last && Frames[begin_frame_index + 2].Time_from_start <= current_elapsed_Time;
 
-        if (!is_at_last)
+        if (behind || farAhead)
         {
-            //amount of time between current keyFrames
-            float Time_frame = Frames[begin_frame_index + 1].Time_from_start - Frames[begin_frame_index].Time_from_start;
-
-            //difference between elapsed time and first frame;
-            float time_difference = current_elapsed_Time - Frames[begin_frame_index].Time_from_start;
-
-            //value between 0 and 1 thats used to calculate interpolation
-            float T = time_difference / Time_frame;
-            return T;
+            auto next = std::upper_bound(Frames.begin(), Frames.end(), current_elapsed_Time,
+                                         [](float time, const KeyFrame & frame) { return time < frame.Time_from_start; });
+            begin_frame_index = next == Frames.begin() ? 0 : static_cast<std::size_t>(next - Frames.begin()) - 1;
         }
-
-        else
+        else if (Frames[begin_frame_index + 1].Time_from_start <= current_elapsed_Time)
         {
-            return 1.0f;
+            ++begin_frame_index;
         }
+
+        //amount of time between current keyFrames
+        float Time_frame = Frames[begin_frame_index + 1].Time_from_start - Frames[begin_frame_index].Time_from_start;
+
+        //difference between elapsed time and first frame;
+        float time_difference = current_elapsed_Time - Frames[begin_frame_index].Time_from_start;
+
+        //value between 0 and 1 thats used to calculate interpolation
+        return 0.0f < Time_frame ? glm::clamp(time_difference / Time_frame, 0.0f, 1.0f) : 1.0f;
     }
 
 public:
+    // Seconds on a steady timeline; only differences between calls matter.
+    using Clock = std::function<double()>;
+
     KeyFrameCamera(glm::vec3 start_pos, glm::quat start_rot)
-        :lerped_position(start_pos), slerped_rotation(start_rot)
+        :lerped_position(start_pos), slerped_rotation(start_rot), View(viewOf(start_pos, start_rot))
     {
         KeyFrame Instance;
         Instance.Time_from_start = 0;
@@ -304,6 +306,29 @@ public:
         Instance.K_rotation = K_rotation;
 
         Frames.push_back(Instance);
+
+        // The spline changes with every key; refitted on the next start or interpolation.
+        Path.reset();
+    }
+
+    void setConstantSpeed(bool constant)
+    {
+        constantSpeed = constant;
+    }
+
+    // Replaces the wall clock, e.g. by frame count times a fixed step for reproducible replays.
+    // Takes effect at the next startKeyFrameCamera().
+    void setClock(Clock clock)
+    {
+        Now = std::move(clock);
+    }
+
+    // Evaluates the path at the clock's time. GetView() and GetlerpedPosition() return what
+    // the last call found, so call it once per frame.
+    void update()
+    {
+        InterPolate();
+        View = viewOf(lerped_position, slerped_rotation);
     }
 
     void InterPolate()
@@ -312,21 +337,28 @@ public:
 
         if (isAnimating)
         {
+            fitPath();
 
+            CameraPath::Pose pose;
+            float elapsed = static_cast<float>(Now() - Start_time);
 
-            T = this->Convert_time_to_T();
-
-
-
+            if (constantSpeed)
+            {
+                float duration = Frames.back().Time_from_start;
 
-            if (!is_at_last)
+                is_at_last = duration <= elapsed;
+                pose = Path->atFraction(0.0f < duration ? elapsed / duration : 1.0f);
+            }
+            else
             {
-                //interpolates the position;
-                this->lerped_position = glm::mix(Frames[begin_frame_index].k_Position, Frames[begin_frame_index + 1].k_Position, T);
+                T = this->Convert_time_to_T(elapsed);
 
-                //interpolates the Rotation
-                this->slerped_rotation = glm::slerp(Frames[begin_frame_index].K_rotation, Frames[begin_frame_index + 1].K_rotation, T);
+                pose = is_at_last ? Path->atFraction(1.0f) : Path->atSegmentFraction(begin_frame_index, T);
             }
+
+            //the spline's position and rotation
+            this->lerped_position = pose.position;
+            this->slerped_rotation = pose.rotation;
         }
     }
 
@@ -344,47 +376,81 @@ public:
 
     void startKeyFrameCamera()
     {
-        KeyFrameCamera_timer.reset();
+        fitPath();
+
+        Start_time = Now();
         isAnimating = true;
+        is_at_last = false;
+        begin_frame_index = 0;
     }
 
     glm::mat4 GetBias()
     {
         return Bias;
     }
-    glm::mat4 GetView()
+
+    // The view at the last update().
+    const glm::mat4 & GetView() const
     {
-        glm::mat4 Model;
+        return View;
+    }
 
-        {
-            InterPolate();
-            //glm::mat4 Model =  glm::translate(glm::mat4(1.0f), lerped_position) * glm::translate(glm::mat4(1.0f), -1.0f * V_pos) * glm::mat4(slerped_rotation) * glm::translate(glm::mat4(1.0f), -1.0f * V_pos);
-            Model = glm::translate(glm::mat4(1.0f), lerped_position) * glm::mat4(slerped_rotation);
+    glm::vec3 GetlerpedPosition() const
+    {
+        return lerped_position;
+    }
 
-            //inverse it For Camera 
-            Model = glm::inverse(Model);
+private:
+    void fitPath()
+    {
+        if (Path)
+        {
+            return;
         }
 
+        std::vector<CameraPath::Pose> keys;
+        keys.reserve(Frames.size());
+
+        for (const KeyFrame & frame : Frames)
+        {
+            keys.push_back({frame.k_Position, frame.K_rotation});
+        }
 
-        return Model;
+        Path.emplace(keys);
     }
 
+    // inverse(translate(position) * mat4(rotation)), without a general inverse: the rotation
+    // transposed, then the position rotated by it and negated.
+    static glm::mat4 viewOf(const glm::vec3 & position, const glm::quat & rotation)
+    {
+        glm::mat3 inverseRotation = glm::mat3_cast(glm::conjugate(glm::normalize(rotation)));
 
+        glm::mat4 view(inverseRotation);
+        view[3] = glm::vec4(-(inverseRotation * position), 1.0f);
 
-    glm::vec3 GetlerpedPosition()
+        return view;
+    }
+
+    static double wallClock()
     {
-        return lerped_position;
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
     }
 
-private:
     std::vector<KeyFrame> Frames;
-    Timer KeyFrameCamera_timer;  bool isAnimating;
-    int begin_frame_index = 0;
+    Clock Now {wallClock};
+    double Start_time = 0.0;
+    bool isAnimating {false};
+
+    // Spline through Frames, with its arc length table; fitted once per set of keys.
+    std::optional<CameraPath> Path;
+    bool constantSpeed {true};
+    std::size_t begin_frame_index = 0;
     bool is_at_last = false;
 
 
     glm::vec3 lerped_position;
     glm::quat slerped_rotation;
+    glm::mat4 View;
 
     glm::mat4 Bias = glm::mat4(1.0f);
     glm::vec3 V_pos = glm::vec3(0.0f);
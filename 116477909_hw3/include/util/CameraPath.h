@@ -0,0 +1,91 @@
+#ifndef CAMERAPATH_H
+#define CAMERAPATH_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+
+/// Smooth path through camera keyframes, for playback at constant speed.
+///
+/// Positions follow a centripetal Catmull-Rom spline (knots spaced by the square root of the
+/// key distance, so segments neither overshoot into loops nor form cusps), with mirrored
+/// phantom keys at the ends. Rotations follow squad through the key rotations. Both keep the
+/// direction of motion continuous at the keys, which per-segment lerp and slerp do not.
+///
+/// The arc length is tabulated once and resampled at even distances, so evaluating a pose by
+/// distance travelled is a table lookup plus one cubic and one squad, however many keys.
+class CameraPath
+{
+public:
+    struct Pose
+    {
+        glm::vec3 position {0.0f};
+        glm::quat rotation {1.0f, 0.0f, 0.0f, 0.0f};
+    };
+
+    // Arc length samples per segment, both when measuring and in the lookup table.
+    static constexpr std::size_t kSamplesPerSegment {256};
+
+    // At least one key.
+    explicit CameraPath(const std::vector<Pose> & keys);
+
+    [[nodiscard]] float length() const { return distances.back(); }
+
+    [[nodiscard]] std::size_t segmentCount() const { return segments.size(); }
+
+    // Pose at spline parameter u in [0, 1] of segment.
+    [[nodiscard]] Pose at(std::size_t segment, float u) const;
+
+    // Pose the given fraction of length() along the path. Segments without length are passed
+    // at once; a path without any length is traversed by spline parameter instead.
+    [[nodiscard]] Pose atFraction(float fraction) const;
+
+    // Pose the given fraction of segment's arc length along it.
+    [[nodiscard]] Pose atSegmentFraction(std::size_t segment, float fraction) const;
+
+private:
+    struct Segment
+    {
+        // Hermite cubic in power form: position(u) = c0 + u * (c1 + u * (c2 + u * c3)).
+        glm::vec3 c0 {0.0f};
+        glm::vec3 c1 {0.0f};
+        glm::vec3 c2 {0.0f};
+        glm::vec3 c3 {0.0f};
+
+        // Rotations at the ends and the squad control rotations between them.
+        glm::quat q0 {1.0f, 0.0f, 0.0f, 0.0f};
+        glm::quat q1 {1.0f, 0.0f, 0.0f, 0.0f};
+        glm::quat s0 {1.0f, 0.0f, 0.0f, 0.0f};
+        glm::quat s1 {1.0f, 0.0f, 0.0f, 0.0f};
+    };
+
+    // Pose at global parameter g: segment floor(g), u its fraction.
+    [[nodiscard]] Pose atParameter(float g) const;
+
+    [[nodiscard]] static glm::vec3 positionAt(const Segment & segment, float u);
+
+    void fitPositions(const std::vector<Pose> & keys);
+
+    void fitRotations(const std::vector<Pose> & keys);
+
+    // Fills distances and the even-distance parameter table.
+    void measure();
+
+    std::vector<Segment> segments;
+
+    // Arc length from the start to each key.
+    std::vector<float> distances;
+
+    // Global parameter at kSamplesPerSegment evenly spaced distances per segment, from 0 to
+    // length(); empty if the path has no length.
+    std::vector<float> parameters;
+
+    // A single key: the only pose there is.
+    Pose first;
+};
+
+
+#endif  // CAMERAPATH_H
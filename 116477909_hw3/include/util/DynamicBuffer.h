@@ -0,0 +1,105 @@
+#ifndef DYNAMICBUFFER_H
+#define DYNAMICBUFFER_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+
+/// Update policy for one GL buffer whose contents change after creation.
+///
+/// Static buffers are specified once at their exact size and changed, rarely, through
+/// glBufferSubData. Streamed buffers (deforming or procedurally updated meshes, per-frame
+/// draw commands) keep a capacity larger than their contents, so respecifying them orphans
+/// the old store at the same size instead of reallocating it, and the driver hands out a
+/// fresh one while draws still read the old.
+///
+/// Partial changes are recorded as dirty byte ranges and copied by flush() from the CPU copy.
+/// A streamed buffer is fenced after each draw: once the fence signaled, the ranges are
+/// written in place through unsynchronized mapped ranges; while the GPU may still read it,
+/// the whole buffer is orphaned and uploaded instead of waiting for the draw to finish.
+/// Contents growing at the end (an LOD chain gaining a level) are appended into spare
+/// capacity, which no draw reads yet.
+///
+/// The buffer object itself belongs to its shape; this only tracks its size and fence.
+class DynamicBuffer
+{
+public:
+    enum class Usage
+    {
+        kStatic,
+        kStreamed,
+    };
+
+    DynamicBuffer(GLenum target, Usage usage);
+
+    DynamicBuffer(const DynamicBuffer &) = delete;
+    DynamicBuffer & operator=(const DynamicBuffer &) = delete;
+
+    ~DynamicBuffer() noexcept;
+
+    // Manages buffer from now on, whose data store already holds bytes of contents.
+    void attach(GLuint buffer, std::size_t bytes);
+
+    // Takes effect at the next respecify().
+    void setUsage(Usage newUsage) { usage = newUsage; }
+
+    [[nodiscard]] Usage getUsage() const { return usage; }
+
+    // Bytes of contents, at most the store's size.
+    [[nodiscard]] std::size_t size() const { return bytes; }
+
+    // Replaces the contents with bytes of pData; dirty ranges are dropped. A streamed store
+    // keeps room for at least reserveBytes, for contents about to grow.
+    void respecify(const void * pData, std::size_t newBytes, std::size_t reserveBytes = 0);
+
+    // Writes count bytes of pData after the contents, if the store has room. Draws issued so
+    // far never read past the contents, so this needs neither a fence nor orphaning. Returns
+    // false, changing nothing, if the store is too small; respecify() it then.
+    bool append(const void * pData, std::size_t count);
+
+    // Records that [offset, offset + count) of the contents changed on the CPU side.
+    void markDirty(std::size_t offset, std::size_t count);
+
+    [[nodiscard]] bool dirty() const { return !dirtyRanges.empty(); }
+
+    // Copies the dirty ranges from pSource, the CPU copy of all contents, to the buffer.
+    void flush(const void * pSource);
+
+    // Call after the draws reading the buffer were issued.
+    void fenceAfterDraw();
+
+private:
+    // More ranges than this are merged into one spanning them, so a scattered update
+    // maps the buffer once instead of per range.
+    static constexpr std::size_t kMaxRanges {16};
+
+    // Whether draws issued before the last fence may still read the buffer.
+    [[nodiscard]] bool busy();
+
+    void releaseFence();
+
+    // Fresh store of capacity bytes with the first bytes of pData, if given.
+    void orphan(const void * pData);
+
+    // Writes [begin, end) of the contents from pBytes, the CPU copy of that range, into the
+    // bound buffer; the GPU must no longer read it.
+    void write(const unsigned char * pBytes, std::size_t begin, std::size_t end);
+
+    GLenum target;
+    Usage usage;
+
+    GLuint buffer {0U};
+    std::size_t bytes {0};
+    std::size_t capacity {0};
+
+    // Disjoint [begin, end) byte ranges, sorted.
+    std::vector<std::pair<std::size_t, std::size_t>> dirtyRanges;
+
+    GLsync fence {nullptr};
+};
+
+
+#endif  // DYNAMICBUFFER_H
@@ -0,0 +1,107 @@
+#ifndef GEOMETRYSOA_H
+#define GEOMETRYSOA_H
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shape/Mesh.h"
+
+
+/// CPU-side geometry stored as structure-of-arrays: one aligned float array per component,
+/// so the preprocessing kernels (transform, normalization, bounds) run
+/// kLanes vertices per instruction (AVX2 with -DHW3_AVX2=ON, SSE otherwise).
+/// Vertices are interleaved into the Mesh::Vertex layout only at the end, straight into a
+/// mapped VBO by upload() or into a vector by toVertices().
+class GeometrySoA
+{
+public:
+    static constexpr std::size_t kAlignment {32};
+
+    // Vertices processed per SIMD step.
+    static const std::size_t kLanes;
+
+    template <typename T>
+    struct AlignedAllocator
+    {
+        using value_type = T;
+
+        AlignedAllocator() = default;
+
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U> &) {}
+
+        T * allocate(std::size_t n)
+        {
+            return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(kAlignment)));
+        }
+
+        void deallocate(T * p, std::size_t)
+        {
+            ::operator delete(p, std::align_val_t(kAlignment));
+        }
+
+        template <typename U>
+        bool operator==(const AlignedAllocator<U> &) const { return true; }
+
+        template <typename U>
+        bool operator!=(const AlignedAllocator<U> &) const { return false; }
+    };
+
+    using Array = std::vector<float, AlignedAllocator<float>>;
+
+    struct Bounds
+    {
+        glm::vec3 min {0.0f};
+        glm::vec3 max {0.0f};
+    };
+
+    GeometrySoA() = default;
+
+    explicit GeometrySoA(const std::vector<Mesh::Vertex> & vertices);
+
+    // Reads a triangle list in the var/ format: nine floats (three corners) per triangle.
+    // Normals are left zero and colors white.
+    static GeometrySoA readTriangles(const std::string & file);
+
+    [[nodiscard]] std::size_t size() const;
+
+    void resize(std::size_t count);
+
+    // Applies model to the positions only.
+    void transformPositions(const glm::mat4 & model);
+
+    // Scales normals to unit length; zero normals stay zero.
+    void normalizeNormals();
+
+    [[nodiscard]] Bounds bounds() const;
+
+    void setColor(const glm::vec3 & color);
+
+    // Writes size() vertices in the Mesh::Vertex layout to pOut.
+    void interleave(Mesh::Vertex * pOut) const;
+
+    [[nodiscard]] std::vector<Mesh::Vertex> toVertices() const;
+
+    // Replaces the contents of vbo with the interleaved vertices, written into the mapped buffer.
+    void upload(GLuint vbo, GLenum usage) const;
+
+    Array px;
+    Array py;
+    Array pz;
+
+    Array nx;
+    Array ny;
+    Array nz;
+
+    Array r;
+    Array g;
+    Array b;
+};
+
+
+#endif  // GEOMETRYSOA_H
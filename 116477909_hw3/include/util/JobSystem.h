@@ -0,0 +1,275 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/// Work-stealing task scheduler shared by everything that splits work across cores
+/// (culling, subdivision, mesh loading, normal generation, the simplifier).
+///
+/// Every worker, and the thread that created the system, owns a Chase-Lev deque: it pushes
+/// and pops jobs at the bottom without locks, and idle workers steal from the top of a
+/// random other deque. Pushing to one's own deque takes no lock; other threads go through a
+/// locked injection queue. Submitting still allocates the job, may grow the deque and may
+/// wake a worker, so it is not wait-free.
+///
+/// post() is the wait-free path, for GLFW callbacks and the like: a function pointer and a few
+/// bytes of arguments copied into a slot of a preallocated ring, claimed with one fetch_add
+/// and one compare-exchange. A full ring rejects the job instead of waiting for room.
+///
+/// Background jobs (file I/O, parsing) wait in a queue of their own that only the workers
+/// take from, after any other work, so a thread waiting for a frame never picks one up and
+/// stalls behind a disk read. Jobs they submit are background jobs too.
+///
+/// Dependencies are continuation-style: jobs count down a Counter, wait() on it helps run
+/// jobs until it reaches zero, and after() queues a job once a Counter is done.
+/// shutdown() runs what is queued and joins the workers; later submissions run inline.
+/// An exception escaping a job without a Counter is kept for rethrowUncaught().
+class JobSystem
+{
+    struct Job;
+
+public:
+    using Task = std::function<void()>;
+
+    // Posted job: called with a copy of the argument bytes given to post().
+    using PostedFunction = void (*)(const void * pArguments);
+
+    static constexpr std::size_t kPostBytes {48};
+    static constexpr std::size_t kPostSlots {256};
+
+    /// Number of unfinished jobs of a group, and the first exception one of them threw.
+    class Counter
+    {
+    public:
+        Counter() = default;
+
+        Counter(const Counter &) = delete;
+        Counter & operator=(const Counter &) = delete;
+
+        [[nodiscard]] bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class JobSystem;
+
+        std::atomic<int> pending {0};
+
+        std::mutex mutex;                 // guards error and continuations
+        std::exception_ptr error;
+        std::vector<Job *> continuations;  // queued when pending drops to zero
+    };
+
+    // threads workers besides the creating thread; 0 for one per other hardware thread.
+    explicit JobSystem(unsigned threads = 0);
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem & operator=(const JobSystem &) = delete;
+
+    ~JobSystem() noexcept;
+
+    // The process-wide instance, created on first use by the calling thread.
+    static JobSystem & shared();
+
+    // Queues task; counter, if given, counts it until it finished.
+    void submit(Task task, Counter * pCounter = nullptr);
+
+    // Queues task as a background job, which the creating thread never runs.
+    void submitBackground(Task task, Counter * pCounter = nullptr);
+
+    // Wait-free: queues function(copy of bytes of pArguments), bytes <= kPostBytes. Neither
+    // allocates, locks nor wakes a worker (they look again within kIdleWait). Returns false,
+    // queuing nothing, if the ring is full or the system shut down.
+    bool post(PostedFunction function, const void * pArguments = nullptr, std::size_t bytes = 0);
+
+    // Queues task once dependency is done (at once if it already is).
+    void after(Counter & dependency, Task task, Counter * pCounter = nullptr);
+
+    // Runs queued jobs until counter is done, then rethrows the first exception of its jobs.
+    void wait(Counter & counter);
+
+    // Calls body(i) for every i in [begin, end), split in halves down to grain indices,
+    // the halves stolen by idle workers. Returns when all are done; rethrows the first exception.
+    template <typename Function>
+    void parallelFor(std::size_t begin, std::size_t end, Function && body, std::size_t grain = 1);
+
+    // Rethrows, once, the first exception that escaped a job without a Counter.
+    void rethrowUncaught();
+
+    // Finishes queued jobs and joins the workers. Idempotent; called by the destructor.
+    void shutdown();
+
+    [[nodiscard]] unsigned workerCount() const { return static_cast<unsigned>(workers.size()); }
+
+private:
+    struct Job
+    {
+        Task task;
+        Counter * pCounter {nullptr};
+        bool background {false};
+    };
+
+    /// Chase-Lev deque (Lê et al., "Correct and Efficient Work-Stealing for Weak Memory
+    /// Models", 2013). push()/pop() by the owner only, steal() by anyone.
+    class Deque
+    {
+    public:
+        Deque();
+        ~Deque();
+
+        void push(Job * pJob);
+        Job * pop();
+        Job * steal();
+
+    private:
+        struct Ring
+        {
+            explicit Ring(std::int64_t capacity);
+
+            std::int64_t capacity;
+            std::unique_ptr<std::atomic<Job *>[]> slots;
+
+            Job * get(std::int64_t i) const { return slots[i & (capacity - 1)].load(std::memory_order_relaxed); }
+            void put(std::int64_t i, Job * pJob) { slots[i & (capacity - 1)].store(pJob, std::memory_order_relaxed); }
+        };
+
+        std::atomic<std::int64_t> top {0};
+        std::atomic<std::int64_t> bottom {0};
+        std::atomic<Ring *> ring;
+
+        // Outgrown rings, which thieves may still read; freed with the deque.
+        std::vector<std::unique_ptr<Ring>> retired;
+    };
+
+    // A post() job in the ring; state goes kFree -> kWriting (producer) -> kReady -> kFree (consumer).
+    struct PostedSlot
+    {
+        static constexpr int kFree {0};
+        static constexpr int kWriting {1};
+        static constexpr int kReady {2};
+
+        std::atomic<int> state {kFree};
+        std::uint64_t ticket {0};
+        PostedFunction function {nullptr};
+        alignas(std::max_align_t) unsigned char arguments[kPostBytes] {};
+    };
+
+    static constexpr std::int64_t kInitialCapacity {256};
+
+    // Idle workers recheck for work this often, covering wakeups lost to the unlocked notify.
+    static constexpr std::chrono::milliseconds kIdleWait {1};
+
+    static constexpr unsigned kNoDeque {~0U};
+
+    void workerLoop(unsigned index);
+
+    // One job from deque self, the injection queue, the posted ring, a victim's deque or, for
+    // workers, the background queue; null if none.
+    Job * find(unsigned self);
+
+    // The oldest ready posted job as a Job, freeing its slot; null if none or another thread
+    // is taking one.
+    Job * takePosted();
+
+    // Index of the calling thread's deque, or kNoDeque.
+    [[nodiscard]] unsigned self() const;
+
+    void run(Job * pJob);
+
+    // Runs pJob on the calling thread after shutdown(), counted like a queued job.
+    void runInline(Job * pJob);
+
+    // Enqueues on the background queue, the calling thread's deque if it has one, else on
+    // the injection queue.
+    void enqueue(Job * pJob);
+
+    void finish(Counter & counter);
+
+    // Deques by owner: 0 is the creating thread, 1.. the workers.
+    std::vector<std::unique_ptr<Deque>> deques;
+    std::vector<std::thread> workers;
+
+    std::mutex injectionMutex;
+    std::vector<Job *> injected;
+
+    // Posted jobs; the ticket picks the slot and orders ready jobs. One consumer at a time.
+    std::unique_ptr<PostedSlot[]> posted;
+    std::atomic<std::uint64_t> postTicket {0};
+    std::atomic<int> postedReady {0};
+    std::mutex postedMutex;
+
+    // First in, first out: streamed assets arrive in the order they were requested.
+    std::mutex backgroundMutex;
+    std::deque<Job *> background;
+
+    // Sleeping workers are woken by bumping work and notifying.
+    std::atomic<std::uint64_t> work {0};
+    std::atomic<int> sleepers {0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+
+    // Jobs queued or running, so shutdown() knows when everything ran.
+    std::atomic<std::int64_t> outstanding {0};
+
+    std::atomic<bool> stopping {false};
+
+    std::mutex uncaughtMutex;
+    std::exception_ptr uncaught;
+};
+
+
+template <typename Function>
+void JobSystem::parallelFor(std::size_t begin, std::size_t end, Function && body, std::size_t grain)
+{
+    if (end <= begin)
+    {
+        return;
+    }
+
+    grain = std::max<std::size_t>(grain, 1);
+
+    if (end - begin <= grain)
+    {
+        for (std::size_t i = begin; i != end; ++i)
+        {
+            body(i);
+        }
+
+        return;
+    }
+
+    Counter counter;
+
+    // Hands the upper half of the range to thieves and keeps splitting the lower one.
+    std::function<void(std::size_t, std::size_t)> split = [&](std::size_t first, std::size_t last)
+    {
+        while (grain < last - first)
+        {
+            std::size_t middle = first + (last - first) / 2;
+            submit([&split, middle, last] { split(middle, last); }, &counter);
+            last = middle;
+        }
+
+        for (std::size_t i = first; i != last; ++i)
+        {
+            body(i);
+        }
+    };
+
+    submit([&split, begin, end] { split(begin, end); }, &counter);
+    wait(counter);
+}
+
+
+#endif  // JOBSYSTEM_H
@@ -0,0 +1,84 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/// Minimal JSON document model for the data files under var/.
+/// parse() accepts standard JSON (RFC 8259), nested at most kMaxDepth arrays and objects deep,
+/// and throws std::runtime_error with the line and column of the first syntax error.
+/// The accessors throw std::runtime_error on a type mismatch or a missing member, naming
+/// the offending path, so data errors read like parse errors.
+class Json
+{
+public:
+    enum class Type
+    {
+        kNull,
+        kBool,
+        kNumber,
+        kString,
+        kArray,
+        kObject,
+    };
+
+    static constexpr std::size_t kMaxDepth {256};
+
+    static Json parse(const std::string & text);
+
+    // Reads and parses a whole file.
+    static Json load(const std::string & file);
+
+    [[nodiscard]] Type type() const { return valueType; }
+
+    [[nodiscard]] bool isNull() const { return valueType == Type::kNull; }
+    [[nodiscard]] bool isNumber() const { return valueType == Type::kNumber; }
+    [[nodiscard]] bool isString() const { return valueType == Type::kString; }
+    [[nodiscard]] bool isArray() const { return valueType == Type::kArray; }
+    [[nodiscard]] bool isObject() const { return valueType == Type::kObject; }
+
+    [[nodiscard]] bool asBool() const;
+    [[nodiscard]] double asNumber() const;
+    [[nodiscard]] float asFloat() const;
+    [[nodiscard]] int asInt() const;
+    [[nodiscard]] const std::string & asString() const;
+
+    // Arrays.
+    [[nodiscard]] std::size_t size() const;
+    [[nodiscard]] const Json & operator[](std::size_t index) const;
+    [[nodiscard]] const std::vector<Json> & items() const;
+
+    // Objects, members in file order.
+    [[nodiscard]] const Json * find(const std::string & key) const;
+    [[nodiscard]] const Json & operator[](const std::string & key) const;
+    [[nodiscard]] const std::vector<std::pair<std::string, Json>> & members() const;
+
+    // Member value, or fallback if absent.
+    [[nodiscard]] float get(const std::string & key, float fallback) const;
+    [[nodiscard]] int get(const std::string & key, int fallback) const;
+    [[nodiscard]] bool get(const std::string & key, bool fallback) const;
+    [[nodiscard]] std::string get(const std::string & key, const char * fallback) const;
+
+    // Dotted path from the document root, e.g. "modes.4.objects[2]", for error messages.
+    [[nodiscard]] const std::string & path() const { return location; }
+
+private:
+    class Parser;
+
+    [[noreturn]] void fail(const std::string & expected) const;
+
+    Type valueType {Type::kNull};
+    bool boolean {false};
+    double number {0.0};
+    std::string string;
+    std::vector<Json> array;
+    std::vector<std::pair<std::string, Json>> object;
+
+    std::string location;
+};
+
+
+#endif  // JSON_H
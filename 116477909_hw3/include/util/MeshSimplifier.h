@@ -0,0 +1,66 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "shape/LodMesh.h"
+#include "shape/Mesh.h"
+
+
+/// Garland-Heckbert quadric error simplification of Mesh triangle lists.
+///
+/// Corners are welded into shared vertices first. The weld key is position and color,
+/// plus the normal unless the input is flat shaded (all three corners of every triangle
+/// sharing the face normal). Vertices at the same position that stay apart, i.e. color or
+/// normal creases, are locked: edges may collapse onto them but never move them, so
+/// attribute seams survive intact. Open boundaries get perpendicular constraint planes and
+/// may only slide along themselves (or are locked outright with lockBoundary).
+/// Edge collapses are taken cheapest first from a priority queue, rejecting any that would
+/// flip a triangle or make the surface non-manifold.
+///
+/// Large meshes are cut into spatial slabs simplified on separate threads with the
+/// slab borders locked, then finished by one pass over the whole mesh.
+class MeshSimplifier
+{
+public:
+    struct Options
+    {
+        // Stop once at most this many triangles are left...
+        std::size_t targetTriangles {0};
+
+        // ...or once the cheapest collapse would move the surface more than this (object space).
+        float maxError {std::numeric_limits<float>::max()};
+
+        bool lockBoundary {false};
+
+        // 0: one per hardware thread.
+        unsigned threads {0};
+    };
+
+    struct ChainOptions
+    {
+        // Levels below the input; each has about ratio times the triangles of the next finer one.
+        int levels {4};
+        float ratio {0.5f};
+
+        // Levels stop when they would get below this many triangles or above maxError.
+        std::size_t minTriangles {32};
+        float maxError {std::numeric_limits<float>::max()};
+
+        bool lockBoundary {false};
+        unsigned threads {0};
+    };
+
+    // Simplified triangle list, with error the largest surface deviation of any collapse taken.
+    static LodMesh::Level simplify(const std::vector<Mesh::Vertex> & triangles, const Options & options);
+
+    // LOD chain for LodMesh, coarsest first, ending with the input itself at error 0.
+    // Each level is simplified from the next finer one; errors accumulate along the chain.
+    static std::vector<LodMesh::Level> buildLodChain(const std::vector<Mesh::Vertex> & triangles,
+                                                     const ChainOptions & options);
+};
+
+
+#endif  // MESHSIMPLIFIER_H
@@ -0,0 +1,47 @@
+#ifndef NORMALGENERATOR_H
+#define NORMALGENERATOR_H
+
+#include <vector>
+
+#include "shape/Mesh.h"
+#include "util/GeometrySoA.h"
+
+
+/// Smooth vertex normals for triangle lists of any shape.
+///
+/// Corners closer than weldTolerance (relative to the bounding box diagonal) are welded
+/// into one vertex through a spatial hash, so the weld is O(n) whatever the input order.
+/// Each corner then averages the face normals around its vertex, weighted by the corner
+/// angle or by face area, skipping faces that bend away from its own face by more than
+/// creaseAngle: cube edges stay sharp while a tessellated sphere shades smooth.
+/// The averaging runs in parallel over corners.
+class NormalGenerator
+{
+public:
+    enum class Weighting
+    {
+        kAngle,
+        kArea,
+    };
+
+    struct Options
+    {
+        Weighting weighting {Weighting::kAngle};
+
+        // Radians between face normals beyond which an edge stays hard (60 degrees).
+        float creaseAngle {1.0471976f};
+
+        float weldTolerance {1e-5f};
+
+        // 0: one per hardware thread.
+        unsigned threads {0};
+    };
+
+    // Overwrites the normals of consecutive triangles in geometry.
+    static void generate(GeometrySoA & geometry, const Options & options);
+
+    static void generate(std::vector<Mesh::Vertex> & triangles, const Options & options);
+};
+
+
+#endif  // NORMALGENERATOR_H
@@ -0,0 +1,32 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+
+#include "util/JobSystem.h"
+
+
+/// Calls body(i) for every i in [begin, end) on the shared JobSystem, split into chunks of
+/// at least grain indices: at most threads chunks, or with threads 0 a few per thread of the
+/// system so idle workers have some to steal. The calling thread helps run them.
+/// Returns when every chunk is done. The first exception thrown by body is rethrown here.
+template <typename Function>
+void parallelFor(std::size_t begin, std::size_t end, Function && body, std::size_t grain = 1, unsigned threads = 0)
+{
+    if (end <= begin)
+    {
+        return;
+    }
+
+    JobSystem & jobs = JobSystem::shared();
+
+    constexpr std::size_t kChunksPerThread {4};
+    std::size_t chunks = threads != 0 ? threads : kChunksPerThread * (jobs.workerCount() + 1);
+    grain = std::max(grain, (end - begin + chunks - 1) / chunks);
+
+    jobs.parallelFor(begin, end, body, grain);
+}
+
+
+#endif  // PARALLEL_H
@@ -0,0 +1,23 @@
+#ifndef RENDERCONTEXT_H
+#define RENDERCONTEXT_H
+
+#include <glm/glm.hpp>
+
+
+/// Per-frame view state for objects that adapt to the camera (LOD selection, meshlet culling).
+/// Filled by App::submitFrame() before any object renders.
+struct RenderContext
+{
+    // Pixels covered by one world-space unit at the given view-space depth (> 0).
+    [[nodiscard]] float pixelsPerUnit(float depth) const
+    {
+        return projection[1][1] * 0.5f * viewportSize.y / depth;
+    }
+
+    glm::mat4 view {glm::mat4(1.0f)};
+    glm::mat4 projection {glm::mat4(1.0f)};
+    glm::vec2 viewportSize {1.0f, 1.0f};
+};
+
+
+#endif  // RENDERCONTEXT_H
@@ -0,0 +1,72 @@
+#ifndef SCENEGRAPH_H
+#define SCENEGRAPH_H
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+
+/// Transform hierarchy: nodes with a local translate-rotate-scale relative to their parent.
+///
+/// Nodes are stored in flat arrays in depth-first order, so every subtree is one contiguous
+/// range after its root and parents precede their children. setLocal() only records the
+/// changed node; update() then recomputes the world matrices of the dirty subtrees, one
+/// linear pass per range (SSE matrix products where available), and reports which nodes moved.
+/// Node ids stay valid while nodes are inserted; their array positions do not.
+class SceneGraph
+{
+public:
+    using NodeId = std::uint32_t;
+
+    static constexpr NodeId kNone {~0U};
+
+    struct Transform
+    {
+        glm::vec3 translation {0.0f};
+        glm::quat rotation {1.0f, 0.0f, 0.0f, 0.0f};
+        glm::vec3 scale {1.0f};
+
+        // translate * rotate * scale
+        [[nodiscard]] glm::mat4 matrix() const;
+    };
+
+    // Adds a node as the last child of parent (kNone for a root).
+    NodeId create(NodeId parent, const Transform & local);
+
+    void setLocal(NodeId node, const Transform & local);
+
+    // Recomputes the world matrices below every node changed since the last update.
+    void update();
+
+    [[nodiscard]] const Transform & local(NodeId node) const { return locals[indexOf[node]]; }
+
+    // As of the last update().
+    [[nodiscard]] const glm::mat4 & world(NodeId node) const { return worlds[indexOf[node]]; }
+
+    [[nodiscard]] NodeId parent(NodeId node) const;
+
+    // Nodes whose world matrix the last update() recomputed, in depth-first order.
+    [[nodiscard]] const std::vector<NodeId> & changed() const { return changedNodes; }
+
+    [[nodiscard]] std::size_t size() const { return nodeAt.size(); }
+
+private:
+    // Per position, depth-first.
+    std::vector<Transform> locals;
+    std::vector<glm::mat4> localMatrices;
+    std::vector<glm::mat4> worlds;
+    std::vector<std::uint32_t> parentAt;     // position of the parent, kNone for roots
+    std::vector<std::uint32_t> subtreeSize;  // the node and all its descendants
+    std::vector<NodeId> nodeAt;
+
+    // Per node id.
+    std::vector<std::uint32_t> indexOf;
+
+    std::vector<NodeId> dirty;
+    std::vector<NodeId> changedNodes;
+};
+
+
+#endif  // SCENEGRAPH_H
@@ -3,209 +3,344 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
 
+/// Shader program built from one source file per pipeline stage.
+/// Construction only submits compilation and linking to the driver;
+/// compile/link status is queried (and errors thrown) the first time the program is used,
+/// so many programs can compile in parallel with the rest of the start-up work.
+/// Per-frame uniforms (see setFrameUniforms()) likewise reach a program only when it is bound,
+/// so programs that are not drawn are neither waited for nor updated.
+///
+/// A Shader also owns its specialized variants: copies of the same sources compiled with extra
+/// "#define NAME value" lines injected after #version (see variant()), so uniforms that select
+/// code paths (e.g. shapeType, displayMode) can become compile-time constants.
 class Shader
 {
 public:
     static constexpr std::size_t kInfoLogBufferSize = 1024UL;
+    static constexpr std::size_t kMaxDefines = 8UL;
 
-public:
-    Shader() = delete;
-    Shader(const Shader &) = delete;
-    Shader & operator=(const Shader &) = delete;
-
-    Shader(const char * vertShaderPath, const char * fragShaderPath)
+    struct Stage
     {
-        // 1. retrieve the vertexShader/fragmentShader source code from filePath
+        GLenum type;
+        std::string path;
+    };
 
-        std::string vertShaderCode;
-        std::string fragShaderCode;
+    struct Define
+    {
+        const char * name;
+        GLint value;
+    };
 
-        if (std::ifstream fin {vertShaderPath, std::ifstream::in})
-        {
-            std::ostringstream sout;
-            sout << fin.rdbuf();
-            vertShaderCode = sout.str();
-        }
-        else
-        {
-            throw std::runtime_error("vertex shader file not successfully read");
-        }
+    // A variant() result kept by its caller, see variant(VariantCache &, ...).
+    struct VariantCache
+    {
+        const Shader * pOwner {nullptr};
+        Shader * pVariant {nullptr};
+        std::uint64_t generation {0U};
+    };
 
-        if (std::ifstream fin {fragShaderPath, std::ifstream::in})
+public:
+    // Lets the driver compile and link on its own threads, if GL_KHR_parallel_shader_compile
+    // (or its ARB twin) is available. Must be called after GLAD is loaded.
+    static void enableParallelCompile()
+    {
+        if (GLAD_GL_KHR_parallel_shader_compile)
         {
-            std::ostringstream sout;
-            sout << fin.rdbuf();
-            fragShaderCode = sout.str();
+            // 0xFFFFFFFF: let the implementation pick the number of compiler threads.
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFFU);
+            parallelCompile = true;
         }
-        else
+        else if (GLAD_GL_ARB_parallel_shader_compile)
         {
-            throw std::runtime_error("fragment shader file not successfully read");
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFFU);
+            parallelCompile = true;
         }
+    }
 
-        const char * vertShaderPtr = vertShaderCode.data();
-        const char * fragShaderPtr = fragShaderCode.data();
+    static bool parallelCompileEnabled()
+    {
+        return parallelCompile;
+    }
 
-        // 2. compile Shader
+public:
+    Shader() = delete;
+    Shader(const Shader &) = delete;
+    Shader & operator=(const Shader &) = delete;
 
-        // vertexShader shader
-        GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertexShader, 1, &vertShaderPtr, nullptr);
-        glCompileShader(vertexShader);
-        checkCompileErrors(vertexShader, "VERTEX");
+    Shader(const char * vertShaderPath, const char * fragShaderPath)
+            : Shader({{GL_VERTEX_SHADER, vertShaderPath},
+                      {GL_FRAGMENT_SHADER, fragShaderPath}})
+    {
 
-        // fragmentShader shader
-        GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragmentShader, 1, &fragShaderPtr, nullptr);
-        glCompileShader(fragmentShader);
-        checkCompileErrors(fragmentShader, "FRAGMENT");
+    }
 
-        // shader program
-        shaderProgram = glCreateProgram();
-        glAttachShader(shaderProgram, vertexShader);
-        glAttachShader(shaderProgram, fragmentShader);
-        glLinkProgram(shaderProgram);
-        checkCompileErrors(shaderProgram, "PROGRAM");
+    Shader(const char * vertShaderPath, const char * tescShaderPath, const char * teseShaderPath, const char * fragShaderPath)
+            : Shader({{GL_VERTEX_SHADER, vertShaderPath},
+                      {GL_TESS_CONTROL_SHADER, tescShaderPath},
+                      {GL_TESS_EVALUATION_SHADER, teseShaderPath},
+                      {GL_FRAGMENT_SHADER, fragShaderPath}})
+    {
 
-        // delete the Shader as they're linked into our program now and no longer necessary
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
     }
 
-    Shader(const char * vertShaderPath, const char * tescShaderPath, const char * teseShaderPath, const char * fragShaderPath)
+    // defines: "#define" lines injected into every stage, see variant().
+    explicit Shader(const std::vector<Stage> & stages, std::string defines = {})
+            : stages(stages), defines(std::move(defines))
     {
-        // 1. retrieve the vertShader/fragShader source code from filePath
+        // 1. retrieve the source code of every stage from filePath (before touching GL,
+        //    so a missing file doesn't leak half-built objects)
 
-        std::string vertShaderCode;
-        std::string tescShaderCode;
-        std::string teseShaderCode;
-        std::string fragShaderCode;
+        std::vector<std::string> sources;
+        sources.reserve(stages.size());
 
-        if (std::ifstream fin {vertShaderPath, std::ifstream::in})
+        for (const Stage & stage : stages)
         {
-            std::ostringstream sout;
-            sout << fin.rdbuf();
-            vertShaderCode = sout.str();
-        }
-        else
-        {
-            throw std::runtime_error("vertex shader file not successfully read");
+            sources.emplace_back(injectDefines(readSource(stage), this->defines));
         }
 
-        if (std::ifstream fin {tescShaderPath, std::ifstream::in})
+        // 2. submit compilation and linking; statuses are checked lazily in resolve()
+
+        shaderProgram = glCreateProgram();
+
+        for (std::size_t i = 0; i != stages.size(); ++i)
         {
-            std::ostringstream sout;
-            sout << fin.rdbuf();
-            tescShaderCode = sout.str();
+            const char * sourcePtr = sources[i].data();
+
+            GLuint shader = glCreateShader(stages[i].type);
+            glShaderSource(shader, 1, &sourcePtr, nullptr);
+            glCompileShader(shader);
+            glAttachShader(shaderProgram, shader);
+
+            pendingShaders.push_back({stages[i].type, shader});
         }
-        else
+
+        glLinkProgram(shaderProgram);
+    }
+
+    Shader(Shader && rhs) noexcept
+    {
+        *this = std::move(rhs);
+    }
+
+    Shader & operator=(Shader && rhs) noexcept
+    {
+        if (this == &rhs)
         {
-            throw std::runtime_error("tessellation control shader file not successfully read");
+            return *this;
         }
 
-        if (std::ifstream fin {teseShaderPath, std::ifstream::in})
+        shaderProgram = rhs.shaderProgram;
+        rhs.shaderProgram = 0U;
+
+        pendingShaders = std::move(rhs.pendingShaders);
+        rhs.pendingShaders.clear();
+
+        stages = std::move(rhs.stages);
+        pendingReload = std::move(rhs.pendingReload);
+
+        defines = std::move(rhs.defines);
+        globalDefines = std::move(rhs.globalDefines);
+        definesGeneration = rhs.definesGeneration;
+        variants = std::move(rhs.variants);
+
+        frameUniforms = std::move(rhs.frameUniforms);
+        frameGeneration = rhs.frameGeneration;
+        appliedGeneration = rhs.appliedGeneration;
+        pOwner = rhs.pOwner == &rhs ? this : rhs.pOwner;
+
+        for (auto & entry : variants)
         {
-            std::ostringstream sout;
-            sout << fin.rdbuf();
-            teseShaderCode = sout.str();
+            entry.second->pOwner = this;
         }
-        else
+
+        return *this;
+    }
+
+    ~Shader()
+    {
+        releasePendingShaders();
+        glDeleteProgram(shaderProgram);
+    }
+
+    // Non-blocking: true once the driver has finished compiling and linking this program.
+    // Without parallel compilation support this is always true (use() then simply blocks).
+    [[nodiscard]] bool isReady() const
+    {
+        if (pendingShaders.empty() || !parallelCompile)
         {
-            throw std::runtime_error("tessellation evaluation shader file not successfully read");
+            return true;
         }
 
-        if (std::ifstream fin {fragShaderPath, std::ifstream::in})
+        GLint done = GL_FALSE;
+        glGetProgramiv(shaderProgram, GL_COMPLETION_STATUS_KHR, &done);
+
+        return done == GL_TRUE;
+    }
+
+    [[nodiscard]] const std::vector<Stage> & getStages() const
+    {
+        return stages;
+    }
+
+    // Sets a define that applies to every later variant() lookup, e.g. the global display mode.
+    void setDefine(const char * name, GLint value)
+    {
+        for (auto & define : globalDefines)
         {
-            std::ostringstream sout;
-            sout << fin.rdbuf();
-            fragShaderCode = sout.str();
+            if (define.first == name)
+            {
+                if (define.second != value)
+                {
+                    define.second = value;
+                    ++definesGeneration;
+                }
+
+                return;
+            }
         }
-        else
+
+        globalDefines.emplace_back(name, value);
+        ++definesGeneration;
+    }
+
+    // Returns the program specialized for the global defines plus the given ones,
+    // compiling it on first request. With no defines at all this is the generic program itself.
+    // Variants requested first at draw time compile while the frame waits,
+    // so submit the ones a scene needs up front with prewarm().
+    Shader & variant(std::initializer_list<Define> localDefines = {})
+    {
+        std::string key = defineBlock(localDefines, true);
+
+        if (key.empty())
         {
-            throw std::runtime_error("fragment shader file not successfully read");
+            return *this;
         }
 
-        const char * vertShaderPtr = vertShaderCode.data();
-        const char * tescShaderPtr = tescShaderCode.data();
-        const char * teseShaderPtr = teseShaderCode.data();
-        const char * fragShaderPtr = fragShaderCode.data();
-
-        // 2. compile Shader
+        auto it = variants.find(key);
 
-        // vertShader shader
-        GLuint vertShader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertShader, 1, &vertShaderPtr, nullptr);
-        glCompileShader(vertShader);
-        checkCompileErrors(vertShader, "VERTEX");
+        if (it == variants.end())
+        {
+            it = variants.emplace(key, makeVariant(key)).first;
+        }
 
-        // tessellation control shader
-        GLuint tescShader = glCreateShader(GL_TESS_CONTROL_SHADER);
-        glShaderSource(tescShader, 1, &tescShaderPtr, nullptr);
-        glCompileShader(tescShader);
-        checkCompileErrors(tescShader, "TESSELLATION CONTROL");
+        return *it->second;
+    }
 
-        // tessellation evaluation shader
-        GLuint teseShader = glCreateShader(GL_TESS_EVALUATION_SHADER);
-        glShaderSource(teseShader, 1, &teseShaderPtr, nullptr);
-        glCompileShader(teseShader);
-        checkCompileErrors(teseShader, "TESSELLATION EVALUATION");
+    // Same as variant(localDefines), but looked up only when cache is empty or the global
+    // defines changed since; a cache must always be used with the same localDefines.
+    Shader & variant(VariantCache & cache, std::initializer_list<Define> localDefines = {})
+    {
+        if (cache.pOwner != this || cache.generation != definesGeneration)
+        {
+            cache = {this, &variant(localDefines), definesGeneration};
+        }
 
-        // fragShader shader
-        GLuint fragShader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragShader, 1, &fragShaderPtr, nullptr);
-        glCompileShader(fragShader);
-        checkCompileErrors(fragShader, "FRAGMENT");
+        return *cache.pVariant;
+    }
 
-        // shader program
-        shaderProgram = glCreateProgram();
-        glAttachShader(shaderProgram, vertShader);
-        glAttachShader(shaderProgram, tescShader);
-        glAttachShader(shaderProgram, teseShader);
-        glAttachShader(shaderProgram, fragShader);
-        glLinkProgram(shaderProgram);
-        checkCompileErrors(shaderProgram, "PROGRAM");
+    // Submits the variant for exactly these defines (the global ones are ignored).
+    void prewarm(std::initializer_list<Define> allDefines)
+    {
+        std::string key = defineBlock(allDefines, false);
 
-        // delete the Shader as they're linked into our program now and no longer necessary
-        glDeleteShader(vertShader);
-        glDeleteShader(tescShader);
-        glDeleteShader(teseShader);
-        glDeleteShader(fragShader);
+        if (!key.empty() && !variants.count(key))
+        {
+            variants.emplace(key, makeVariant(key));
+        }
     }
 
-    Shader(Shader && rhs) noexcept
+    // Replaces the per-frame uniforms of this program and its variants: function(shader) sets
+    // them on the bound shader the first time each program is used after this call, so
+    // programs not drawn this frame cost nothing and are not waited for.
+    void setFrameUniforms(std::function<void(const Shader &)> function)
     {
-        *this = std::move(rhs);
+        frameUniforms = std::move(function);
+        ++frameGeneration;
     }
 
-    Shader & operator=(Shader && rhs) noexcept
+    // Re-reads the stage files and submits new programs (this one and all variants) without blocking.
+    // The current programs stay in use until finishReload() swaps the new ones in.
+    void reload()
     {
-        if (this == &rhs)
+        try
         {
-            return *this;
+            pendingReload = std::make_unique<Shader>(stages, defines);
+        }
+        catch (const std::exception & e)
+        {
+            std::cerr << "shader reload failed: " << e.what() << '\n';
+            pendingReload.reset();
         }
 
-        shaderProgram = rhs.shaderProgram;
-        rhs.shaderProgram = 0U;
-
-        return *this;
+        for (auto & entry : variants)
+        {
+            entry.second->reload();
+        }
     }
 
-    ~Shader()
+    // Call at a frame boundary. Once the program submitted by reload() is done compiling,
+    // swaps it in and returns true; if it failed, logs the error and keeps the old program.
+    // Uniform values are per program; the per-frame ones are set again at the next use().
+    bool finishReload()
     {
-        glDeleteProgram(shaderProgram);
+        bool swapped = false;
+
+        for (auto & entry : variants)
+        {
+            swapped |= entry.second->finishReload();
+        }
+
+        if (!pendingReload || !pendingReload->isReady())
+        {
+            return swapped;
+        }
+
+        std::unique_ptr<Shader> replacement = std::move(pendingReload);
+
+        try
+        {
+            replacement->resolve();
+        }
+        catch (const std::exception & e)
+        {
+            std::cerr << "shader reload failed, keeping the previous program: " << e.what() << '\n';
+            return swapped;
+        }
+
+        std::swap(shaderProgram, replacement->shaderProgram);
+        appliedGeneration = 0U;
+
+        return true;
     }
 
+    // Blocks until this program is built if it is not yet, then binds it and brings its
+    // per-frame uniforms up to date.
     void use() const
     {
+        resolve();
         glUseProgram(shaderProgram);
+
+        if (pOwner->frameUniforms && appliedGeneration != pOwner->frameGeneration)
+        {
+            appliedGeneration = pOwner->frameGeneration;
+            pOwner->frameUniforms(*this);
+        }
     }
 
     void setBool(const std::string & name, bool value) const
@@ -215,7 +350,6 @@ public:
 
     void setInt(const std::string & name, GLint value) const
     {
-        int loc = glGetUniformLocation(shaderProgram, name.c_str());
         glUniform1i(glGetUniformLocation(shaderProgram, name.c_str()), value);
     }
 
@@ -275,6 +409,173 @@ public:
     }
 
 private:
+    struct PendingShader
+    {
+        GLenum type;
+        GLuint shader;
+    };
+
+    static const char * stageName(GLenum type)
+    {
+        switch (type)
+        {
+        case GL_VERTEX_SHADER:
+            return "VERTEX";
+        case GL_TESS_CONTROL_SHADER:
+            return "TESSELLATION CONTROL";
+        case GL_TESS_EVALUATION_SHADER:
+            return "TESSELLATION EVALUATION";
+        case GL_GEOMETRY_SHADER:
+            return "GEOMETRY";
+        case GL_FRAGMENT_SHADER:
+            return "FRAGMENT";
+        default:
+            return "UNKNOWN";
+        }
+    }
+
+    // Inserts the define block right after the #version line (which must stay first).
+    static std::string injectDefines(std::string source, const std::string & defineLines)
+    {
+        if (defineLines.empty())
+        {
+            return source;
+        }
+
+        std::size_t insertAt = 0UL;
+
+        if (std::size_t version = source.find("#version"); version != std::string::npos)
+        {
+            insertAt = source.find('\n', version);
+
+            if (insertAt == std::string::npos)
+            {
+                source += '\n';
+                insertAt = source.size();
+            }
+            else
+            {
+                ++insertAt;
+            }
+        }
+
+        source.insert(insertAt, defineLines);
+
+        return source;
+    }
+
+    // Variant compiled with the define block key, taking its per-frame uniforms from this program.
+    std::unique_ptr<Shader> makeVariant(const std::string & key)
+    {
+        auto pVariant = std::make_unique<Shader>(stages, key);
+        pVariant->pOwner = this;
+
+        return pVariant;
+    }
+
+    // "#define" lines for the given (plus optionally the global) defines, sorted by name
+    // so the same set always maps to the same variant.
+    std::string defineBlock(std::initializer_list<Define> localDefines, bool withGlobals) const
+    {
+        Define sorted[kMaxDefines];
+        std::size_t count = 0UL;
+
+        auto insert = [&sorted, &count](const Define & define)
+        {
+            if (count == kMaxDefines)
+            {
+                throw std::length_error("too many shader defines");
+            }
+
+            std::size_t i = count++;
+
+            for ( ; 0UL < i && 0 < std::strcmp(sorted[i - 1UL].name, define.name); --i)
+            {
+                sorted[i] = sorted[i - 1UL];
+            }
+
+            sorted[i] = define;
+        };
+
+        if (withGlobals)
+        {
+            for (const auto & define : globalDefines)
+            {
+                insert({define.first.c_str(), define.second});
+            }
+        }
+
+        for (const Define & define : localDefines)
+        {
+            insert(define);
+        }
+
+        std::string block;
+
+        for (std::size_t i = 0UL; i != count; ++i)
+        {
+            block += "#define ";
+            block += sorted[i].name;
+            block += ' ';
+            block += std::to_string(sorted[i].value);
+            block += '\n';
+        }
+
+        return block;
+    }
+
+    static std::string readSource(const Stage & stage)
+    {
+        if (std::ifstream fin {stage.path, std::ifstream::in})
+        {
+            std::ostringstream sout;
+            sout << fin.rdbuf();
+            return sout.str();
+        }
+
+        throw std::runtime_error(std::string(stageName(stage.type)) + " shader file " + stage.path +
+                                 " not successfully read");
+    }
+
+    // Blocks until compilation and linking are done (if they aren't yet),
+    // then reports the first error. Runs once; later calls are free.
+    void resolve() const
+    {
+        if (pendingShaders.empty())
+        {
+            return;
+        }
+
+        try
+        {
+            for (const PendingShader & pending : pendingShaders)
+            {
+                checkCompileErrors(pending.shader, stageName(pending.type));
+            }
+
+            checkCompileErrors(shaderProgram, "PROGRAM");
+        }
+        catch (...)
+        {
+            releasePendingShaders();
+            throw;
+        }
+
+        // delete the Shader as they're linked into our program now and no longer necessary
+        releasePendingShaders();
+    }
+
+    void releasePendingShaders() const
+    {
+        for (const PendingShader & pending : pendingShaders)
+        {
+            glDetachShader(shaderProgram, pending.shader);
+            glDeleteShader(pending.shader);
+        }
+
+        pendingShaders.clear();
+    }
+
     // utility function for checking shader compilation/linking errors.
     static void checkCompileErrors(GLuint shader, const std::string & type)
     {
@@ -312,7 +613,40 @@ private:
     }
 
 private:
+    inline static bool parallelCompile {false};
+
     GLuint shaderProgram {0U};
+
+    // Source files, kept for reload().
+    std::vector<Stage> stages;
+
+    // Program being rebuilt by reload(), not yet swapped in.
+    std::unique_ptr<Shader> pendingReload;
+
+    // "#define" lines this program was compiled with (empty for the generic program).
+    std::string defines;
+
+    // Defines applied to every variant() lookup, see setDefine().
+    std::vector<std::pair<std::string, GLint>> globalDefines;
+
+    // Bumped whenever globalDefines change, so a VariantCache knows to look up again.
+    std::uint64_t definesGeneration {1U};
+
+    // Specialized programs keyed by their define block.
+    std::unordered_map<std::string, std::unique_ptr<Shader>> variants;
+
+    // Stages that were submitted but whose status hasn't been checked yet.
+    mutable std::vector<PendingShader> pendingShaders;
+
+    // Per-frame uniforms of the generic program and its variants, see setFrameUniforms().
+    std::function<void(const Shader &)> frameUniforms;
+    std::uint64_t frameGeneration {0U};
+
+    // Holder of the frameUniforms that apply here: the generic program, or this one itself.
+    Shader * pOwner {this};
+
+    // frameGeneration last applied to this program; 0 after its program changed.
+    mutable std::uint64_t appliedGeneration {0U};
 };
 
 
@@ -0,0 +1,55 @@
+#ifndef SHADERWATCHER_H
+#define SHADERWATCHER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+
+class Shader;
+
+
+/// Hot-reloads shaders when their source files change on disk.
+/// A background thread watches one directory with inotify and records modified files;
+/// update(), called by the render loop at a frame boundary, rebuilds the affected programs
+/// and swaps them in once they compile, keeping the old programs when they don't.
+/// On platforms without inotify this is a no-op.
+class ShaderWatcher
+{
+public:
+    explicit ShaderWatcher(std::string directory);
+
+    ShaderWatcher(const ShaderWatcher &) = delete;
+    ShaderWatcher & operator=(const ShaderWatcher &) = delete;
+
+    ~ShaderWatcher() noexcept;
+
+    // Reload pShader whenever one of its stage files under the watched directory changes.
+    void watch(Shader * pShader);
+
+    // Must be called on the thread owning the GL context.
+    // Returns true if any program was swapped (so per-program uniforms need to be set again).
+    bool update();
+
+private:
+    void watchLoop();
+
+    std::string directory;
+    std::vector<Shader *> shaders;
+
+    int inotifyFd {-1};
+    int wakeFd[2] {-1, -1};
+
+    std::atomic<bool> running {false};
+    std::thread worker;
+
+    // Paths (directory + '/' + file name) written since the last update().
+    std::mutex changedMutex;
+    std::unordered_set<std::string> changedFiles;
+};
+
+
+#endif  // SHADERWATCHER_H
@@ -0,0 +1,27 @@
+#ifndef SUBDIVISION_H
+#define SUBDIVISION_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "shape/Mesh.h"
+
+
+/// Midpoint subdivision of triangle lists lying on a (scaled) unit sphere.
+///
+/// Every triangle splits into 4: one at each corner and one between the edge midpoints,
+/// all wound like the parent, so normals taken from the winding keep pointing the same way.
+/// The midpoints are pushed onto the sphere and the smooth normals are regenerated from
+/// the finer surface. No GL calls, so any thread may subdivide.
+class Subdivision
+{
+public:
+    // Each child of triangles[3i, 3i + 3) is at [12i, 12i + 12) of the result; it keeps the
+    // color of its parent's first corner.
+    [[nodiscard]] static std::vector<Mesh::Vertex> subdivide(const std::vector<Mesh::Vertex> & triangles,
+                                                             glm::vec3 scale = glm::vec3(1.0f));
+};
+
+
+#endif  // SUBDIVISION_H
@@ -1,21 +1,127 @@
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <iostream>
+#include <utility>
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include "app/App.h"
+#include "app/AssetStreamer.h"
+#include "app/BufferUploader.h"
 #include "shape/Line.h"
+#include "shape/LodMesh.h"
 #include "shape/Mesh.h"
+#include "shape/Meshlets.h"
+#include "shape/ParametricMesh.h"
+#include "shape/ParametricSurface.h"
 #include "shape/Sphere.h"
+#include "shape/SphereBatch.h"
+#include "shape/StreamedMesh.h"
 #include "shape/Tetrahedron.h"
 #include "shape/icosahedron.h" 
 #include "shape/Docahedron.h"
+#include "util/JobSystem.h"
+#include "util/MeshSimplifier.h"
 #include "util/Shader.h"
+#include "util/ShaderWatcher.h"
 
-int RenderingMode = 7;
-float TessGranularityforTorus = 15;
-float GranularituySuperQuadric = 15;
+int RenderingMode = 1;  // set to the scene's initialMode at startup
 bool UseFreeCamera = true;
-bool HorizontalCamer = true;
 int inDex = 0;
+
+
+namespace
+{
+
+// Unit cube around the origin, two triangles per face.
+std::vector<Mesh::Vertex> boxVertices(const glm::vec3 & color)
+{
+    // Normal and the two in-face axes of each face: front, back, left, right, top, bottom.
+    const glm::vec3 faces[6][3] {
+        {{0.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+        {{0.0f, 0.0f, -1.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+        {{-1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}},
+        {{1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}},
+        {{0.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -1.0f}},
+        {{0.0f, -1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -1.0f}},
+    };
+
+    const glm::vec2 corners[6] {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+
+    std::vector<Mesh::Vertex> vertices;
+    vertices.reserve(36);
+
+    for (const auto & [normal, u, v] : faces)
+    {
+        for (const glm::vec2 & c : corners)
+        {
+            vertices.push_back({0.5f * (normal + c.x * u + c.y * v), normal, color});
+        }
+    }
+
+    return vertices;
+}
+
+
+// Stand-in for a shape still loading: a grey box as large as a unit sphere scaled by scale.
+std::vector<Mesh::Vertex> placeholderVertices(const glm::vec3 & scale)
+{
+    std::vector<Mesh::Vertex> vertices = boxVertices(glm::vec3(0.5f));
+
+    for (Mesh::Vertex & v : vertices)
+    {
+        v.position *= 2.0f * scale;
+    }
+
+    return vertices;
+}
+
+
+// Copies the vertices into a buffer BufferUploader mapped.
+std::function<void(void *)> fillWith(std::shared_ptr<const std::vector<Mesh::Vertex>> pVertices)
+{
+    return [pVertices = std::move(pVertices)](void * pDestination)
+    {
+        std::memcpy(pDestination, pVertices->data(), pVertices->size() * sizeof(Mesh::Vertex));
+    };
+}
+
+
+// Megabytes of an environment variable, no more than fit in a std::size_t of bytes.
+// Warns and returns fallback for anything else, e.g. empty, signed or trailing text.
+std::size_t megabytesFromEnv(const char * name, std::size_t fallback)
+{
+    const char * pValue = std::getenv(name);
+
+    if (!pValue)
+    {
+        return fallback;
+    }
+
+    char * pEnd = nullptr;
+    errno = 0;
+    unsigned long long megabytes = std::strtoull(pValue, &pEnd, 10);
+
+    if (!std::isdigit(static_cast<unsigned char>(*pValue)) || *pEnd != '\0' || errno == ERANGE ||
+        (std::numeric_limits<std::size_t>::max() >> 20U) < megabytes)
+    {
+        std::cerr << name << ": invalid value \"" << pValue << "\", using " << fallback << " MB\n";
+        return fallback;
+    }
+
+    return static_cast<std::size_t>(megabytes);
+}
+
+}  // namespace
+
+
 App & App::getInstance()
 {
     static App instance;
@@ -25,22 +131,62 @@ App & App::getInstance()
 
 void App::run()
 {
+    JobSystem & jobs = JobSystem::shared();
+
     while (!glfwWindowShouldClose(pWindow))
     {
+        // Swap in shaders edited on disk before anything uses them this frame
+        pShaderWatcher->update();
+
         // Per-frame logic
         perFrameTimeLogic(pWindow);
         processKeyInput(pWindow);
 
+        // Camera, scene graph and uniforms of this frame; the only step changing the scene.
+        Frame & current = frames[frameIndex % 2];
+        Frame & previous = frames[(frameIndex + 1) % 2];
+        ++frameIndex;
+
+        beginFrame(current);
+
+        // Cull, pick detail and sort this frame on a worker while the previous one is submitted.
+        // After a mode switch the previous frame's shapes may be gone, so wait for this one.
+        JobSystem::Counter preparing;
+        jobs.submit([this, &current] { prepareFrame(current); }, &preparing);
+        const Frame * pSubmitted = &previous;
+
+        if (!previous.pScene || previous.pScene != current.pScene)
+        {
+            jobs.wait(preparing);
+            pSubmitted = &current;
+        }
+
         // Send render commands to OpenGL server
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        render();
+        submitFrame(*pSubmitted);
+
+        // Build a bit of the mode likely shown next while the GPU works on this frame.
+        // Only other modes' worlds change, never the one being prepared.
+        pResidency->prefetch();
 
-        // Check and call events and swap the buffers
         glfwSwapBuffers(pWindow);
+
+        // Input callbacks below may change the scene, so the worker must be done with it.
+        jobs.wait(preparing);
+        jobs.rethrowUncaught();
+
+        // Hand shapes loaded in the background to their scenes, within this frame's upload budget.
+        pStreamer->update();
+        pResidency->update();
+
         glfwPollEvents();
     }
+
+    // Let running jobs finish while the GL context still exists.
+    jobs.shutdown();
+    jobs.rethrowUncaught();
 }
 
 
@@ -72,40 +218,7 @@ void App::keyCallback(GLFWwindow * window, int key, int scancode, int action, in
         if (action == GLFW_PRESS || action == GLFW_REPEAT) {
             if (key == GLFW_KEY_EQUAL && mods & GLFW_MOD_SHIFT) {
                 // The + key (Shift + =) is pressed
-                if (RenderingMode == 2)
-                {
-                    icosahedron* G =  (icosahedron*)App::getInstance().shapes_mode_2[0].get();
-                    G->subDivide();
-                    G = nullptr;
-                }
-                else if (RenderingMode == 3)
-                {
-                    icosahedron* G = (icosahedron*)App::getInstance().shapes_mode_3[0].get();
-                    G->subDivide();
-                    G = nullptr;
-                }
-                else if (RenderingMode == 5)
-                {
-                    TessGranularityforTorus *= 2;
-
-                    App::getInstance().pSphereShader->use();
-                    App::getInstance().pSphereShader->setFloat("tessLevelOuter", TessGranularityforTorus);
-
-                }
-                else if (RenderingMode == 6)
-                {
-                    GranularituySuperQuadric *= 2;
-
-                    App::getInstance().pSphereShader->use();
-                    App::getInstance().pSphereShader->setFloat("tessLevelOuter", GranularituySuperQuadric);
-
-
-                    docadehedron* G = (docadehedron*)App::getInstance().shapes_mode_6[1].get();
-                    G->subDivide();
-                    G = nullptr;
-                }
-
-
+                App::getInstance().refineMode(RenderingMode);
             }
             else if (key == GLFW_KEY_UP)
             {
@@ -202,85 +315,46 @@ void App::processKeyInput(GLFWwindow * window)
     if (glfwGetKey(window, GLFW_KEY_F2))
     {
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        app.pMeshShader->use();
-        app.pMeshShader->setInt("displayMode", 1);
-        app.pSphereShader->use();
-        app.pSphereShader->setInt("displayMode", 1);
+        app.displayMode = 1;
     }
 
     if (glfwGetKey(window, GLFW_KEY_F3))
     {
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        app.pMeshShader->use();
-        app.pMeshShader->setInt("displayMode", 2);
-        app.pSphereShader->use();
-        app.pSphereShader->setInt("displayMode", 2);
+        app.displayMode = 2;
     }
 
     if (glfwGetKey(window, GLFW_KEY_F4))
     {
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        app.pMeshShader->use();
-        app.pMeshShader->setInt("displayMode", 0);
-        app.pSphereShader->use();
-        app.pSphereShader->setInt("displayMode", 0);
+        app.displayMode = 0;
     }
 
-    if (glfwGetKey(window, GLFW_KEY_1))
-    {
-        UseFreeCamera = true;
-
-        RenderingMode = 1;
-    }
-    else if (glfwGetKey(window, GLFW_KEY_2))
+    // Number keys pick the rendering mode; modes with a camera path in the scene file
+    // look through the keyframe camera, the others through the free one.
+    for (int mode = 1; mode <= 9; ++mode)
     {
-        UseFreeCamera = true;
-
-        RenderingMode = 2;
-    }
-    else if (glfwGetKey(window, GLFW_KEY_3))
-    {
-        UseFreeCamera = true;
-
-        RenderingMode = 3;
-    }
-    else if (glfwGetKey(window, GLFW_KEY_4))
-    {
-        UseFreeCamera = true;
-
-        RenderingMode = 4;
-    }
-    else if (glfwGetKey(window, GLFW_KEY_5))
-    {
-        UseFreeCamera = true;
+        if (glfwGetKey(window, GLFW_KEY_0 + mode))
+        {
+            auto it = app.scene.modes.find(mode);
 
-        RenderingMode = 5;
-    }
-    else if (glfwGetKey(window, GLFW_KEY_6))
-    {
-        UseFreeCamera = true;
+            RenderingMode = mode;
+            UseFreeCamera = it == app.scene.modes.end() || it->second.cameraPath.empty();
 
-        RenderingMode = 6;
-    }
-    else if (glfwGetKey(window, GLFW_KEY_7))
-    {
-        RenderingMode = 7;
-        UseFreeCamera = false;
+            return;
+        }
     }
-    else if (glfwGetKey(window, GLFW_KEY_H))
-    {
-        HorizontalCamer = true;
-       App::getInstance().HorizontalCamera->startKeyFrameCamera();
 
-    }
-    else if (glfwGetKey(window, GLFW_KEY_V))
+    for (auto [key, path] : {std::pair {GLFW_KEY_H, "horizontal"}, std::pair {GLFW_KEY_V, "vertical"}})
     {
-        HorizontalCamer = false;
-        App::getInstance().VerticalCamera->startKeyFrameCamera();
+        auto it = app.keyFrameCameras.find(path);
 
+        if (glfwGetKey(window, key) && it != app.keyFrameCameras.end())
+        {
+            app.pKeyFrameCamera = it->second.get();
+            app.pKeyFrameCamera->startKeyFrameCamera();
+        }
     }
-
-
 }
 
 
@@ -301,6 +375,11 @@ App::App() : Window(kWindowWidth, kWindowHeight, kWindowName, nullptr, nullptr)
     glPointSize(1.0f);
     glEnable(GL_DEPTH_TEST);
 
+    Shader::enableParallelCompile();
+
+    // Created here so the main thread owns a deque and submits to it without locking.
+    JobSystem::shared();
+
     initializeShadersAndObjects();
 }
 
@@ -309,514 +388,587 @@ App::App() : Window(kWindowWidth, kWindowHeight, kWindowName, nullptr, nullptr)
 
 void App::initializeShadersAndObjects()
 {
+    // Shaders only submit their compilation here; the driver keeps compiling them
+    // while the meshes below are loaded, and errors surface on first use in submitFrame().
     pLineShader = std::make_unique<Shader>("src/shader/line.vert.glsl",
                                            "src/shader/line.frag.glsl");
 
     pMeshShader = std::make_unique<Shader>("src/shader/mesh.vert.glsl",
                                            "src/shader/phong.frag.glsl");
 
-    pSphereShader = std::make_unique<Shader>("src/shader/sphere.vert.glsl",
-                                             "src/shader/sphere.tesc.glsl",
-                                             "src/shader/sphere.tese.glsl",
-                                             "src/shader/phong.frag.glsl");
-
-    shapes.emplace_back(
-            std::make_unique<Line>(
-                    pLineShader.get(),
-                    std::vector<Line::Vertex> {
-                            {{0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
-                            {{3.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
-                            {{0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},
-                            {{0.0f, 3.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},
-                            {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
-                            {{0.0f, 0.0f, 3.0f}, {0.0f, 0.0f, 1.0f}},
-                    },
-                    glm::mat4(1.0f)
-            )
-    );
+    useCpuTessellation = detectCpuTessellation();
 
-    shapes.emplace_back(
-            std::make_unique<Tetrahedron>(
-                    pMeshShader.get(),
-                    "var/tetrahedron.txt",
-                    glm::translate(glm::mat4(1.0f), {-2.5f, 0.0f, 0.0f})
-            )
-    );
+    if (useCpuTessellation)
+    {
+        pParametricShader = std::make_unique<Shader>("src/shader/mesh.vert.glsl",
+                                                     "src/shader/phong.frag.glsl");
+    }
+    else
+    {
+        pSphereShader = std::make_unique<Shader>("src/shader/sphere.vert.glsl",
+                                                 "src/shader/sphere.tesc.glsl",
+                                                 "src/shader/sphere.tese.glsl",
+                                                 "src/shader/phong.frag.glsl");
+    }
 
-    shapes.emplace_back(
-        std::make_unique<Tetrahedron>(
-            pMeshShader.get(),
-            "var/octahedron.txt",
-            glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f))
-        )
-    );
+    // Submit every specialization the scenes use now, so they compile in parallel with the mesh loading below.
+    for (int mode = 0; mode <= 2; ++mode)
+    {
+        pMeshShader->prewarm({{"DISPLAY_MODE", mode}});
+        pMeshShader->prewarm({{"DISPLAY_MODE", mode}, {"LOD_FADE", 1}});
+        pMeshShader->prewarm({{"DISPLAY_MODE", mode}, {"COMPRESSED_VERTEX", 1}});
 
-    glm::vec3 BoxColor(0, 0, 1);
-    shapes.emplace_back(
-        std::make_unique<Mesh>(
-            pMeshShader.get(),
-            std::vector<Mesh::Vertex> {
-        // Front face (two triangles)
-                {{-0.5f, -0.5f, 0.5f}, { 0.0f,  0.0f,  1.0f }, {BoxColor }},
-                { { 0.5f, -0.5f,  0.5f}, {0.0f,  0.0f,  1.0f}, {BoxColor } },
-                { { 0.5f,  0.5f,  0.5f}, {0.0f,  0.0f,  1.0f}, {BoxColor } },
-
-                { {-0.5f, -0.5f,  0.5f}, {0.0f,  0.0f,  1.0f}, {BoxColor } },
-                { { 0.5f,  0.5f,  0.5f}, {0.0f,  0.0f,  1.0f}, {BoxColor } },
-                { {-0.5f,  0.5f,  0.5f}, {0.0f,  0.0f,  1.0f}, {BoxColor } },
-
-                    // Back face (two triangles)
-                { {-0.5f, -0.5f, -0.5f}, {0.0f,  0.0f, -1.0f}, {BoxColor } },
-                { { 0.5f, -0.5f, -0.5f}, {0.0f,  0.0f, -1.0f}, {BoxColor } },
-                { { 0.5f,  0.5f, -0.5f}, {0.0f,  0.0f, -1.0f}, {BoxColor } },
-
-                { {-0.5f, -0.5f, -0.5f}, {0.0f,  0.0f, -1.0f}, {BoxColor } },
-                { { 0.5f,  0.5f, -0.5f}, {0.0f,  0.0f, -1.0f}, {BoxColor } },
-                { {-0.5f,  0.5f, -0.5f}, {0.0f,  0.0f, -1.0f}, {BoxColor } },
-
-                    // Left face (two triangles)
-                { {-0.5f, -0.5f, -0.5f}, {-1.0f,  0.0f,  0.0f}, {BoxColor} },
-                { {-0.5f, -0.5f,  0.5f}, {-1.0f,  0.0f,  0.0f}, {BoxColor} },
-                { {-0.5f,  0.5f,  0.5f}, {-1.0f,  0.0f,  0.0f}, {BoxColor} },
-
-                { {-0.5f, -0.5f, -0.5f}, {-1.0f,  0.0f,  0.0f}, {BoxColor} },
-                { {-0.5f,  0.5f,  0.5f}, {-1.0f,  0.0f,  0.0f}, {BoxColor} },
-                { {-0.5f,  0.5f, -0.5f}, {-1.0f,  0.0f,  0.0f}, {BoxColor} },
-
-                    // Right face (two triangles)
-                { { 0.5f, -0.5f, -0.5f}, {1.0f,  0.0f,  0.0f}, {BoxColor } },
-                { { 0.5f, -0.5f,  0.5f}, {1.0f,  0.0f,  0.0f}, {BoxColor } },
-                { { 0.5f,  0.5f,  0.5f}, {1.0f,  0.0f,  0.0f}, {BoxColor } },
-
-                { { 0.5f, -0.5f, -0.5f}, {1.0f,  0.0f,  0.0f}, {BoxColor } },
-                { { 0.5f,  0.5f,  0.5f}, {1.0f,  0.0f,  0.0f}, {BoxColor } },
-                { { 0.5f,  0.5f, -0.5f}, {1.0f,  0.0f,  0.0f}, {BoxColor } },
-
-                    // Top face (two triangles)
-                { {-0.5f,  0.5f,  0.5f}, {0.0f,  1.0f,  0.0f}, {BoxColor } },
-                { { 0.5f,  0.5f,  0.5f}, {0.0f,  1.0f,  0.0f}, {BoxColor } },
-                { { 0.5f,  0.5f, -0.5f}, {0.0f,  1.0f,  0.0f}, {BoxColor } },
-
-                { {-0.5f,  0.5f,  0.5f}, {0.0f,  1.0f,  0.0f}, {BoxColor } },
-                { { 0.5f,  0.5f, -0.5f}, {0.0f,  1.0f,  0.0f}, {BoxColor } },
-                { {-0.5f,  0.5f, -0.5f}, {0.0f,  1.0f,  0.0f}, {BoxColor } },
-
-                    // Bottom face (two triangles)
-                { {-0.5f, -0.5f,  0.5f}, {0.0f, -1.0f,  0.0f}, {BoxColor } },
-                { { 0.5f, -0.5f,  0.5f}, {0.0f, -1.0f,  0.0f}, {BoxColor } },
-                { { 0.5f, -0.5f, -0.5f}, {0.0f, -1.0f,  0.0f}, {BoxColor } },
-
-                { {-0.5f, -0.5f,  0.5f}, {0.0f, -1.0f,  0.0f}, {BoxColor } },
-                { { 0.5f, -0.5f, -0.5f}, {0.0f, -1.0f,  0.0f}, {BoxColor } },
-                { {-0.5f, -0.5f, -0.5f}, {0.0f, -1.0f,  0.0f}, {BoxColor } },
-    },
-
-                    glm::rotate(
-                            glm::translate(glm::mat4(1.0f), {2.5f, 0.0f, 0.0f}),
-                            glm::radians(45.0f), {0.0f, 1.0f, 0.0f}
-                    )
-            )
-    );
+        if (pParametricShader)
+        {
+            pParametricShader->prewarm({{"DISPLAY_MODE", mode}});
+        }
 
+        for (int shapeType = 0; pSphereShader && shapeType <= 4; ++shapeType)
+        {
+            pSphereShader->prewarm({{"DISPLAY_MODE", mode}, {"SHAPE_TYPE", shapeType}});
+            pSphereShader->prewarm({{"DISPLAY_MODE", mode}, {"SHAPE_TYPE", shapeType}, {"SPHERE_BATCH", 1}});
+        }
+    }
 
+    pShaderWatcher = std::make_unique<ShaderWatcher>("src/shader");
+    pShaderWatcher->watch(pLineShader.get());
+    pShaderWatcher->watch(pMeshShader.get());
+    pShaderWatcher->watch(pSphereShader ? pSphereShader.get() : pParametricShader.get());
 
-    initializeObjects2(); initializeObjects3(); initializeObjects4(); initializeObjects5(); initializeObjects6();
-    initializeObjects7();
- }
+    // Only parsed here; each mode's objects are created the first time it is shown.
+    const char * pSceneFile = std::getenv("HW3_SCENE");
+    scene = SceneFile::load(pSceneFile ? pSceneFile : kSceneFile);
+    RenderingMode = scene.initialMode;
 
-void App::initializeObjects2()
-{
+    std::size_t budgetMegabytes = megabytesFromEnv("HW3_GPU_BUDGET_MB", kGpuBudgetMegabytes);
 
-    shapes_mode_2.emplace_back(
-        std::make_unique<icosahedron>(
-            pMeshShader.get(),
-            "var/icosahedron.txt",
-            glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f))
-        )
-    );
-}
+    // Vertex buffers of streamed shapes fill on a second context unless HW3_UPLOAD_THREAD is "0".
+    const char * pUploadThread = std::getenv("HW3_UPLOAD_THREAD");
 
-void App::initializeObjects3()
-{
-    shapes_mode_3.emplace_back(
-        std::make_unique<icosahedron>(
-            pMeshShader.get(),
-            "var/icosahedron.txt",
-            glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f)),
-            glm::vec3(2, 1.0f, 1.0f)
-        )
-   
- ); 
-}
+    if (!pUploadThread || std::strcmp(pUploadThread, "0") != 0)
+    {
+        try
+        {
+            pUploader = std::make_unique<BufferUploader>(pWindow);
+        }
+        catch (const std::runtime_error & e)
+        {
+            std::cerr << e.what() << "; uploading on the main thread\n";
+        }
+    }
 
-void App::initializeObjects4()
-{
-    pSphereShader->use();
-    pSphereShader->setFloat("tessLevelOuter", 64);
-
-    shapes_mode_4.emplace_back(
-        std::make_unique<Sphere>(
-            pSphereShader.get(),
-            glm::vec3(-2.50f, 0.0f, 0.0f),
-            1.0f,
-            glm::vec3(1.0f, 0.5f, 0.31f),
-            glm::mat4(1.0f),
-            1
-        )
-    );
+    pStreamer = std::make_unique<AssetStreamer>(kUploadBudgetKilobytes << 10U, pUploader.get());
 
-    shapes_mode_4.emplace_back(
-        std::make_unique<Sphere>(
-            pSphereShader.get(),
-            glm::vec3(0.0f, 0.0f, 0.0f),
-            1.0f,
-            glm::vec3(1.0f, 0.5f, 0.31f),
-            glm::mat4(1.0f)
-        )
+    pResidency = std::make_unique<SceneResidency>(
+            scene,
+            budgetMegabytes << 20U,
+            kBakedTessLevel,
+            [this](const SceneFile::Object & object,
+                   const glm::mat4 & model,
+                   float level,
+                   std::vector<std::unique_ptr<Renderable>> & shapes)
+            {
+                addObject(object, model, level, shapes);
+            }
     );
 
-    shapes_mode_4.emplace_back(
-        std::make_unique<Sphere>(
-            pSphereShader.get(),
-            glm::vec3(2.50f, 0.0f, 0.0f),
-            1.0f,
-            glm::vec3(1.0f, 0.5f, 0.31f),
-            glm::mat4(1.0f),
-            2
-        )
-    );
+    // HW3_CAMERA_TIMESTEP (seconds) advances the keyframe cameras by that much per frame
+    // instead of in real time, so fly-throughs replay the same frames on every machine.
+    double cameraTimestep = 0.0;
+
+    if (const char * pTimestep = std::getenv("HW3_CAMERA_TIMESTEP"))
+    {
+        char * pEnd = nullptr;
+        double timestep = std::strtod(pTimestep, &pEnd);
+
+        // 0 asks for real time explicitly; !(0 <= x) also catches NaN.
+        if (pEnd == pTimestep || *pEnd != '\0' || !(0.0 <= timestep) || !std::isfinite(timestep))
+        {
+            std::cerr << "HW3_CAMERA_TIMESTEP: invalid value \"" << pTimestep << "\", using real time\n";
+        }
+        else
+        {
+            cameraTimestep = timestep;
+        }
+    }
+
+    for (const auto & [name, path] : scene.cameraPaths)
+    {
+        auto pCamera = std::make_unique<KeyFrameCamera>(path.position, path.rotation);
+        pCamera->setConstantSpeed(path.constantSpeed);
+
+        if (0.0 < cameraTimestep)
+        {
+            pCamera->setClock([this, cameraTimestep] { return static_cast<double>(frameIndex) * cameraTimestep; });
+        }
+
+        for (const SceneFile::CameraPath::Frame & frame : path.frames)
+        {
+            pCamera->pushBackFrame(frame.position, frame.rotation, frame.duration);
+        }
+
+        keyFrameCameras[name] = std::move(pCamera);
+    }
+
+    // The path keyframe modes start on, until H or V picks another.
+    for (const auto & [index, mode] : scene.modes)
+    {
+        if (!mode.cameraPath.empty())
+        {
+            pKeyFrameCamera = keyFrameCameras.at(mode.cameraPath).get();
+            break;
+        }
+    }
 }
 
-void App::initializeObjects5()
+
+bool App::detectCpuTessellation()
 {
-    pSphereShader->use();
-    pSphereShader->setFloat("tessLevelOuter", 15);
-
-    shapes_mode_5.emplace_back(
-        std::make_unique<Sphere>(
-            pSphereShader.get(),
-            glm::vec3(2.50f, 0.0f, 0.0f),
-            1.0f,
-            glm::vec3(1.0f, 0.5f, 0.31f),
-            glm::mat4(1.0f),
-            3
-        )
-    );
+    if (const char * pOverride = std::getenv("HW3_CPU_TESSELLATION"))
+    {
+        return std::strcmp(pOverride, "0") != 0;
+    }
+
+    if (GLVersion.major < 4 && !GLAD_GL_ARB_tessellation_shader)
+    {
+        std::cout << "Tessellation shaders unavailable, tessellating parametric shapes on the CPU\n";
+        return true;
+    }
+
+    // Software rasterizers run the tessellation stages on the CPU anyway, one patch at a time;
+    // baking once is far cheaper than re-tessellating every frame.
+    auto renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+
+    for (const char * pSoftware : {"llvmpipe", "softpipe", "SwiftShader", "Software Rasterizer"})
+    {
+        if (renderer && std::strstr(renderer, pSoftware))
+        {
+            std::cout << "Software renderer (" << renderer << "), tessellating parametric shapes on the CPU\n";
+            return true;
+        }
+    }
+
+    return false;
 }
 
-void App::initializeObjects6()
+
+std::unique_ptr<Renderable> App::makeParametricShape(
+        const glm::vec3 & center,
+        float radius,
+        const glm::vec3 & color,
+        const glm::mat4 & model,
+        int shapeType,
+        float level
+)
 {
-    pSphereShader->use();
-    pSphereShader->setFloat("tessLevelOuter", 15);
-
-    shapes_mode_6.emplace_back(
-        std::make_unique<Sphere>(
-            pSphereShader.get(),
-            glm::vec3(2.50f, 0.0f, 0.0f),
-            1.0f,
-            glm::vec3(1.0f, 0.5f, 0.31f),
-            glm::mat4(1.0f),
-            4
-        )
-    );
+    if (useCpuTessellation)
+    {
+        return std::make_unique<ParametricMesh>(pParametricShader.get(), center, radius, color, model, shapeType, level);
+    }
+
+    return std::make_unique<Sphere>(pSphereShader.get(), center, radius, color, model, shapeType);
+}
 
-        shapes_mode_6.emplace_back(
-            std::make_unique<docadehedron>(
-                pMeshShader.get(),
-                "var/dodecahedron.txt",
-                glm::translate(glm::mat4(1.0f), glm::vec3(-3.0f, 0.0f, 0.0f)),
-                5
-            )
 
-        );
+void App::setBakedLevel(std::vector<std::unique_ptr<Renderable>> & shapes, float level)
+{
+    for (auto & s : shapes)
+    {
+        if (auto pBaked = dynamic_cast<ParametricMesh *>(s.get()))
+        {
+            pBaked->setLevel(level);
+        }
+    }
 }
 
-void App::initializeObjects7()
+
+void App::addObject(
+        const SceneFile::Object & object,
+        const glm::mat4 & model,
+        float level,
+        std::vector<std::unique_ptr<Renderable>> & shapes
+)
 {
-    //urban city
-    glm::vec3 BoxColor(0, 0, 1);
+    using Type = SceneFile::Object::Type;
 
-    glm::vec3 positions[] =
+    switch (object.type)
     {
-        { 2.5f, 0.0f, 0.0f },
-        { -3.0f, -3.0f, 0.0f },
-        { -3.50f, -0.61f, 0.0f},
-    };
+        case Type::kGroup:
+            break;
 
+        case Type::kLine:
+            shapes.emplace_back(std::make_unique<Line>(pLineShader.get(), object.lineVertices, model));
+            break;
 
-    glm::vec3 scales[] =
-    {
-        glm::vec3(2.0f, 7.0f, 3.0f),
-        glm::vec3(2.0f, 2.0f, 3.0f),
-        glm::vec3(0.250f, 5.0f, .50f),
-    };
+        case Type::kBox:
+            shapes.emplace_back(
+                    std::make_unique<Mesh>(
+                            pMeshShader.get(),
+                            boxVertices(object.color),
+                            model,
+                            &renderContext,
+                            object.compressed ? Mesh::VertexFormat::kCompressed : Mesh::VertexFormat::kFull
+                    )
+            );
+            break;
 
-    for (int i = 0; i < 4; i++) {
-        shapes_mode_7.emplace_back(
-            std::make_unique<Mesh>(
-                pMeshShader.get(),
-                std::vector<Mesh::Vertex> {
-            // Front face (two triangles)
-                    {{-0.5f, -0.5f, 0.5f}, { 0.0f,  0.0f,  1.0f }, { BoxColor }},
-                    { { 0.5f, -0.5f,  0.5f}, {0.0f,  0.0f,  1.0f}, {BoxColor } },
-                    { { 0.5f,  0.5f,  0.5f}, {0.0f,  0.0f,  1.0f}, {BoxColor } },
-
-                    { {-0.5f, -0.5f,  0.5f}, {0.0f,  0.0f,  1.0f}, {BoxColor } },
-                    { { 0.5f,  0.5f,  0.5f}, {0.0f,  0.0f,  1.0f}, {BoxColor } },
-                    { {-0.5f,  0.5f,  0.5f}, {0.0f,  0.0f,  1.0f}, {BoxColor } },
-
-                        // Back face (two triangles)
-                    { {-0.5f, -0.5f, -0.5f}, {0.0f,  0.0f, -1.0f}, {BoxColor } },
-                    { { 0.5f, -0.5f, -0.5f}, {0.0f,  0.0f, -1.0f}, {BoxColor } },
-                    { { 0.5f,  0.5f, -0.5f}, {0.0f,  0.0f, -1.0f}, {BoxColor } },
-
-                    { {-0.5f, -0.5f, -0.5f}, {0.0f,  0.0f, -1.0f}, {BoxColor } },
-                    { { 0.5f,  0.5f, -0.5f}, {0.0f,  0.0f, -1.0f}, {BoxColor } },
-                    { {-0.5f,  0.5f, -0.5f}, {0.0f,  0.0f, -1.0f}, {BoxColor } },
-
-                        // Left face (two triangles)
-                    { {-0.5f, -0.5f, -0.5f}, {-1.0f,  0.0f,  0.0f}, {BoxColor} },
-                    { {-0.5f, -0.5f,  0.5f}, {-1.0f,  0.0f,  0.0f}, {BoxColor} },
-                    { {-0.5f,  0.5f,  0.5f}, {-1.0f,  0.0f,  0.0f}, {BoxColor} },
-
-                    { {-0.5f, -0.5f, -0.5f}, {-1.0f,  0.0f,  0.0f}, {BoxColor} },
-                    { {-0.5f,  0.5f,  0.5f}, {-1.0f,  0.0f,  0.0f}, {BoxColor} },
-                    { {-0.5f,  0.5f, -0.5f}, {-1.0f,  0.0f,  0.0f}, {BoxColor} },
-
-                        // Right face (two triangles)
-                    { { 0.5f, -0.5f, -0.5f}, {1.0f,  0.0f,  0.0f}, {BoxColor } },
-                    { { 0.5f, -0.5f,  0.5f}, {1.0f,  0.0f,  0.0f}, {BoxColor } },
-                    { { 0.5f,  0.5f,  0.5f}, {1.0f,  0.0f,  0.0f}, {BoxColor } },
-
-                    { { 0.5f, -0.5f, -0.5f}, {1.0f,  0.0f,  0.0f}, {BoxColor } },
-                    { { 0.5f,  0.5f,  0.5f}, {1.0f,  0.0f,  0.0f}, {BoxColor } },
-                    { { 0.5f,  0.5f, -0.5f}, {1.0f,  0.0f,  0.0f}, {BoxColor } },
-
-                        // Top face (two triangles)
-                    { {-0.5f,  0.5f,  0.5f}, {0.0f,  1.0f,  0.0f}, {BoxColor } },
-                    { { 0.5f,  0.5f,  0.5f}, {0.0f,  1.0f,  0.0f}, {BoxColor } },
-                    { { 0.5f,  0.5f, -0.5f}, {0.0f,  1.0f,  0.0f}, {BoxColor } },
-
-                    { {-0.5f,  0.5f,  0.5f}, {0.0f,  1.0f,  0.0f}, {BoxColor } },
-                    { { 0.5f,  0.5f, -0.5f}, {0.0f,  1.0f,  0.0f}, {BoxColor } },
-                    { {-0.5f,  0.5f, -0.5f}, {0.0f,  1.0f,  0.0f}, {BoxColor } },
-
-                        // Bottom face (two triangles)
-                    { {-0.5f, -0.5f,  0.5f}, {0.0f, -1.0f,  0.0f}, {BoxColor } },
-                    { { 0.5f, -0.5f,  0.5f}, {0.0f, -1.0f,  0.0f}, {BoxColor } },
-                    { { 0.5f, -0.5f, -0.5f}, {0.0f, -1.0f,  0.0f}, {BoxColor } },
-
-                    { {-0.5f, -0.5f,  0.5f}, {0.0f, -1.0f,  0.0f}, {BoxColor } },
-                    { { 0.5f, -0.5f, -0.5f}, {0.0f, -1.0f,  0.0f}, {BoxColor } },
-                    { {-0.5f, -0.5f, -0.5f}, {0.0f, -1.0f,  0.0f}, {BoxColor } },
-        },
-
-                glm::scale(glm::rotate(
-                    glm::translate(glm::mat4(1.0f), positions[i]),
-                    glm::radians(45.0f), { 0.0f, 1.0f, 0.0f }
-                ), scales[i])));
-    }
-
-    //plant
-    pSphereShader->use();
-    pSphereShader->setFloat("tessLevelOuter", 64);
-
-    shapes_mode_7.emplace_back(
-        std::make_unique<Sphere>(
-            pSphereShader.get(),
-            glm::vec3(-3.50f, 0.0f, 0.0f),
-            1.0f,
-            glm::vec3(1.0f, 0.5f, 0.31f),
-            glm::scale(glm::mat4(1.0f), glm::vec3(4.0f, 7.0f, 3.0f)),
-            4
-        )
-    );
+        // Shapes read from files stream in: a box stands in for them until they are ready.
+        case Type::kMesh:
+        {
+            auto pStreamed = std::make_unique<StreamedMesh>(pMeshShader.get(), placeholderVertices(glm::vec3(1.0f)), model);
+            Shader * pShader = pMeshShader.get();
 
+            const RenderContext * pContext = &renderContext;
 
-    shapes_mode_7.emplace_back(
-        std::make_unique<Sphere>(
-            pSphereShader.get(),
-            glm::vec3(0.50f, -0.00f, -5.0f),
-            1.0f,
-            glm::vec3(1.0f, 0.5f, 0.31f),
-            glm::scale(glm::mat4(1.0f), glm::vec3(4.0f, 5.0f, 3.0f)),
-            1
-        )
-    );
+            pStreamer->request(pStreamed.get(), [pShader, pContext, object]
+            {
+                if (object.lod)
+                {
+                    // Simplified on the worker too; ordered for meshlets before packing, like LodMesh would.
+                    auto pLevels = std::make_shared<std::vector<LodMesh::Level>>(
+                            MeshSimplifier::buildLodChain(Tetrahedron::load(object.file), MeshSimplifier::ChainOptions())
+                    );
+
+                    for (LodMesh::Level & level : *pLevels)
+                    {
+                        Meshlets::order(level.vertices);
+                    }
+
+                    return AssetStreamer::Prepared {
+                            LodMesh::packedBytes(*pLevels),
+                            [pLevels](void * pDestination) { LodMesh::pack(*pLevels, pDestination); },
+                            [pShader, pContext, pLevels, crossFade = object.crossFade](GLuint buffer)
+                            {
+                                auto pLodMesh = std::make_unique<LodMesh>(
+                                        pShader, pContext, std::move(*pLevels), glm::mat4(1.0f), buffer
+                                );
+
+                                pLodMesh->setCrossFade(crossFade);
+                                return pLodMesh;
+                            }
+                    };
+                }
 
+                auto pVertices = std::make_shared<std::vector<Mesh::Vertex>>(Tetrahedron::load(object.file));
 
-    shapes_mode_7.emplace_back(
-        std::make_unique<Sphere>(
-            pSphereShader.get(),
-            glm::vec3(-3.50f, -0.61f, -5.0f),
-            1.0f,
-            glm::vec3(1.0f, 0.5f, 0.31f),
-            glm::scale(glm::mat4(1.0f), glm::vec3(2.50f)),
-            0
-        )
-    );
+                if (object.compressed)
+                {
+                    auto pPacked = std::make_shared<Mesh::CompressedVertices>(Mesh::compress(*pVertices));
+
+                    return AssetStreamer::Prepared {
+                            pPacked->bytes.size(),
+                            [pPacked](void * pDestination)
+                            {
+                                std::memcpy(pDestination, pPacked->bytes.data(), pPacked->bytes.size());
+                            },
+                            [pShader, pContext, pVertices, pPacked](GLuint buffer)
+                            {
+                                return std::make_unique<Tetrahedron>(
+                                        pShader, std::move(*pVertices), std::move(*pPacked), glm::mat4(1.0f), pContext, buffer
+                                );
+                            }
+                    };
+                }
 
+                return AssetStreamer::Prepared {
+                        pVertices->size() * sizeof(Mesh::Vertex),
+                        fillWith(pVertices),
+                        [pShader, pContext, pVertices](GLuint buffer)
+                        {
+                            return std::make_unique<Tetrahedron>(pShader, std::move(*pVertices), glm::mat4(1.0f), pContext, buffer);
+                        }
+                };
+            });
+
+            shapes.emplace_back(std::move(pStreamed));
+            break;
+        }
 
-    shapes_mode_7.emplace_back(
-        std::make_unique<docadehedron>(
-            pMeshShader.get(),
-            "var/dodecahedron.txt",
-            glm::translate(glm::mat4(1.0f), glm::vec3(-7.0f, -3.0f, -0.0f)),
-            5
-        )
+        case Type::kIcosphere:
+        {
+            auto pStreamed = std::make_unique<StreamedMesh>(pMeshShader.get(), placeholderVertices(object.scale), model);
+            Shader * pShader = pMeshShader.get();
+            const RenderContext * pContext = &renderContext;
 
-    );
+            pStreamer->request(pStreamed.get(), [pShader, pContext, object]
+            {
+                auto pLevels = std::make_shared<std::vector<LodMesh::Level>>(icosahedron::load(object.file, object.scale));
+
+                return AssetStreamer::Prepared {
+                        LodMesh::packedBytes(*pLevels),
+                        [pLevels](void * pDestination) { LodMesh::pack(*pLevels, pDestination); },
+                        [pShader, pContext, pLevels, object](GLuint buffer)
+                        {
+                            auto pIcosahedron = std::make_unique<icosahedron>(
+                                    pShader,
+                                    pContext,
+                                    std::move(*pLevels),
+                                    glm::mat4(1.0f),
+                                    object.scale,
+                                    buffer
+                            );
+
+                            pIcosahedron->setCrossFade(object.crossFade);
+                            return pIcosahedron;
+                        }
+                };
+            });
+
+            shapes.emplace_back(std::move(pStreamed));
+            break;
+        }
+
+        case Type::kSubdivisionMesh:
+        {
+            auto pStreamed = std::make_unique<StreamedMesh>(pMeshShader.get(), placeholderVertices(glm::vec3(1.0f)), model);
+            Shader * pShader = pMeshShader.get();
+            int shapeType = object.instances.front().shapeType;
+            const RenderContext * pContext = &renderContext;
 
-    //camera setups
-    float angle = 0.0f;
+            pStreamer->request(pStreamed.get(), [pShader, pContext, shapeType, file = object.file]
+            {
+                auto pVertices = std::make_shared<std::vector<Mesh::Vertex>>(docadehedron::load(file));
+
+                return AssetStreamer::Prepared {
+                        pVertices->size() * sizeof(Mesh::Vertex),
+                        fillWith(pVertices),
+                        [pShader, pContext, shapeType, pVertices](GLuint buffer)
+                        {
+                            return std::make_unique<docadehedron>(pShader, std::move(*pVertices), glm::mat4(1.0f), shapeType, pContext, buffer);
+                        }
+                };
+            });
+
+            shapes.emplace_back(std::move(pStreamed));
+            break;
+        }
 
-     HorizontalCamera = new KeyFrameCamera(glm::vec3(0.0f, 5.0f, 10.0f), glm::quat());
+        case Type::kParametric:
+        case Type::kParametricBatch:
+        {
+            // Instances sharing a model matrix draw as one batch when tessellated on the GPU.
+            bool batched = object.type == Type::kParametricBatch && !useCpuTessellation;
 
-    glm::quat r = glm::quat_cast(glm::rotate(glm::mat4(1.0f), glm::radians(-40.0f), glm::vec3(0, 1, 0)));
-    glm::quat r2 = glm::quat_cast(glm::rotate(glm::mat4(1.0f), glm::radians(40.0f), glm::vec3(0, 1, 0)));
-    glm::quat r3 = glm::quat_cast(glm::rotate(glm::mat4(1.0f), glm::radians(130.0f), glm::vec3(0, 1, 0)));
-    glm::quat r4 = glm::quat_cast(glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0, 1, 0)));
+            for (const SceneFile::Instance & instance : object.instances)
+            {
+                batched = batched && instance.shapeType <= ParametricSurface::kSuperQuadric;
+            }
 
+            if (batched)
+            {
+                auto pBatch = std::make_unique<SphereBatch>(pSphereShader.get(), model);
 
+                for (const SceneFile::Instance & instance : object.instances)
+                {
+                    pBatch->add(instance.center, instance.radius, instance.color, instance.shapeType);
+                }
 
-    // Now push back frames with these quaternions
-    HorizontalCamera->pushBackFrame(glm::vec3(-20, 5, 15), r, 4);
-    HorizontalCamera->pushBackFrame(glm::vec3(20, 5, 20), r2, 7);
-    HorizontalCamera->pushBackFrame(glm::vec3(20, 5, -40), r3, 10);
-    HorizontalCamera->pushBackFrame(glm::vec3(0, 5, -40), r4, 10);
+                shapes.emplace_back(std::move(pBatch));
+                break;
+            }
 
+            for (const SceneFile::Instance & instance : object.instances)
+            {
+                shapes.emplace_back(
+                        makeParametricShape(
+                                instance.center,
+                                instance.radius,
+                                instance.color,
+                                model,
+                                instance.shapeType,
+                                level
+                        )
+                );
+            }
 
-    //vertical camera setup
-    VerticalCamera = new KeyFrameCamera(glm::vec3(0.0f, 1.0f, 20.0f), glm::quat());
+            break;
+        }
+    }
+}
 
-    glm::quat Vr = glm::quat_cast(glm::rotate(glm::mat4(1.0f), glm::radians(-40.0f),  glm::vec3(1, 0, 0)));
-    glm::quat Vr2 = glm::quat_cast(glm::rotate(glm::mat4(1.0f), glm::radians(-60.0f),  glm::vec3(1, 0, 0)));
-    glm::quat Vr3 = glm::quat_cast(glm::rotate(glm::mat4(1.0f), glm::radians(-60.0f), glm::vec3(1, 0, 0)));
-    glm::quat Vr4 = glm::quat_cast(glm::rotate(glm::mat4(1.0f), glm::radians(0.0f), glm::vec3(0,1, 0)));
 
+void App::refineMode(int mode)
+{
+    auto sceneMode = scene.modes.find(mode);
+    SceneResidency::Scene * pScene = pResidency->find(mode);
 
+    if (sceneMode == scene.modes.end() || !sceneMode->second.refinable || !pScene)
+    {
+        return;
+    }
 
-    // Now push back frames with these quaternions
-    VerticalCamera->pushBackFrame(glm::vec3(-10, 15, 15), Vr, 4);
-    VerticalCamera->pushBackFrame(glm::vec3(-10, 20, -5),  Vr2, 4);
-    VerticalCamera->pushBackFrame(glm::vec3(0, 5, -40), r4, 15);
-   // VerticalCamera->pushBackFrame(glm::vec3(-10, 20, -45), Vr4, 5);
+    if (0.0f < pScene->tessLevel)
+    {
+        pScene->tessLevel *= 2.0f;
+        setBakedLevel(pScene->shapes, pScene->tessLevel);
+    }
+
+    for (auto & s : pScene->shapes)
+    {
+        // Shapes still streaming in are not refined.
+        Renderable * pShape = s.get();
 
+        if (auto pStreamed = dynamic_cast<StreamedMesh *>(pShape))
+        {
+            pShape = pStreamed->loaded();
+        }
+
+        if (auto pIcosahedron = dynamic_cast<icosahedron *>(pShape))
+        {
+            pIcosahedron->subDivide();
+        }
+        else if (auto pDodecahedron = dynamic_cast<docadehedron *>(pShape))
+        {
+            pDodecahedron->subDivide();
+        }
+    }
 
+    pResidency->remeasure(mode);
 }
 
 
-void App::render()
+void App::beginFrame(Frame & frame)
 {
-    auto t = static_cast<float>(timeElapsedSinceLastFrame);
+    frame.timeElapsed = static_cast<float>(timeElapsedSinceLastFrame);
 
-    // Update shader uniforms.
     view = camera.getViewMatrix();
     projection = glm::perspective(glm::radians(camera.zoom),
                                   static_cast<GLfloat>(kWindowWidth) / static_cast<GLfloat>(kWindowHeight),
                                   0.01f,
                                   100.0f);
 
-    pLineShader->use();
-    if (UseFreeCamera)
-    {
-        pLineShader->setMat4("view", view);
-    }
-    else {
-        pLineShader->setMat4("view",(HorizontalCamer ? HorizontalCamera->GetView() : VerticalCamera->GetView()  ));
-    }
-    pLineShader->setMat4("projection", projection);
+    frame.pScene = pResidency->activate(RenderingMode);
+    const SceneFile::Mode * pSceneMode = frame.pScene ? &scene.modes.at(RenderingMode) : nullptr;
 
-    pMeshShader->use();
-    if (UseFreeCamera)
+    // The active keyframe camera is evaluated once here; GetView() and GetlerpedPosition() reuse it.
+    glm::mat4 cameraView = view;
+
+    if (!UseFreeCamera && pKeyFrameCamera)
     {
-        pMeshShader->setMat4("view", view);
-    }
-    else {
-        pMeshShader->setMat4("view", (HorizontalCamer ? HorizontalCamera->GetView() : VerticalCamera->GetView()));
+        pKeyFrameCamera->update();
+        cameraView = pKeyFrameCamera->GetView();
     }
 
-    pMeshShader->setMat4("projection", projection);
-    pMeshShader->setVec3("ViewPos", camera.position);
-    pMeshShader->setVec3("lightPos", lightPos);
-    pMeshShader->setVec3("lightColor", lightColor);
+    // Modes with a fixed tessellation level let the user raise it with "+"; elsewhere it follows on-screen size.
+    bool fixedTessLevel = frame.pScene && 0.0f < frame.pScene->tessLevel;
+    frame.tessLevelOuter = fixedTessLevel ? frame.pScene->tessLevel : 64.0f;
+    frame.tessPixelsPerEdge = fixedTessLevel ? 0.0f : kTessPixelsPerEdge;
+
+    int framebufferWidth;
+    int framebufferHeight;
+    glfwGetFramebufferSize(pWindow, &framebufferWidth, &framebufferHeight);
 
-    pSphereShader->use();
-    if (UseFreeCamera)
+    frame.context.view = cameraView;
+    frame.context.projection = projection;
+    frame.context.viewportSize = {static_cast<float>(framebufferWidth), static_cast<float>(framebufferHeight)};
+    frame.viewPos = camera.position;
+
+    if (pSceneMode)
     {
-        pSphereShader->setMat4("view", view);
-    }
-    else {
-        pSphereShader->setMat4("view", (HorizontalCamer ? HorizontalCamera->GetView() : VerticalCamera->GetView()));
+        lightPos = pSceneMode->lightPosition;
+        lightColor = pSceneMode->lightColor;
     }
 
-    pSphereShader->setMat4("projection", projection);
-    pSphereShader->setVec3("ViewPos", camera.position);
-    pSphereShader->setVec3("lightPos", lightPos);
-    pSphereShader->setVec3("lightColor", lightColor);
+    frame.lightPos = lightPos;
+    frame.lightColor = lightColor;
 
-    // Render.
-    if(RenderingMode == 1)
+    // Some modes light the parametric shapes from the keyframe camera.
+    frame.sphereLightPos = lightPos;
+
+    if (pSceneMode && pSceneMode->parametricLightFollowsCamera && pKeyFrameCamera)
     {
-        for (auto & s : shapes)
-        {
-            s->render(t);
-        }
+        frame.sphereLightPos = pKeyFrameCamera->GetlerpedPosition();
     }
+}
 
-    else if (RenderingMode == 2)
+
+void App::prepareFrame(Frame & frame)
+{
+    if (frame.pScene)
     {
-        for (auto& s : shapes_mode_2)
-        {
-            s->render(t);
-        }
+        frame.pScene->world.prepare(frame.context, frame.culled);
     }
-
-    else if (RenderingMode == 3)
+    else
     {
-        for (auto& s : shapes_mode_3)
-        {
-            s->render(t);
-        }
+        frame.culled.drawList.clear();
+        frame.culled.drawShapes.clear();
+        frame.culled.drawRadii.clear();
     }
+}
 
-    else if (RenderingMode == 4)
-    {
-        //reset Tesselation shader granularity for these shapes that dont use subdivision
-        pSphereShader->use();
-        pSphereShader->setFloat("tessLevelOuter", 64);
 
-        for (auto& s : shapes_mode_4)
-        {
-            s->render(t);
-        }
-    }
+void App::submitFrame(const Frame & frame)
+{
+    const glm::mat4 & cameraView = frame.context.view;
+    const glm::mat4 & frameProjection = frame.context.projection;
 
-    else if (RenderingMode == 5)
-    {
-        for (auto& s : shapes_mode_5)
-        {
-            s->render(t);
-        }
-    }
+    // Shapes culling their own meshlets read the view they are drawn with.
+    renderContext = frame.context;
 
-    else if (RenderingMode == 6)
-    {
-        for (auto& s : shapes_mode_6)
+    pLineShader->use();
+    pLineShader->setMat4("view", cameraView);
+    pLineShader->setMat4("projection", frameProjection);
+
+    // Mesh and sphere programs come in specialized variants (see Shader::variant), each of which
+    // needs its own copy of the per-frame uniforms. They are set when a variant is first bound
+    // this frame, so variants that are not drawn are neither updated nor waited for.
+    pMeshShader->setDefine("DISPLAY_MODE", displayMode);
+    pMeshShader->setFrameUniforms([cameraView, frameProjection, viewPos = frame.viewPos,
+                                   lightPos = frame.lightPos, lightColor = frame.lightColor](const Shader & shader)
+    {
+        shader.setMat4("view", cameraView);
+        shader.setMat4("projection", frameProjection);
+        shader.setVec3("ViewPos", viewPos);
+        shader.setVec3("lightPos", lightPos);
+        shader.setVec3("lightColor", lightColor);
+    });
+
+    if (pSphereShader)
+    {
+        pSphereShader->setDefine("DISPLAY_MODE", displayMode);
+        pSphereShader->setFrameUniforms([cameraView, frameProjection, viewPos = frame.viewPos,
+                                         lightPos = frame.sphereLightPos, lightColor = frame.lightColor,
+                                         tessLevelOuter = frame.tessLevelOuter,
+                                         tessPixelsPerEdge = frame.tessPixelsPerEdge,
+                                         viewportSize = frame.context.viewportSize](const Shader & shader)
         {
-            s->render(t);
-        }
+            shader.setMat4("view", cameraView);
+            shader.setMat4("projection", frameProjection);
+            shader.setVec3("ViewPos", viewPos);
+            shader.setVec3("lightPos", lightPos);
+            shader.setVec3("lightColor", lightColor);
+            shader.setFloat("tessLevelOuter", tessLevelOuter);
+            shader.setFloat("tessPixelsPerEdge", tessPixelsPerEdge);
+            shader.setFloat("tessMinLevel", kTessMinLevel);
+            shader.setFloat("tessMaxLevel", kTessMaxLevel);
+            shader.setVec2("viewportSize", viewportSize);
+        });
+    }
+    else
+    {
+        // Baked parametric shapes: same lighting as the tessellated ones, no tessellation state.
+        pParametricShader->setDefine("DISPLAY_MODE", displayMode);
+        pParametricShader->setFrameUniforms([cameraView, frameProjection, viewPos = frame.viewPos,
+                                             lightPos = frame.sphereLightPos, lightColor = frame.lightColor](const Shader & shader)
+        {
+            shader.setMat4("view", cameraView);
+            shader.setMat4("projection", frameProjection);
+            shader.setVec3("ViewPos", viewPos);
+            shader.setVec3("lightPos", lightPos);
+            shader.setVec3("lightColor", lightColor);
+        });
     }
 
+    // Render what survived culling, grouped by shader, at the detail its projected size calls for.
+    const RenderWorld::Frame & culled = frame.culled;
 
-    else if (RenderingMode == 7)
+    for (std::size_t i = 0; i != culled.drawList.size(); ++i)
     {
-        pSphereShader->setVec3("lightPos", (HorizontalCamer ? HorizontalCamera->GetlerpedPosition() : VerticalCamera->GetlerpedPosition()));
-
-
-        for (auto& s : shapes_mode_7)
+        if (culled.drawShapes[i])
         {
-            s->render(t);
+            culled.drawShapes[i]->setScreenRadius(culled.drawRadii[i]);
         }
+
+        culled.drawList[i]->render(frame.timeElapsed);
     }
 }
@@ -0,0 +1,146 @@
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+#include "app/AssetStreamer.h"
+#include "app/BufferUploader.h"
+#include "shape/StreamedMesh.h"
+
+
+AssetStreamer::AssetStreamer(std::size_t budgetBytes, BufferUploader * pUploader)
+        : budgetBytes(budgetBytes), pUploader(pUploader)
+{
+
+}
+
+
+AssetStreamer::~AssetStreamer() noexcept
+{
+    try
+    {
+        JobSystem::shared().wait(preparing);
+    }
+    catch (...)
+    {
+        // Failed loads nobody waits for any more.
+    }
+}
+
+
+void AssetStreamer::request(StreamedMesh * pTarget, Prepare prepare)
+{
+    ++requested;
+
+    std::weak_ptr<void> target = pTarget->lifetime();
+
+    JobSystem::shared().submitBackground([this, pTarget, target, prepare = std::move(prepare)]
+    {
+        Result result {pTarget, target, {}, nullptr};
+
+        // A mode released before its turn came needs no loading.
+        if (!target.expired())
+        {
+            try
+            {
+                result.prepared = prepare();
+            }
+            catch (...)
+            {
+                result.error = std::current_exception();
+            }
+        }
+
+        // Filled on the upload context; the shape is created once the GPU has the buffer.
+        if (pUploader && !result.error && result.prepared.fill)
+        {
+            std::size_t bytes = result.prepared.bytes;
+            auto fill = result.prepared.fill;
+            auto pResult = std::make_shared<Result>(std::move(result));
+
+            pUploader->upload(bytes, std::move(fill), [this, pResult](GLuint buffer)
+            {
+                deliver(*pResult, buffer);
+            });
+
+            return;
+        }
+
+        std::lock_guard lock(readyMutex);
+        ready.push_back(std::move(result));
+    }, &preparing);
+}
+
+
+void AssetStreamer::update()
+{
+    if (pUploader)
+    {
+        pUploader->poll();
+    }
+
+    std::vector<Result> arrived;
+
+    {
+        std::lock_guard lock(readyMutex);
+
+        if (ready.empty())
+        {
+            return;
+        }
+
+        std::swap(arrived, ready);
+    }
+
+    std::size_t uploaded = 0;
+    std::size_t next = 0;
+    std::exception_ptr error;
+
+    for (; next != arrived.size() && !error; ++next)
+    {
+        Result & result = arrived[next];
+
+        if (result.error || result.target.expired())
+        {
+            --requested;
+            error = result.error;
+            continue;
+        }
+
+        // The rest waits for the next frame.
+        if (uploaded != 0 && budgetBytes < uploaded + result.prepared.bytes)
+        {
+            break;
+        }
+
+        uploaded += result.prepared.bytes;
+        deliver(result, 0U);
+    }
+
+    // Back in front of anything that arrived meanwhile, keeping request order.
+    if (next != arrived.size())
+    {
+        std::lock_guard lock(readyMutex);
+        ready.insert(ready.begin(),
+                     std::make_move_iterator(arrived.begin() + static_cast<std::ptrdiff_t>(next)),
+                     std::make_move_iterator(arrived.end()));
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+
+void AssetStreamer::deliver(Result & result, GLuint buffer)
+{
+    --requested;
+
+    if (result.target.expired())
+    {
+        glDeleteBuffers(1, &buffer);
+        return;
+    }
+
+    result.pTarget->setLoaded(result.prepared.create(buffer));
+}
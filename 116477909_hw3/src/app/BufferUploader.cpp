@@ -0,0 +1,158 @@
+#include <stdexcept>
+#include <utility>
+
+#include <GLFW/glfw3.h>
+
+#include "app/BufferUploader.h"
+
+
+BufferUploader::BufferUploader(GLFWwindow * pShare)
+{
+    // The window only carries the context; the context hints of the main window still apply.
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    pContext = glfwCreateWindow(1, 1, "upload", nullptr, pShare);
+    glfwWindowHint(GLFW_VISIBLE, GL_TRUE);
+
+    if (!pContext)
+    {
+        throw std::runtime_error("BufferUploader: failed to create a shared GL context");
+    }
+
+    worker = std::thread(&BufferUploader::uploadLoop, this);
+}
+
+
+BufferUploader::~BufferUploader() noexcept
+{
+    {
+        std::lock_guard lock(mutex);
+        running = false;
+    }
+
+    wake.notify_one();
+    worker.join();
+
+    for (Upload & upload : fenced)
+    {
+        inFlight.push_back(std::move(upload));
+    }
+
+    for (Upload & upload : inFlight)
+    {
+        glDeleteSync(upload.fence);
+        glDeleteBuffers(1, &upload.buffer);
+    }
+
+    glfwDestroyWindow(pContext);
+}
+
+
+void BufferUploader::upload(std::size_t bytes, Fill fill, Done done)
+{
+    {
+        std::lock_guard lock(mutex);
+        requests.push_back({bytes, std::move(fill), std::move(done)});
+    }
+
+    wake.notify_one();
+}
+
+
+void BufferUploader::poll()
+{
+    {
+        std::lock_guard lock(mutex);
+
+        for (Upload & upload : fenced)
+        {
+            inFlight.push_back(std::move(upload));
+        }
+
+        fenced.clear();
+    }
+
+    // Hand over in order, stopping at the first upload still in flight.
+    std::size_t done = 0;
+
+    for (; done != inFlight.size(); ++done)
+    {
+        Upload & upload = inFlight[done];
+
+        if (glClientWaitSync(upload.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            break;
+        }
+
+        glDeleteSync(upload.fence);
+        upload.fence = nullptr;
+    }
+
+    std::vector<Upload> finished(std::make_move_iterator(inFlight.begin()),
+                                 std::make_move_iterator(inFlight.begin() + static_cast<std::ptrdiff_t>(done)));
+    inFlight.erase(inFlight.begin(), inFlight.begin() + static_cast<std::ptrdiff_t>(done));
+
+    for (Upload & upload : finished)
+    {
+        upload.done(upload.buffer);
+    }
+}
+
+
+void BufferUploader::uploadLoop()
+{
+    glfwMakeContextCurrent(pContext);
+
+    std::unique_lock lock(mutex);
+
+    while (true)
+    {
+        wake.wait(lock, [this] { return !requests.empty() || !running; });
+
+        // Requests still queued at shutdown are dropped with their buffers.
+        if (!running)
+        {
+            break;
+        }
+
+        Request request = std::move(requests.front());
+        requests.pop_front();
+        lock.unlock();
+
+        GLuint buffer = 0U;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(request.bytes), nullptr, GL_STATIC_DRAW);
+
+        void * pMapped = request.bytes == 0 ? nullptr : glMapBufferRange(GL_COPY_WRITE_BUFFER,
+                                                                        0,
+                                                                        static_cast<GLsizeiptr>(request.bytes),
+                                                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+        if (pMapped)
+        {
+            request.fill(pMapped);
+
+            // GL_FALSE: a display event corrupted the store while mapped; fill it again below.
+            pMapped = glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_TRUE ? pMapped : nullptr;
+        }
+
+        if (!pMapped && request.bytes != 0)
+        {
+            std::vector<unsigned char> staging(request.bytes);
+            request.fill(staging.data());
+            glBufferSubData(GL_COPY_WRITE_BUFFER, 0, static_cast<GLsizeiptr>(request.bytes), staging.data());
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0U);
+
+        // Flushed so the fence reaches the GPU without this context issuing anything else.
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        lock.lock();
+        fenced.push_back({buffer, fence, std::move(request.done)});
+    }
+
+    lock.unlock();
+    glfwMakeContextCurrent(nullptr);
+}
@@ -0,0 +1,336 @@
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "app/SceneFile.h"
+#include "shape/ParametricSurface.h"
+#include "util/Json.h"
+
+
+namespace
+{
+
+[[noreturn]] void invalid(const Json & value, const std::string & message)
+{
+    throw std::runtime_error(value.path() + ": " + message);
+}
+
+
+glm::vec3 vec3(const Json & value)
+{
+    if (value.size() != 3)
+    {
+        invalid(value, "expected [x, y, z]");
+    }
+
+    return {value[0].asFloat(), value[1].asFloat(), value[2].asFloat()};
+}
+
+
+glm::vec3 vec3(const Json & object, const std::string & key, const glm::vec3 & fallback)
+{
+    const Json * pValue = object.find(key);
+    return pValue ? vec3(*pValue) : fallback;
+}
+
+
+// {"angle": degrees, "axis": [x, y, z]}
+glm::quat rotation(const Json & value)
+{
+    glm::vec3 axis = vec3(value["axis"]);
+
+    if (glm::length(axis) == 0.0f)
+    {
+        invalid(value["axis"], "rotation axis must not be zero");
+    }
+
+    return glm::angleAxis(glm::radians(value["angle"].asFloat()), glm::normalize(axis));
+}
+
+
+SceneGraph::Transform transform(const Json & object)
+{
+    const Json * pTransform = object.find("transform");
+    SceneGraph::Transform result;
+
+    if (!pTransform)
+    {
+        return result;
+    }
+
+    result.translation = vec3(*pTransform, "translate", result.translation);
+
+    if (const Json * pRotate = pTransform->find("rotate"))
+    {
+        result.rotation = rotation(*pRotate);
+    }
+
+    if (const Json * pScale = pTransform->find("scale"))
+    {
+        result.scale = pScale->isNumber() ? glm::vec3(pScale->asFloat()) : vec3(*pScale);
+    }
+
+    return result;
+}
+
+
+int shapeType(const Json & value)
+{
+    if (value.isNumber())
+    {
+        int type = value.asInt();
+
+        if (type < ParametricSurface::kSphere || ParametricSurface::kPentagon < type)
+        {
+            invalid(value, "unknown shape type " + std::to_string(type));
+        }
+
+        return type;
+    }
+
+    static const std::pair<const char *, int> kNames[] {
+        {"sphere", ParametricSurface::kSphere},
+        {"cylinder", ParametricSurface::kCylinder},
+        {"cone", ParametricSurface::kCone},
+        {"torus", ParametricSurface::kTorus},
+        {"superquadric", ParametricSurface::kSuperQuadric},
+        {"pentagon", ParametricSurface::kPentagon},
+    };
+
+    for (const auto & [name, type] : kNames)
+    {
+        if (value.asString() == name)
+        {
+            return type;
+        }
+    }
+
+    invalid(value, "unknown shape type \"" + value.asString() + "\"");
+}
+
+
+SceneFile::Instance instance(const Json & value)
+{
+    SceneFile::Instance result;
+    result.center = vec3(value, "center", result.center);
+    result.radius = value.get("radius", result.radius);
+    result.color = vec3(value, "color", result.color);
+    result.shapeType = shapeType(value["shape"]);
+
+    return result;
+}
+
+
+// Appends the object and its children, depth-first.
+void object(const Json & value, int parent, std::vector<SceneFile::Object> & objects)
+{
+    using Type = SceneFile::Object::Type;
+
+    static const std::pair<const char *, Type> kTypes[] {
+        {"group", Type::kGroup},
+        {"line", Type::kLine},
+        {"box", Type::kBox},
+        {"mesh", Type::kMesh},
+        {"icosphere", Type::kIcosphere},
+        {"dodecahedron", Type::kSubdivisionMesh},
+        {"parametric", Type::kParametric},
+        {"parametricBatch", Type::kParametricBatch},
+    };
+
+    const Json & typeName = value["type"];
+    SceneFile::Object result;
+    bool known = false;
+
+    for (const auto & [name, type] : kTypes)
+    {
+        if (typeName.asString() == name)
+        {
+            result.type = type;
+            known = true;
+        }
+    }
+
+    if (!known)
+    {
+        invalid(typeName, "unknown object type \"" + typeName.asString() + "\"");
+    }
+
+    result.transform = transform(value);
+    result.parent = parent;
+    result.color = vec3(value, "color", result.color);
+    result.level = value.get("level", result.level);
+
+    switch (result.type)
+    {
+        case Type::kGroup:
+            break;
+        case Type::kLine:
+            for (const Json & vertex : value["vertices"].items())
+            {
+                result.lineVertices.push_back({vec3(vertex["position"]), vec3(vertex, "color", glm::vec3(1.0f))});
+            }
+            break;
+        case Type::kBox:
+            result.compressed = value.get("compressed", result.compressed);
+            break;
+        case Type::kIcosphere:
+            result.scale = vec3(value, "scale", result.scale);
+            result.crossFade = value.get("crossFade", result.crossFade);
+            result.file = value["file"].asString();
+            break;
+        case Type::kSubdivisionMesh:
+            result.instances.push_back({});
+            result.instances.back().shapeType = shapeType(value["shape"]);
+            result.file = value["file"].asString();
+            break;
+        case Type::kMesh:
+            result.compressed = value.get("compressed", result.compressed);
+            result.lod = value.get("lod", result.lod);
+            result.crossFade = value.get("crossFade", result.crossFade);
+            result.file = value["file"].asString();
+
+            if (result.compressed && result.lod)
+            {
+                invalid(value, "LOD meshes cannot be compressed");
+            }
+            break;
+        case Type::kParametric:
+            result.instances.push_back(instance(value));
+            break;
+        case Type::kParametricBatch:
+            for (const Json & entry : value["instances"].items())
+            {
+                result.instances.push_back(instance(entry));
+            }
+            break;
+    }
+
+    auto index = static_cast<int>(objects.size());
+    objects.push_back(std::move(result));
+
+    if (const Json * pChildren = value.find("children"))
+    {
+        for (const Json & child : pChildren->items())
+        {
+            object(child, index, objects);
+        }
+    }
+}
+
+
+SceneFile::Mode mode(const Json & value, const SceneFile::Mode & defaults)
+{
+    SceneFile::Mode result = defaults;
+
+    if (const Json * pLight = value.find("light"))
+    {
+        result.lightPosition = vec3(*pLight, "position", result.lightPosition);
+        result.lightColor = vec3(*pLight, "color", result.lightColor);
+    }
+
+    result.parametricLightFollowsCamera = value.get("parametricLightFollowsCamera", false);
+    result.cameraPath = value.get("cameraPath", "");
+    result.tessLevel = value.get("tessLevel", 0.0f);
+    result.refinable = value.get("refinable", false);
+
+    for (const Json & entry : value["objects"].items())
+    {
+        object(entry, -1, result.objects);
+    }
+
+    return result;
+}
+
+
+SceneFile::CameraPath cameraPath(const Json & value)
+{
+    SceneFile::CameraPath result;
+    result.position = vec3(value["position"]);
+
+    if (const Json * pRotate = value.find("rotate"))
+    {
+        result.rotation = rotation(*pRotate);
+    }
+
+    result.constantSpeed = value.get("constantSpeed", result.constantSpeed);
+
+    for (const Json & entry : value["frames"].items())
+    {
+        SceneFile::CameraPath::Frame frame;
+        frame.position = vec3(entry["position"]);
+        frame.rotation = rotation(entry["rotate"]);
+        frame.duration = entry["duration"].asFloat();
+
+        if (!(0.0f < frame.duration))
+        {
+            invalid(entry["duration"], "duration must be positive");
+        }
+
+        result.frames.push_back(frame);
+    }
+
+    return result;
+}
+
+}  // namespace
+
+
+SceneFile SceneFile::load(const std::string & file)
+{
+    Json document = Json::load(file);
+    SceneFile scene;
+
+    try
+    {
+        Mode defaults;
+
+        if (const Json * pLight = document.find("light"))
+        {
+            defaults.lightPosition = vec3(*pLight, "position", defaults.lightPosition);
+            defaults.lightColor = vec3(*pLight, "color", defaults.lightColor);
+        }
+
+        if (const Json * pPaths = document.find("cameraPaths"))
+        {
+            for (const auto & [name, value] : pPaths->members())
+            {
+                scene.cameraPaths[name] = cameraPath(value);
+            }
+        }
+
+        for (const auto & [key, value] : document["modes"].members())
+        {
+            if (key.empty() || key.size() > 4 || !std::all_of(key.begin(), key.end(), [](unsigned char c) { return std::isdigit(c); }))
+            {
+                invalid(value, "mode names must be numbers");
+            }
+
+            Mode & entry = scene.modes[std::stoi(key)] = mode(value, defaults);
+
+            if (!entry.cameraPath.empty() && !scene.cameraPaths.count(entry.cameraPath))
+            {
+                invalid(value, "unknown camera path \"" + entry.cameraPath + "\"");
+            }
+        }
+
+        scene.initialMode = scene.modes.empty() ? 1 : scene.modes.begin()->first;
+
+        if (const Json * pInitial = document.find("initialMode"))
+        {
+            scene.initialMode = pInitial->asInt();
+
+            if (!scene.modes.count(scene.initialMode))
+            {
+                invalid(*pInitial, "no mode " + std::to_string(scene.initialMode) + " in \"modes\"");
+            }
+        }
+    }
+    catch (const std::runtime_error & e)
+    {
+        throw std::runtime_error(file + ": " + e.what());
+    }
+
+    return scene;
+}
@@ -0,0 +1,277 @@
+#include <algorithm>
+
+#ifdef DEBUG_RESIDENCY
+#include <iostream>
+#endif  // DEBUG_RESIDENCY
+
+#include "app/SceneResidency.h"
+#include "shape/GLShape.h"
+#include "shape/StreamedMesh.h"
+
+
+SceneResidency::SceneResidency(const SceneFile & sceneFile, std::size_t budgetBytes, float level, ObjectFactory factory)
+        : sceneFile(sceneFile), budgetBytes(budgetBytes), level(level), factory(std::move(factory))
+{
+
+}
+
+
+SceneResidency::Scene * SceneResidency::activate(int mode)
+{
+    if (mode != activeMode && activeMode != -1)
+    {
+        ++transitions[{activeMode, mode}];
+    }
+
+    activeMode = mode;
+
+    auto sceneMode = sceneFile.modes.find(mode);
+
+    if (sceneMode == sceneFile.modes.end())
+    {
+        return nullptr;
+    }
+
+    Scene & scene = entry(mode);
+    scene.lastUsed = ++activations;
+
+    if (scene.loadedObjects != sceneMode->second.objects.size())
+    {
+        while (scene.loadedObjects != sceneMode->second.objects.size())
+        {
+            loadObject(mode, scene);
+        }
+
+        evict();
+    }
+
+    // Only subtrees moved since the last frame are recomputed.
+    scene.graph.update();
+
+    if (!scene.graph.changed().empty())
+    {
+        std::vector<bool> moved(scene.graph.size(), false);
+
+        for (SceneGraph::NodeId node : scene.graph.changed())
+        {
+            moved[node] = true;
+        }
+
+        for (const auto & [node, entity] : scene.placed)
+        {
+            if (moved[node])
+            {
+                scene.world.setTransform(entity, scene.graph.world(node));
+            }
+        }
+    }
+
+    return &scene;
+}
+
+
+SceneResidency::Scene & SceneResidency::entry(int mode)
+{
+    auto [it, inserted] = scenes.try_emplace(mode);
+    Scene & scene = it->second;
+
+    if (inserted)
+    {
+        const SceneFile::Mode & sceneMode = sceneFile.modes.at(mode);
+        scene.tessLevel = sceneMode.tessLevel;
+
+        for (const SceneFile::Object & object : sceneMode.objects)
+        {
+            // Parents precede their children in the file's depth-first order.
+            SceneGraph::NodeId parent = object.parent < 0 ? SceneGraph::kNone : scene.nodes[object.parent];
+            scene.nodes.push_back(scene.graph.create(parent, object.transform));
+        }
+
+        scene.graph.update();
+    }
+
+    return scene;
+}
+
+
+SceneResidency::Scene * SceneResidency::find(int mode)
+{
+    auto it = scenes.find(mode);
+    return it != scenes.end() && it->second.loadedObjects != 0 ? &it->second : nullptr;
+}
+
+
+void SceneResidency::remeasure(int mode)
+{
+    Scene * pScene = find(mode);
+
+    if (!pScene)
+    {
+        return;
+    }
+
+    std::size_t bytes = 0;
+
+    for (const auto & s : pScene->shapes)
+    {
+        bytes += s->gpuBytes();
+    }
+
+    for (const auto & [node, entity] : pScene->placed)
+    {
+        pScene->world.refreshBounds(entity);
+    }
+
+    setBytes(*pScene, bytes);
+    evict();
+}
+
+
+void SceneResidency::prefetch()
+{
+    if (budgetBytes <= totalBytes)
+    {
+        return;
+    }
+
+    // Successors of the active mode seen so far, most frequent first, then its neighbours.
+    std::vector<std::pair<unsigned, int>> seen;
+
+    for (const auto & [transition, count] : transitions)
+    {
+        if (transition.first == activeMode)
+        {
+            seen.emplace_back(count, transition.second);
+        }
+    }
+
+    std::sort(seen.begin(), seen.end(), std::greater<>());
+
+    std::vector<int> candidates;
+
+    for (const auto & entry : seen)
+    {
+        candidates.push_back(entry.second);
+    }
+
+    candidates.push_back(activeMode + 1);
+    candidates.push_back(activeMode - 1);
+
+    for (int mode : candidates)
+    {
+        auto sceneMode = sceneFile.modes.find(mode);
+
+        if (mode == activeMode || sceneMode == sceneFile.modes.end())
+        {
+            continue;
+        }
+
+        Scene & scene = entry(mode);
+
+        if (scene.loadedObjects == sceneMode->second.objects.size())
+        {
+            continue;
+        }
+
+        // A mode evicted before is known to need at least peakGpuBytes.
+        if (budgetBytes < totalBytes - scene.gpuBytes + scene.peakGpuBytes)
+        {
+            continue;
+        }
+
+        loadObject(mode, scene);
+        evict();
+
+        return;
+    }
+}
+
+
+void SceneResidency::update()
+{
+    std::set<int> modes;
+    std::swap(modes, streamed);
+
+    for (int mode : modes)
+    {
+        remeasure(mode);
+    }
+}
+
+
+void SceneResidency::loadObject(int mode, Scene & scene)
+{
+    const SceneFile::Object & object = sceneFile.modes.at(mode).objects[scene.loadedObjects];
+
+    // Modes with a fixed level bake at it; elsewhere the shapes adapt to their on-screen size.
+    float objectLevel = 0.0f < object.level ? object.level : (0.0f < scene.tessLevel ? scene.tessLevel : level);
+
+    SceneGraph::NodeId node = scene.nodes[scene.loadedObjects];
+
+    std::size_t first = scene.shapes.size();
+    factory(object, scene.graph.world(node), objectLevel, scene.shapes);
+    ++scene.loadedObjects;
+
+    std::size_t bytes = scene.gpuBytes;
+
+    for (std::size_t i = first; i != scene.shapes.size(); ++i)
+    {
+        Renderable * pRenderable = scene.shapes[i].get();
+        bytes += pRenderable->gpuBytes();
+
+        if (auto pStreamed = dynamic_cast<StreamedMesh *>(pRenderable))
+        {
+            pStreamed->onLoaded = [this, mode] { streamed.insert(mode); };
+        }
+
+        RenderWorld::Entity entity = scene.world.create(pRenderable,
+                                                        dynamic_cast<GLShape *>(pRenderable),
+                                                        scene.graph.world(node));
+        scene.placed.emplace_back(node, entity);
+    }
+
+    setBytes(scene, bytes);
+}
+
+
+void SceneResidency::evict()
+{
+    while (budgetBytes < totalBytes)
+    {
+        auto victim = scenes.end();
+
+        for (auto it = scenes.begin(); it != scenes.end(); ++it)
+        {
+            if (it->first != activeMode && it->second.loadedObjects != 0 &&
+                (victim == scenes.end() || it->second.lastUsed < victim->second.lastUsed))
+            {
+                victim = it;
+            }
+        }
+
+        if (victim == scenes.end())
+        {
+            return;
+        }
+
+#ifdef DEBUG_RESIDENCY
+        std::cout << "Releasing mode " << victim->first << " (" << victim->second.gpuBytes / 1024 << " KiB), "
+                  << "over the GPU budget of " << budgetBytes / 1024 << " KiB\n";
+#endif  // DEBUG_RESIDENCY
+
+        Scene & scene = victim->second;
+        scene.placed.clear();
+        scene.world.clear();
+        scene.shapes.clear();
+        scene.loadedObjects = 0;
+        setBytes(scene, 0);
+    }
+}
+
+
+void SceneResidency::setBytes(Scene & scene, std::size_t bytes)
+{
+    totalBytes = totalBytes - scene.gpuBytes + bytes;
+    scene.gpuBytes = bytes;
+    scene.peakGpuBytes = std::max(scene.peakGpuBytes, bytes);
+}
@@ -2,7 +2,12 @@
 
 // The "a" prefix stands for "attribute".
 layout (location = 0) in vec3 aPosition;
+#ifdef COMPRESSED_VERTEX
+// Mesh::CompressedVertex: position normalized to the mesh box, octahedral normal.
+layout (location = 1) in vec2 aNormal;
+#else
 layout (location = 1) in vec3 aNormal;
+#endif
 layout (location = 2) in vec3 aColor;
 
 // These out variables will be passed along the pipeline
@@ -16,27 +21,63 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// transpose(inverse(mat3(model))), computed once per object on the CPU.
+uniform mat3 normalMatrix;
+
+#ifdef COMPRESSED_VERTEX
+// Object-space box the positions were quantized to.
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+    float fold = max(-n.z, 0.0f);
+    n.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(n.xy, vec2(0.0f)));
+    return normalize(n);
+}
+#endif
+
 
 uniform vec3 viewPos;
 uniform vec3 lightPos;
 uniform vec3 lightColor;
 
+// Only the Gouraud mode (1) needs per-vertex lighting.
+// Variants compiled with DISPLAY_MODE defined drop it entirely.
+#ifdef DISPLAY_MODE
+const int displayMode = DISPLAY_MODE;
+#else
+uniform int displayMode;
+#endif
+
 out vec4 LightColor;
 
 
 void main()
 {
-
-    gl_Position = projection * view * model * vec4(aPosition, 1.0f);
-    ourFragPos = vec3(model * vec4(aPosition, 1.0f));
-    ourNormal = vec3(transpose(inverse(model)) * vec4(aNormal, 1.0f));
+#ifdef COMPRESSED_VERTEX
+    vec3 position = positionOffset + aPosition * positionScale;
+    vec3 normal = decodeOctahedral(aNormal);
+#else
+    vec3 position = aPosition;
+    vec3 normal = aNormal;
+#endif
+
+    vec4 worldPos = model * vec4(position, 1.0f);
+
+    gl_Position = projection * view * worldPos;
+    ourFragPos = vec3(worldPos);
+    ourNormal = normalMatrix * normal;
     ourColor = aColor;
 
+    if (displayMode != 1)
+    {
+        LightColor = vec4(0.0f);
+        return;
+    }
 
-
-
-
-    
     // ambient
     float ambientStrength = 0.1f;
     vec3 ambient = ambientStrength * lightColor;
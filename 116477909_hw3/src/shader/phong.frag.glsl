@@ -12,11 +12,44 @@ uniform vec3 lightPos;
 uniform vec3 lightColor;
 
 
+// Variants compiled with DISPLAY_MODE defined drop the per-fragment branch.
+#ifdef DISPLAY_MODE
+const int displayMode = DISPLAY_MODE;
+#else
 uniform int displayMode;
+#endif
+
+
+// LodMesh cross-fade: the incoming level keeps the share lodFade of the pixels in a 4x4 ordered
+// dither, the outgoing one (lodFadeOut) the rest, so the two never overlap or leave holes.
+#ifdef LOD_FADE
+uniform float lodFade;
+uniform int lodFadeOut;
+
+bool ditheredAway()
+{
+    const float bayer[16] = float[16](0.0f, 8.0f, 2.0f, 10.0f,
+                                      12.0f, 4.0f, 14.0f, 6.0f,
+                                      3.0f, 11.0f, 1.0f, 9.0f,
+                                      15.0f, 7.0f, 13.0f, 5.0f);
+
+    ivec2 cell = ivec2(gl_FragCoord.xy) & 3;
+    float threshold = (bayer[cell.y * 4 + cell.x] + 0.5f) / 16.0f;
+
+    return (threshold < lodFade) == (lodFadeOut != 0);
+}
+#endif
 
 
 void main()
 {
+#ifdef LOD_FADE
+    if (ditheredAway())
+    {
+        discard;
+    }
+#endif
+
 
 
 
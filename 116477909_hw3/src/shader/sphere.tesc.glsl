@@ -1,25 +1,170 @@
 #version 410
 
-layout (vertices = 1) out;
+// One patch covers the parameter sub-range between its 4 corners:
+// (u0, v0), (u1, v0), (u1, v1), (u0, v1).
+layout (vertices = 4) out;
 
 
+// Fixed level per unit of parameter, used when adaptive tessellation is off (tessPixelsPerEdge <= 0).
+// A patch spanning a quarter of u gets a quarter of the segments, so the whole surface still gets tessLevelOuter.
 uniform float tessLevelOuter;
 
+// Adaptive tessellation: pick each edge's level so that its segments are about
+// tessPixelsPerEdge pixels long on screen, clamped to [tessMinLevel, tessMaxLevel].
+uniform float tessPixelsPerEdge;
+uniform float tessMinLevel;
+uniform float tessMaxLevel;
+uniform vec2 viewportSize;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
 in vec3 tessPosition[];
+in vec2 tessUv[];
+in vec4 tessBound[];
+
 out vec3 tessControlPosition[];
+patch out vec4 patchUvRange;  // (u0, v0, u1, v1)
+
+#ifdef SPHERE_BATCH
+in vec4 tessCenterRadius[];
+in vec4 tessColorMinorRadius[];
+in float tessBoundingRadius[];
+
+patch out vec4 patchCenterRadius;
+patch out vec4 patchColorMinorRadius;
+#endif
+
+const float kPi = 3.14159265358979323846f;
+
+
+// Largest axis scale of the model matrix, keeps bounds conservative under non-uniform scaling.
+float modelScale()
+{
+    return max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+}
+
+
+#ifdef SPHERE_BATCH
+// Level of the edge between corners a and b of an instanced shape. Corner positions are not
+// known here, so the level follows the on-screen size of the whole instance times the
+// parametric span of the edge; both are the same for the two patches sharing the edge.
+float edgeLevel(mat4 modelView, int a, int b)
+{
+    float span = length(tessUv[a] - tessUv[b]);
+
+    if (tessPixelsPerEdge <= 0.0f)
+    {
+        return max(1.0f, tessLevelOuter * span);
+    }
+
+    float r = tessBoundingRadius[0] * modelScale();
+    float depth = -(modelView * vec4(tessCenterRadius[0].xyz, 1.0f)).z;
+
+    if (depth <= r)
+    {
+        return tessMaxLevel;
+    }
+
+    // Projected circumference in pixels, the share of it this edge covers.
+    float pixels = kPi * r * projection[1][1] * viewportSize.y / depth;
+
+    return clamp(pixels * span / tessPixelsPerEdge, tessMinLevel, tessMaxLevel);
+}
+#else
+// Level of the edge between corners a and b. It only depends on the edge itself
+// (and symmetrically on its two corners), so the neighbouring patch sharing it
+// computes the same level and no cracks open between them.
+float edgeLevel(mat4 modelView, int a, int b)
+{
+    if (tessPixelsPerEdge <= 0.0f)
+    {
+        return max(1.0f, tessLevelOuter * length(tessUv[a] - tessUv[b]));
+    }
+
+    vec3 pa = vec3(modelView * vec4(tessPosition[a], 1.0f));
+    vec3 pb = vec3(modelView * vec4(tessPosition[b], 1.0f));
+
+    float halfLength = 0.5f * length(pa - pb);
+    float depth = -0.5f * (pa.z + pb.z);
+
+    // Camera at (or in front of) the edge: no meaningful projection, use full detail.
+    if (depth <= halfLength)
+    {
+        return tessMaxLevel;
+    }
+
+    // Projected edge length in pixels.
+    float pixels = halfLength * projection[1][1] * viewportSize.y / depth;
+
+    return clamp(pixels / tessPixelsPerEdge, tessMinLevel, tessMaxLevel);
+}
+#endif
+
+
+// True if the object-space sphere (center, radius) is entirely outside the (symmetric perspective) view frustum.
+bool outsideFrustum(mat4 modelView, vec3 center, float radius)
+{
+    float r = radius * modelScale();
+    vec3 c = vec3(modelView * vec4(center, 1.0f));
+
+    // behind the eye
+    if (r < c.z)
+    {
+        return true;
+    }
+
+    // Side planes: |P00 * x| <= -z and |P11 * y| <= -z, as signed distances.
+    float px = projection[0][0];
+    float py = projection[1][1];
+
+    return (-c.z - px * abs(c.x)) * inversesqrt(px * px + 1.0f) < -r ||
+           (-c.z - py * abs(c.y)) * inversesqrt(py * py + 1.0f) < -r;
+}
+
 
 void main()
 {
-    gl_TessLevelOuter[0] = tessLevelOuter;
-    gl_TessLevelOuter[1] = tessLevelOuter;
-    gl_TessLevelOuter[2] = tessLevelOuter;
-    gl_TessLevelOuter[3] = tessLevelOuter;
+    if (gl_InvocationID == 0)
+    {
+        mat4 modelView = view * model;
+
+#ifdef SPHERE_BATCH
+        // Cull whole instances; all of their patches take this branch alike.
+        bool culled = outsideFrustum(modelView, tessCenterRadius[0].xyz, tessBoundingRadius[0]);
+#else
+        bool culled = outsideFrustum(modelView, tessBound[0].xyz, tessBound[0].w);
+#endif
+
+        if (culled)
+        {
+            // A zero outer level discards the patch.
+            gl_TessLevelOuter[0] = 0.0f;
+            gl_TessLevelOuter[1] = 0.0f;
+            gl_TessLevelOuter[2] = 0.0f;
+            gl_TessLevelOuter[3] = 0.0f;
+        }
+        else
+        {
+            gl_TessLevelOuter[0] = edgeLevel(modelView, 0, 3);  // u = u0
+            gl_TessLevelOuter[1] = edgeLevel(modelView, 0, 1);  // v = v0
+            gl_TessLevelOuter[2] = edgeLevel(modelView, 1, 2);  // u = u1
+            gl_TessLevelOuter[3] = edgeLevel(modelView, 3, 2);  // v = v1
+
+            gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+            gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
+        }
 
-    gl_TessLevelInner[0] = tessLevelOuter;
-    gl_TessLevelInner[1] = tessLevelOuter;
+        patchUvRange = vec4(tessUv[0], tessUv[2]);
 
+#ifdef SPHERE_BATCH
+        patchCenterRadius = tessCenterRadius[0];
+        patchColorMinorRadius = tessColorMinorRadius[0];
+#endif
+    }
 
-     tessControlPosition[gl_InvocationID] = tessPosition[gl_InvocationID];
+    tessControlPosition[gl_InvocationID] = tessPosition[gl_InvocationID];
     gl_out[gl_InvocationID].gl_Position = gl_in[gl_InvocationID].gl_Position;
 }
 
@@ -9,12 +9,31 @@ out vec3 ourColor;
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
-
+uniform mat3 normalMatrix;
+
+// Per-shape parameters: uniforms for a single Sphere, per-patch inputs for a SphereBatch.
+#ifdef SPHERE_BATCH
+patch in vec4 patchCenterRadius;
+patch in vec4 patchColorMinorRadius;
+
+// Set from the patch inputs at the top of main(); globals cannot be initialized from inputs.
+vec3 center;
+float radius;
+float minorradius;
+vec3 color;
+#else
 uniform vec3 center;
 uniform float radius;
 uniform float minorradius; //for toruses
 uniform vec3 color;
-uniform int shapeType;  // 0 = sphere, 1 = cylinder, 2 = cone
+#endif
+// 0 = sphere, 1 = cylinder, 2 = cone, 3 = torus, 4 = superquadric, 5 = pentagon.
+// Variants compiled with SHAPE_TYPE defined drop the per-vertex branch.
+#ifdef SHAPE_TYPE
+const int shapeType = SHAPE_TYPE;
+#else
+uniform int shapeType;
+#endif
 
 const float kPi = 3.14159265358979323846f;
 
@@ -23,6 +42,7 @@ float n1 = 1.0f, n2 = 1.0f;
 float v_max = 1.250f;
 
 in vec3 tessControlPosition[];
+patch in vec4 patchUvRange;  // parameter sub-range (u0, v0, u1, v1) covered by this patch
 
 float power(float base, float exp)
 {
@@ -34,14 +54,21 @@ void main()
 {
     vec4 WC = gl_in[0].gl_Position;
 
-    // Parametric coordinates
-    float u = gl_TessCoord.x;
-    float v = gl_TessCoord.y;
+#ifdef SPHERE_BATCH
+    center = patchCenterRadius.xyz;
+    radius = patchCenterRadius.w;
+    minorradius = patchColorMinorRadius.w;
+    color = patchColorMinorRadius.rgb;
+#endif
+
+    // Parametric coordinates, mapped from the patch into its sub-range of the whole surface
+    float u = mix(patchUvRange.x, patchUvRange.z, gl_TessCoord.x);
+    float v = mix(patchUvRange.y, patchUvRange.w, gl_TessCoord.y);
 
     vec3 pos;
 
-    float theta = (gl_TessCoord.x * 2.0 * kPi);
-    float t = gl_TessCoord.y;  // Height along the cylinder (0 to 1)
+    float theta = (u * 2.0 * kPi);
+    float t = v;  // Height along the cylinder (0 to 1)
 
 
     if (shapeType == 0) 
@@ -96,8 +123,8 @@ void main()
     }
     else if (shapeType == 3)
     {
-        float Xangle = gl_TessCoord.x * 2.0f * kPi;
-        float Zangle = gl_TessCoord.y * 2.0f * kPi;
+        float Xangle = u * 2.0f * kPi;
+        float Zangle = v * 2.0f * kPi;
 
         pos.x = (radius + minorradius * cos(Zangle)) * cos(Xangle);
         pos.y = (radius + minorradius * cos(Zangle)) * sin(Xangle);
@@ -107,8 +134,8 @@ void main()
     }
     else if (shapeType == 4)
     {
-        float Su = mix(0.0, 2.0 * kPi, gl_TessCoord.x);
-        float Sv = mix(-v_max, v_max, gl_TessCoord.y);
+        float Su = mix(0.0, 2.0 * kPi, u);
+        float Sv = mix(-v_max, v_max, v);
 
         // Evaluate parametric equations
         pos.x = a_x * power(cosh(Sv), n1) * power(cos(Su), n2);
@@ -145,7 +172,7 @@ void main()
 
     ourFragPos = vec3(model * vec4(pos, 1.0f));
 
-    ourNormal = normalize(pos - center);
+    ourNormal = normalMatrix * normalize(pos - center);
 
     ourColor = color;
 }
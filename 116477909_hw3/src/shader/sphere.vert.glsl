@@ -1,12 +1,39 @@
 #version 410 core
 
-layout (location = 0) in vec3 position;
+// One corner of a parameter-space patch, see Sphere::PatchVertex.
+layout (location = 0) in vec3 aPosition;  // surface point at this corner, object space
+layout (location = 1) in vec2 aUv;        // parameters of this corner
+layout (location = 2) in vec4 aBound;     // bounding sphere of the whole patch, object space
+
 out vec3 tessPosition;
+out vec2 tessUv;
+out vec4 tessBound;
+
+// SphereBatch: per-instance shape parameters (attribute divisor 1), see SphereBatch::Instance.
+// Corner positions and patch bounds are then those of a unit sphere and go unused.
+#ifdef SPHERE_BATCH
+layout (location = 3) in vec4 aCenterRadius;         // center xyz, radius
+layout (location = 4) in vec4 aColorMinorRadius;     // color rgb, minorradius
+layout (location = 5) in float aBoundingRadius;      // around center, see ParametricSurface::boundingRadius
+
+out vec4 tessCenterRadius;
+out vec4 tessColorMinorRadius;
+out float tessBoundingRadius;
+#endif
 
 void main()
 {
-    tessPosition = position;
-    gl_Position = vec4(position, 1.0f);
+    tessPosition = aPosition;
+    tessUv = aUv;
+    tessBound = aBound;
+
+#ifdef SPHERE_BATCH
+    tessCenterRadius = aCenterRadius;
+    tessColorMinorRadius = aColorMinorRadius;
+    tessBoundingRadius = aBoundingRadius;
+#endif
+
+    gl_Position = vec4(aPosition, 1.0f);
 }
 
 
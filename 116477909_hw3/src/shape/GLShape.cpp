@@ -13,8 +13,10 @@ GLShape::~GLShape() noexcept
 }
 
 
-GLShape::GLShape(Shader * pShader, const glm::mat4 & model) : pShader(pShader), model(model)
+GLShape::GLShape(Shader * pShader, const glm::mat4 & model) : pShader(pShader)
 {
+    setModel(model);
+
     glGenVertexArrays(1, &vao);
     glGenBuffers(1, &vbo);
 }
@@ -43,6 +45,42 @@ GLShape & GLShape::operator=(GLShape && rhs) noexcept
     rhs.vbo = 0U;
 
     model = rhs.model;
+    normalMatrix = rhs.normalMatrix;
 
     return *this;
 }
+
+
+glm::vec4 GLShape::boundingSphere() const
+{
+    return {0.0f, 0.0f, 0.0f, -1.0f};
+}
+
+
+void GLShape::setScreenRadius(float)
+{
+
+}
+
+
+std::size_t GLShape::bufferBytes(GLuint buffer)
+{
+    if (buffer == 0U)
+    {
+        return 0;
+    }
+
+    GLint size = 0;
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return static_cast<std::size_t>(size);
+}
+
+
+void GLShape::setModel(const glm::mat4 & newModel)
+{
+    model = newModel;
+    normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+}
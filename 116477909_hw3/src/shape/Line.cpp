@@ -51,3 +51,15 @@ void Line::render(float timeElapsedSinceLastFrame)
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 }
+
+
+std::size_t Line::gpuBytes() const
+{
+    return bufferBytes(vbo);
+}
+
+
+glm::vec4 Line::boundingSphere() const
+{
+    return enclosingSphere(vertices);
+}
@@ -0,0 +1,296 @@
+#include <algorithm>
+#include <cstring>
+
+#include "shape/LodMesh.h"
+#include "shape/Meshlets.h"
+#include "util/Shader.h"
+
+
+LodMesh::LodMesh(
+        Shader * pShader,
+        const RenderContext * pContext,
+        std::vector<Level> levels,
+        const glm::mat4 & model,
+        GLuint filledVbo
+)
+        : LodMesh(pShader, pContext, model)
+{
+    this->levels = std::move(levels);
+
+    if (!filledVbo)
+    {
+        for (Level & level : this->levels)
+        {
+            Meshlets::order(level.vertices);
+        }
+    }
+
+    uploadLevels(filledVbo);
+}
+
+
+LodMesh::~LodMesh() noexcept = default;
+
+
+void LodMesh::render(float timeElapsedSinceLastFrame)
+{
+    if (levels.empty())
+    {
+        return;
+    }
+
+    int target = selectLevel();
+
+    if (target != currentLevel)
+    {
+        // The first frame just picks a level; later changes fade if asked to.
+        if (crossFade && currentLevel != -1)
+        {
+            fadingLevel = currentLevel;
+            fadeProgress = 0.0f;
+        }
+
+        currentLevel = target;
+    }
+
+    if (fadingLevel != -1)
+    {
+        fadeProgress += timeElapsedSinceLastFrame / kFadeSeconds;
+
+        if (1.0f <= fadeProgress)
+        {
+            fadingLevel = -1;
+        }
+    }
+
+    glBindVertexArray(vao);
+
+    if (fadingLevel == -1)
+    {
+        Shader & shader = pShader->variant(plainVariant);
+
+        shader.use();
+        shader.setMat4("model", model);
+        shader.setMat3("normalMatrix", normalMatrix);
+
+        drawLevel(currentLevel);
+    }
+    else
+    {
+        // Complementary dither masks: together the two levels cover every pixel once.
+        Shader & shader = pShader->variant(fadeVariant, {{"LOD_FADE", 1}});
+
+        shader.use();
+        shader.setMat4("model", model);
+        shader.setMat3("normalMatrix", normalMatrix);
+        shader.setFloat("lodFade", fadeProgress);
+
+        shader.setInt("lodFadeOut", 0);
+        drawLevel(currentLevel);
+
+        shader.setInt("lodFadeOut", 1);
+        drawLevel(fadingLevel);
+    }
+
+    glBindVertexArray(0);
+}
+
+
+void LodMesh::setScreenRadius(float pixels)
+{
+    screenRadius = pixels;
+}
+
+
+void LodMesh::setPixelError(float pixels)
+{
+    pixelError = pixels;
+}
+
+
+void LodMesh::setCrossFade(bool enabled)
+{
+    crossFade = enabled;
+
+    if (!crossFade)
+    {
+        fadingLevel = -1;
+    }
+}
+
+
+glm::vec4 LodMesh::boundingSphere() const
+{
+    return {0.0f, 0.0f, 0.0f, boundingRadius};
+}
+
+
+int LodMesh::getLevel() const
+{
+    return currentLevel;
+}
+
+
+LodMesh::LodMesh(Shader * pShader, const RenderContext * pContext, const glm::mat4 & model)
+        : Mesh(pShader, model, pContext)
+{
+
+}
+
+
+void LodMesh::uploadLevels(GLuint filledVbo)
+{
+    firstVertex.clear();
+    levelMeshlets.clear();
+    boundingRadius = 0.0f;
+
+    for (std::size_t i = 0; i != levels.size(); ++i)
+    {
+        indexNextLevel();
+    }
+
+    if (filledVbo)
+    {
+        adoptVertexBuffer(filledVbo);
+    }
+    else
+    {
+        uploadPacked(0);
+    }
+
+    currentLevel = std::min(currentLevel, static_cast<int>(levels.size()) - 1);
+    fadingLevel = -1;
+}
+
+
+void LodMesh::appendLevel(Level level)
+{
+    const std::size_t bytes = level.vertices.size() * sizeof(Vertex);
+    levels.push_back(std::move(level));
+
+    if (vertexBuffer.append(levels.back().vertices.data(), bytes))
+    {
+        indexNextLevel();
+        return;
+    }
+
+    // Subdivision grows each level by the same factor, so the next one is likely this much larger.
+    std::size_t previous = levels.size() < 2 ? 0 : levels[levels.size() - 2].vertices.size() * sizeof(Vertex);
+    std::size_t next = previous ? bytes * (bytes / previous) : bytes;
+
+    uploadPacked(packedBytes(levels) + next);
+    indexNextLevel();
+}
+
+
+std::size_t LodMesh::packedBytes(const std::vector<Level> & levels)
+{
+    std::size_t bytes = 0;
+
+    for (const Level & level : levels)
+    {
+        bytes += level.vertices.size() * sizeof(Vertex);
+    }
+
+    return bytes;
+}
+
+
+void LodMesh::pack(const std::vector<Level> & levels, void * pDestination)
+{
+    auto pBytes = static_cast<unsigned char *>(pDestination);
+
+    for (const Level & level : levels)
+    {
+        std::memcpy(pBytes, level.vertices.data(), level.vertices.size() * sizeof(Vertex));
+        pBytes += level.vertices.size() * sizeof(Vertex);
+    }
+}
+
+
+int LodMesh::selectLevel() const
+{
+    int finest = static_cast<int>(levels.size()) - 1;
+
+    if (screenRadius < 0.0f || boundingRadius <= 0.0f)
+    {
+        return finest;
+    }
+
+    // Pixels per object-space unit, as the world measured the bounds.
+    float pixelsPerUnit = screenRadius / boundingRadius;
+
+    // Coarsest level within the error budget.
+    int wanted = finest;
+
+    for (int i = 0; i != finest; ++i)
+    {
+        if (levels[i].error * pixelsPerUnit <= pixelError)
+        {
+            wanted = i;
+            break;
+        }
+    }
+
+    // Refine at once, coarsen only past the hysteresis band.
+    if (currentLevel == -1 || currentLevel < wanted)
+    {
+        return wanted;
+    }
+
+    for (int i = wanted; i < currentLevel; ++i)
+    {
+        if (levels[i].error * pixelsPerUnit <= pixelError * kCoarsenFactor)
+        {
+            return i;
+        }
+    }
+
+    return currentLevel;
+}
+
+
+void LodMesh::uploadPacked(std::size_t reserveBytes)
+{
+    std::vector<Vertex> packed;
+    packed.reserve(packedBytes(levels) / sizeof(Vertex));
+
+    for (const Level & level : levels)
+    {
+        packed.insert(packed.end(), level.vertices.begin(), level.vertices.end());
+    }
+
+    vertexBuffer.respecify(packed.data(), packed.size() * sizeof(Vertex), reserveBytes);
+}
+
+
+void LodMesh::indexNextLevel()
+{
+    const std::size_t index = firstVertex.size();
+    const Level & level = levels[index];
+    GLint first = index == 0 ? 0 : firstVertex.back() + static_cast<GLint>(levels[index - 1].vertices.size());
+
+    firstVertex.push_back(first);
+    levelMeshlets.push_back(Meshlets::worthwhile(level.vertices.size())
+                            ? std::make_unique<Meshlets>(level.vertices, static_cast<GLuint>(first))
+                            : nullptr);
+
+    for (const Vertex & v : level.vertices)
+    {
+        boundingRadius = std::max(boundingRadius, glm::length(v.position));
+    }
+}
+
+
+void LodMesh::drawLevel(int level)
+{
+    if (levelMeshlets[level])
+    {
+        drawMeshlets(*levelMeshlets[level]);
+        return;
+    }
+
+    glDrawArrays(GL_TRIANGLES,
+                 firstVertex[level],
+                 static_cast<GLsizei>(levels[level].vertices.size()));
+}
@@ -1,49 +1,354 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
 #include "shape/Mesh.h"
+#include "shape/Meshlets.h"
+#include "util/RenderContext.h"
 #include "util/Shader.h"
 
 
 Mesh::Mesh(
         Shader * shader,
         const std::vector<Vertex> & vertices,
-        const glm::mat4 & model
+        const glm::mat4 & model,
+        const RenderContext * pContext,
+        VertexFormat format
 )
-        : Mesh(shader, model)
+        : Mesh(shader, model, pContext)
 {
     this->vertices = vertices;
+    this->vertexFormat = format;
+
+    Meshlets::order(this->vertices);
+    buildMeshlets();
+    uploadVertices();
+}
+
+
+Mesh::~Mesh() noexcept
+{
+    glDeleteBuffers(1, &indirectBuffer);
+}
+
 
+void Mesh::render(float timeElapsedSinceLastFrame)
+{
+    bool compressed = vertexFormat == VertexFormat::kCompressed;
+    Shader & shader = compressed ? pShader->variant(compressedVariant, {{"COMPRESSED_VERTEX", 1}})
+                                 : pShader->variant(plainVariant);
+
+    shader.use();
+    shader.setMat4("model", model);
+    shader.setMat3("normalMatrix", normalMatrix);
+
+    if (compressed)
+    {
+        shader.setVec3("positionOffset", compressedLayout.positionOffset);
+        shader.setVec3("positionScale", compressedLayout.positionScale);
+    }
+
+    vertexBuffer.flush(vertices.data());
+
+    glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
-    glBufferData(GL_ARRAY_BUFFER,
-                 static_cast<GLsizei>(vertices.size() * sizeof(Vertex)),
-                 vertices.data(),
-                 GL_STATIC_DRAW);
+    if (compressed && compressedLayout.uniformColor)
+    {
+        const glm::vec3 & color = compressedLayout.materialColor;
+        glVertexAttrib3f(2, color.x, color.y, color.z);
+    }
+
+    if (pMeshlets)
+    {
+        drawMeshlets(*pMeshlets);
+    }
+    else
+    {
+        std::size_t count = compressed ? compressedLayout.count : vertices.size();
+
+        glDrawArrays(GL_TRIANGLES,
+                     0,                              // start from index 0 in current VBO
+                     static_cast<GLsizei>(count));  // draw these number of elements
+    }
+
+    vertexBuffer.fenceAfterDraw();
 
     glBindBuffer(GL_ARRAY_BUFFER, 0U);
+    glBindVertexArray(0U);
 }
 
 
-void Mesh::render(float timeElapsedSinceLastFrame)
+std::size_t Mesh::gpuBytes() const
+{
+    return bufferBytes(vbo) + bufferBytes(indirectBuffer);
+}
+
+
+glm::vec4 Mesh::boundingSphere() const
+{
+    return vertexFormat == VertexFormat::kCompressed ? compressedBounds : enclosingSphere(vertices);
+}
+
+
+void Mesh::setBufferUsage(DynamicBuffer::Usage usage)
+{
+    vertexBuffer.setUsage(usage);
+}
+
+
+void Mesh::setVertices(std::vector<Vertex> newVertices)
+{
+    vertices = std::move(newVertices);
+
+    Meshlets::order(vertices);
+    buildMeshlets();
+    uploadVertices();
+}
+
+
+void Mesh::updateVertices(std::size_t first, const std::vector<Vertex> & replacement)
+{
+    if (vertexFormat == VertexFormat::kCompressed || pMeshlets)
+    {
+        throw std::logic_error("Mesh: compressed or meshlet meshes can only be replaced as a whole");
+    }
+
+    if (vertices.size() < first || vertices.size() - first < replacement.size())
+    {
+        throw std::out_of_range("Mesh: vertex update past the end of the mesh");
+    }
+
+    std::copy(replacement.begin(), replacement.end(), vertices.begin() + static_cast<std::ptrdiff_t>(first));
+    vertexBuffer.markDirty(first * sizeof(Vertex), replacement.size() * sizeof(Vertex));
+}
+
+
+void Mesh::uploadVertices()
+{
+    if (vertexFormat == VertexFormat::kCompressed)
+    {
+        useCompressedVertices(compress(vertices));
+        return;
+    }
+
+    vertexBuffer.respecify(vertices.data(), vertices.size() * sizeof(Vertex));
+}
+
+
+Mesh::CompressedVertices Mesh::compress(const std::vector<Vertex> & vertices)
 {
-    pShader->use();
-    pShader->setMat4("model", model);
+    CompressedVertices packed;
+    packed.count = vertices.size();
+
+    glm::vec3 lo {0.0f};
+    glm::vec3 hi {0.0f};
+
+    if (!vertices.empty())
+    {
+        lo = hi = vertices.front().position;
+        packed.materialColor = vertices.front().color;
+    }
+
+    packed.uniformColor = true;
+
+    for (const Vertex & v : vertices)
+    {
+        lo = glm::min(lo, v.position);
+        hi = glm::max(hi, v.position);
+        packed.uniformColor = packed.uniformColor && v.color == packed.materialColor;
+    }
+
+    packed.positionOffset = lo;
+    packed.positionScale = hi - lo;
+
+    auto unorm16 = [](float value, float lo, float extent) -> std::uint16_t
+    {
+        float t = 0.0f < extent ? (value - lo) / extent : 0.0f;
+        return static_cast<std::uint16_t>(std::lround(std::clamp(t, 0.0f, 1.0f) * 65535.0f));
+    };
+
+    auto snorm16 = [](float value) -> std::int16_t
+    {
+        return static_cast<std::int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    };
+
+    auto unorm8 = [](float value) -> std::uint8_t
+    {
+        return static_cast<std::uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+    };
+
+    packed.bytes.resize(vertices.size() * (sizeof(CompressedVertex) + (packed.uniformColor ? 0 : 4)));
+    std::uint8_t * pColors = packed.bytes.data() + vertices.size() * sizeof(CompressedVertex);
+
+    for (std::size_t i = 0; i != vertices.size(); ++i)
+    {
+        const Vertex & v = vertices[i];
+
+        // Octahedral map: project onto |x| + |y| + |z| = 1 and fold the lower half over the upper.
+        glm::vec3 n = v.normal;
+        float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        glm::vec2 octahedral = 0.0f < l1 ? glm::vec2(n.x, n.y) / l1 : glm::vec2(0.0f);
+
+        if (0.0f < l1 && n.z < 0.0f)
+        {
+            octahedral = glm::vec2((1.0f - std::abs(octahedral.y)) * (0.0f <= octahedral.x ? 1.0f : -1.0f),
+                                   (1.0f - std::abs(octahedral.x)) * (0.0f <= octahedral.y ? 1.0f : -1.0f));
+        }
 
+        CompressedVertex c {
+                {unorm16(v.position.x, lo.x, packed.positionScale.x),
+                 unorm16(v.position.y, lo.y, packed.positionScale.y),
+                 unorm16(v.position.z, lo.z, packed.positionScale.z),
+                 0U},
+                {snorm16(octahedral.x), snorm16(octahedral.y)}
+        };
+
+        std::memcpy(packed.bytes.data() + i * sizeof(CompressedVertex), &c, sizeof(CompressedVertex));
+
+        // Colors follow the packed vertices as a separate RGBA8 array.
+        if (!packed.uniformColor)
+        {
+            pColors[4 * i + 0] = unorm8(v.color.x);
+            pColors[4 * i + 1] = unorm8(v.color.y);
+            pColors[4 * i + 2] = unorm8(v.color.z);
+            pColors[4 * i + 3] = 255U;
+        }
+    }
+
+    return packed;
+}
+
+
+void Mesh::useCompressedVertices(CompressedVertices packed, GLuint filledVbo)
+{
+    vertexFormat = VertexFormat::kCompressed;
+    compressedBounds = enclosingSphere(vertices);
+
+    if (filledVbo)
+    {
+        glDeleteBuffers(1, &vbo);
+        vbo = filledVbo;
+    }
+
+    // Binding it here also makes writes from another context visible to this one.
     glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
-    glDrawArrays(GL_TRIANGLES,
-                 0,                                       // start from index 0 in current VBO
-                 static_cast<GLsizei>(vertices.size()));  // draw these number of elements
+    if (!filledVbo)
+    {
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(packed.bytes.size()), packed.bytes.data(), GL_STATIC_DRAW);
+    }
+
+    configureCompressedVertexAttributes(static_cast<GLsizei>(packed.count), !packed.uniformColor);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0U);
     glBindVertexArray(0U);
+
+    vertexBuffer.attach(vbo, bufferBytes(vbo));
+
+    // The VBO is the only copy from now on.
+    packed.bytes = {};
+    compressedLayout = std::move(packed);
+    vertices = {};
+}
+
+
+void Mesh::drawMeshlets(Meshlets & meshlets)
+{
+    const glm::mat4 modelView = pContext->view * model;
+    const glm::vec3 eye = glm::vec3(glm::inverse(modelView)[3]);
+
+    const std::vector<Meshlets::DrawCommand> & commands = meshlets.cull(pContext->projection * modelView, eye);
+
+    if (commands.empty())
+    {
+        return;
+    }
+
+    if (!indirectBuffer && GLAD_GL_ARB_multi_draw_indirect)
+    {
+        glGenBuffers(1, &indirectBuffer);
+        indirectCommands.attach(indirectBuffer, 0);
+    }
+
+    if (indirectBuffer)
+    {
+        // One call for the whole list; orphaning at a steady capacity lets the previous
+        // frame's commands be read while these are written.
+        indirectCommands.respecify(commands.data(), commands.size() * sizeof(Meshlets::DrawCommand));
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        glMultiDrawArraysIndirect(GL_TRIANGLES, nullptr, static_cast<GLsizei>(commands.size()), 0);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0U);
+    }
+    else
+    {
+        meshletFirst.clear();
+        meshletCount.clear();
+
+        for (const Meshlets::DrawCommand & command : commands)
+        {
+            meshletFirst.push_back(static_cast<GLint>(command.first));
+            meshletCount.push_back(static_cast<GLsizei>(command.count));
+        }
+
+        glMultiDrawArrays(GL_TRIANGLES, meshletFirst.data(), meshletCount.data(), static_cast<GLsizei>(commands.size()));
+    }
 }
 
 
-Mesh::Mesh(Shader * shader, const glm::mat4 & model) : GLShape(shader, model)
+void Mesh::buildMeshlets()
+{
+    if (pContext && Meshlets::worthwhile(vertices.size()))
+    {
+        pMeshlets = std::make_unique<Meshlets>(vertices);
+    }
+    else
+    {
+        pMeshlets.reset();
+    }
+}
+
+
+Mesh::Mesh(Shader * shader, const glm::mat4 & model, const RenderContext * pContext)
+        : GLShape(shader, model), pContext(pContext)
 {
     glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
+    configureVertexAttributes();
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    vertexBuffer.attach(vbo, 0);
+}
+
+
+void Mesh::adoptVertexBuffer(GLuint buffer)
+{
+    glDeleteBuffers(1, &vbo);
+    vbo = buffer;
+
+    // Binding it here also makes the other context's writes visible to this one.
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    configureVertexAttributes();
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    vertexBuffer.attach(vbo, bufferBytes(vbo));
+}
+
+
+void Mesh::configureVertexAttributes()
+{
     // Vertex coordinate attribute array "layout (position = 0) in vec3 aPosition"
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0,                             // index: corresponds to "0" in "layout (position = 0)"
@@ -70,7 +375,42 @@ Mesh::Mesh(Shader * shader, const glm::mat4 & model) : GLShape(shader, model)
                           GL_FALSE,
                           sizeof(Vertex),
                           reinterpret_cast<void *>(sizeof(Vertex::position) + sizeof(Vertex::normal)));
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+
+void Mesh::configureCompressedVertexAttributes(GLsizei vertexCount, bool colored)
+{
+    // "layout (location = 0) in vec3 aPosition": unsigned shorts mapped to [0, 1]
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0,
+                          3,
+                          GL_UNSIGNED_SHORT,
+                          GL_TRUE,
+                          sizeof(CompressedVertex),
+                          reinterpret_cast<void *>(0));
+
+    // "layout (location = 1) in vec2 aNormal": signed shorts mapped to [-1, 1]
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1,
+                          2,
+                          GL_SHORT,
+                          GL_TRUE,
+                          sizeof(CompressedVertex),
+                          reinterpret_cast<void *>(sizeof(CompressedVertex::position)));
+
+    // "layout (location = 2) in vec3 aColor": bytes mapped to [0, 1], packed after the vertices
+    if (colored)
+    {
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2,
+                              3,
+                              GL_UNSIGNED_BYTE,
+                              GL_TRUE,
+                              4,
+                              reinterpret_cast<void *>(static_cast<std::size_t>(vertexCount) * sizeof(CompressedVertex)));
+    }
+    else
+    {
+        glDisableVertexAttribArray(2);
+    }
 }
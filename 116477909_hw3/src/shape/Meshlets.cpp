@@ -0,0 +1,376 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define MESHLETS_SSE 1
+#endif
+
+#include "shape/Meshlets.h"
+
+
+namespace
+{
+
+// Cones whose normals spread wider than this (cosine) are too loose to ever cull.
+constexpr float kMinConeDot {0.1f};
+
+
+// Spreads the low 10 bits of x so there are two zero bits between each.
+std::uint32_t spreadBits(std::uint32_t x)
+{
+    x &= 0x3FFU;
+    x = (x | (x << 16U)) & 0x030000FFU;
+    x = (x | (x << 8U)) & 0x0300F00FU;
+    x = (x | (x << 4U)) & 0x030C30C3U;
+    x = (x | (x << 2U)) & 0x09249249U;
+    return x;
+}
+
+
+// Z-order code of p quantized to 10 bits per axis inside the box at lo spanning extent.
+std::uint32_t mortonCode(const glm::vec3 & p, const glm::vec3 & lo, const glm::vec3 & extent)
+{
+    auto quantize = [](float t)
+    {
+        return static_cast<std::uint32_t>(std::clamp(t, 0.0f, 1.0f) * 1023.0f);
+    };
+
+    return (spreadBits(quantize((p.x - lo.x) / extent.x)) << 2U)
+         | (spreadBits(quantize((p.y - lo.y) / extent.y)) << 1U)
+         |  spreadBits(quantize((p.z - lo.z) / extent.z));
+}
+
+
+// Whether the triangles form closed surfaces wound counter-clockwise seen from outside:
+// every edge is shared by exactly two triangles running it in opposite directions, and the
+// enclosed volume is positive. Corners are matched by exact position, which subdivision and
+// text files both repeat bit for bit.
+bool woundOutward(const std::vector<Mesh::Vertex> & vertices)
+{
+    struct PositionHash
+    {
+        std::size_t operator()(const glm::vec3 & p) const
+        {
+            std::uint32_t bits[3];
+            std::memcpy(bits, &p, sizeof(bits));
+            return (bits[0] * 73856093U) ^ (bits[1] * 19349663U) ^ (bits[2] * 83492791U);
+        }
+    };
+
+    std::unordered_map<glm::vec3, std::uint32_t, PositionHash> ids;
+    std::unordered_map<std::uint64_t, int> edges;
+    ids.reserve(vertices.size());
+    edges.reserve(vertices.size());
+
+    auto id = [&ids](const glm::vec3 & p)
+    {
+        return ids.emplace(p, static_cast<std::uint32_t>(ids.size())).first->second;
+    };
+
+    float volume = 0.0f;
+
+    for (std::size_t i = 0; i + 2 < vertices.size(); i += 3)
+    {
+        const std::uint32_t corner[3] {id(vertices[i].position), id(vertices[i + 1].position), id(vertices[i + 2].position)};
+
+        for (int k = 0; k != 3; ++k)
+        {
+            std::uint64_t edge = std::uint64_t {corner[k]} << 32U | corner[(k + 1) % 3];
+
+            if (1 < ++edges[edge])
+            {
+                return false;
+            }
+        }
+
+        volume += glm::dot(vertices[i].position, glm::cross(vertices[i + 1].position, vertices[i + 2].position));
+    }
+
+    for (const auto & [edge, count] : edges)
+    {
+        if (edges.find(edge << 32U | edge >> 32U) == edges.end())
+        {
+            return false;
+        }
+    }
+
+    return 0.0f < volume;
+}
+
+}  // namespace
+
+
+void Meshlets::order(std::vector<Mesh::Vertex> & vertices)
+{
+    const std::size_t triangleCount = vertices.size() / 3;
+
+    if (!worthwhile(vertices.size()))
+    {
+        return;
+    }
+
+    // Order triangles along a Z-curve through their centroids, so consecutive runs of
+    // kMaxTriangles are spatially compact.
+    glm::vec3 lo {vertices[0].position};
+    glm::vec3 hi {vertices[0].position};
+
+    for (const Mesh::Vertex & v : vertices)
+    {
+        lo = glm::min(lo, v.position);
+        hi = glm::max(hi, v.position);
+    }
+
+    glm::vec3 extent = glm::max(hi - lo, glm::vec3(1e-6f));
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> order(triangleCount);
+
+    for (std::size_t t = 0; t < triangleCount; ++t)
+    {
+        glm::vec3 centroid = (vertices[3 * t].position
+                            + vertices[3 * t + 1].position
+                            + vertices[3 * t + 2].position) / 3.0f;
+        order[t] = {mortonCode(centroid, lo, extent), static_cast<std::uint32_t>(t)};
+    }
+
+    std::sort(order.begin(), order.end());
+
+    std::vector<Mesh::Vertex> sorted;
+    sorted.reserve(triangleCount * 3);
+
+    for (const auto & entry : order)
+    {
+        sorted.insert(sorted.end(),
+                      vertices.begin() + 3 * entry.second,
+                      vertices.begin() + 3 * entry.second + 3);
+    }
+
+    vertices = std::move(sorted);
+}
+
+
+bool Meshlets::worthwhile(std::size_t vertexCount)
+{
+    return kMinTriangles <= vertexCount / 3;
+}
+
+
+Meshlets::Meshlets(const std::vector<Mesh::Vertex> & vertices, GLuint baseVertex)
+{
+    const std::size_t triangleCount = vertices.size() / 3;
+    const bool cones = woundOutward(vertices);
+
+    const std::size_t meshletCount = (triangleCount + kMaxTriangles - 1) / kMaxTriangles;
+
+    for (std::vector<float> * pArray : {&centerX, &centerY, &centerZ, &radius,
+                                        &axisX, &axisY, &axisZ, &cutoff})
+    {
+        pArray->resize(meshletCount);
+    }
+
+    firstVertex.resize(meshletCount);
+    vertexCount.resize(meshletCount);
+
+    for (std::size_t m = 0; m < meshletCount; ++m)
+    {
+        const std::size_t begin = m * kMaxTriangles * 3;
+        const std::size_t end = std::min(begin + kMaxTriangles * 3, triangleCount * 3);
+
+        firstVertex[m] = baseVertex + static_cast<GLuint>(begin);
+        vertexCount[m] = static_cast<GLuint>(end - begin);
+
+        // Bounding sphere around the box center.
+        glm::vec3 boxLo {vertices[begin].position};
+        glm::vec3 boxHi {vertices[begin].position};
+
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            boxLo = glm::min(boxLo, vertices[i].position);
+            boxHi = glm::max(boxHi, vertices[i].position);
+        }
+
+        glm::vec3 center = 0.5f * (boxLo + boxHi);
+        float radiusSquared = 0.0f;
+
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            glm::vec3 d = vertices[i].position - center;
+            radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+        }
+
+        centerX[m] = center.x;
+        centerY[m] = center.y;
+        centerZ[m] = center.z;
+        radius[m] = std::sqrt(radiusSquared);
+
+        // Normal cone from the counter-clockwise face normals; none if they may point inward.
+        if (!cones)
+        {
+            axisX[m] = 0.0f;
+            axisY[m] = 0.0f;
+            axisZ[m] = 1.0f;
+            cutoff[m] = 1.0f;
+            continue;
+        }
+
+        std::vector<glm::vec3> faceNormals;
+        faceNormals.reserve((end - begin) / 3);
+
+        for (std::size_t i = begin; i < end; i += 3)
+        {
+            glm::vec3 n = glm::cross(vertices[i + 1].position - vertices[i].position,
+                                     vertices[i + 2].position - vertices[i].position);
+            float length = glm::length(n);
+
+            if (0.0f < length)
+            {
+                faceNormals.push_back(n / length);
+            }
+        }
+
+        glm::vec3 axisSum {0.0f};
+
+        for (const glm::vec3 & n : faceNormals)
+        {
+            axisSum += n;
+        }
+
+        float axisLength = glm::length(axisSum);
+        glm::vec3 axis = 0.0f < axisLength ? axisSum / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+        float minDot = 0.0f < axisLength ? 1.0f : -1.0f;
+
+        for (const glm::vec3 & n : faceNormals)
+        {
+            minDot = std::min(minDot, glm::dot(axis, n));
+        }
+
+        axisX[m] = axis.x;
+        axisY[m] = axis.y;
+        axisZ[m] = axis.z;
+        cutoff[m] = minDot <= kMinConeDot ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+    }
+}
+
+
+const std::vector<Meshlets::DrawCommand> & Meshlets::cull(const glm::mat4 & modelViewProjection,
+                                                          const glm::vec3 & eye)
+{
+    commands.clear();
+
+    // Frustum planes in object space (Gribb-Hartmann), normalized so sphere radii compare directly.
+    glm::vec4 planes[6];
+
+    for (int i = 0; i < 3; ++i)
+    {
+        glm::vec4 row {modelViewProjection[0][i], modelViewProjection[1][i],
+                       modelViewProjection[2][i], modelViewProjection[3][i]};
+        glm::vec4 w {modelViewProjection[0][3], modelViewProjection[1][3],
+                     modelViewProjection[2][3], modelViewProjection[3][3]};
+
+        planes[2 * i] = w + row;
+        planes[2 * i + 1] = w - row;
+    }
+
+    for (glm::vec4 & plane : planes)
+    {
+        plane = plane / glm::length(glm::vec3(plane));
+    }
+
+    // A meshlet survives if its sphere reaches inside every plane and some triangle may
+    // face the eye: every normal lies within asin(cutoff) of the axis, so the whole cluster
+    // faces away once dot(center - eye, axis) >= cutoff * |center - eye| + radius.
+    const std::size_t count = size();
+    std::size_t m = 0;
+
+#ifdef MESHLETS_SSE
+    const __m128 eyeX = _mm_set1_ps(eye.x);
+    const __m128 eyeY = _mm_set1_ps(eye.y);
+    const __m128 eyeZ = _mm_set1_ps(eye.z);
+
+    for (; m + 4 <= count; m += 4)
+    {
+        const __m128 cx = _mm_loadu_ps(&centerX[m]);
+        const __m128 cy = _mm_loadu_ps(&centerY[m]);
+        const __m128 cz = _mm_loadu_ps(&centerZ[m]);
+        const __m128 r = _mm_loadu_ps(&radius[m]);
+        const __m128 negativeR = _mm_sub_ps(_mm_setzero_ps(), r);
+
+        __m128 visible = _mm_cmpeq_ps(r, r);
+
+        for (const glm::vec4 & plane : planes)
+        {
+            __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy)),
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), cz), _mm_set1_ps(plane.w)));
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negativeR));
+        }
+
+        const __m128 vx = _mm_sub_ps(cx, eyeX);
+        const __m128 vy = _mm_sub_ps(cy, eyeY);
+        const __m128 vz = _mm_sub_ps(cz, eyeZ);
+        const __m128 distance = _mm_sqrt_ps(
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+        const __m128 alongAxis = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(vx, _mm_loadu_ps(&axisX[m])), _mm_mul_ps(vy, _mm_loadu_ps(&axisY[m]))),
+                _mm_mul_ps(vz, _mm_loadu_ps(&axisZ[m])));
+        const __m128 backFacing = _mm_cmpge_ps(
+                alongAxis, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&cutoff[m]), distance), r));
+        visible = _mm_andnot_ps(backFacing, visible);
+
+        const int mask = _mm_movemask_ps(visible);
+
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            if (mask & (1 << lane))
+            {
+                setVisible(m + lane);
+            }
+        }
+    }
+#endif  // MESHLETS_SSE
+
+    for (; m < count; ++m)
+    {
+        bool visible = true;
+
+        for (const glm::vec4 & plane : planes)
+        {
+            visible &= -radius[m] <= plane.x * centerX[m] + plane.y * centerY[m] + plane.z * centerZ[m] + plane.w;
+        }
+
+        glm::vec3 v {centerX[m] - eye.x, centerY[m] - eye.y, centerZ[m] - eye.z};
+        float alongAxis = v.x * axisX[m] + v.y * axisY[m] + v.z * axisZ[m];
+        visible &= alongAxis < cutoff[m] * glm::length(v) + radius[m];
+
+        if (visible)
+        {
+            setVisible(m);
+        }
+    }
+
+    return commands;
+}
+
+
+std::size_t Meshlets::size() const
+{
+    return firstVertex.size();
+}
+
+
+void Meshlets::setVisible(std::size_t meshlet)
+{
+    // Meshlets are stored back to back, so neighbours that both survive share one command.
+    if (!commands.empty() && commands.back().first + commands.back().count == firstVertex[meshlet])
+    {
+        commands.back().count += vertexCount[meshlet];
+    }
+    else
+    {
+        commands.push_back({vertexCount[meshlet], 1U, firstVertex[meshlet], 0U});
+    }
+}
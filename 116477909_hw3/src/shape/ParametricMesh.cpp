@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "shape/Mesh.h"
+#include "shape/ParametricMesh.h"
+#include "shape/Sphere.h"
+#include "util/GeometrySoA.h"
+#include "util/Shader.h"
+
+
+ParametricMesh::ParametricMesh(
+        Shader * pShader,
+        const glm::vec3 & center,
+        float radius,
+        const glm::vec3 & color,
+        const glm::mat4 & model,
+        int shapetype,
+        float level,
+        float minorradius
+)
+        : GLShape(pShader, glm::translate(model, center)),
+          center(center),
+          color(color),
+          shapetype(shapetype),
+          radius(radius),
+          minorradius(minorradius)
+{
+    // The geometry is baked around the origin (center only moves the surface and its
+    // radial normals), so shapes at different centers share one cache entry.
+    setLevel(level);
+}
+
+
+void ParametricMesh::render(float timeElapsedSinceLastFrame)
+{
+    Shader & shader = pShader->variant(variantCache);
+
+    shader.use();
+    shader.setMat4("model", model);
+    shader.setMat3("normalMatrix", normalMatrix);
+
+    glBindVertexArray(vao);
+
+    // Color is constant over the shape: attribute 2 is left disabled in the VAO
+    // and read from the current generic value instead of the shared buffer.
+    glVertexAttrib3f(2, color.x, color.y, color.z);
+
+    glDrawElements(GL_TRIANGLES, pGeometry->indexCount, GL_UNSIGNED_INT, nullptr);
+
+    glBindVertexArray(0);
+}
+
+
+std::size_t ParametricMesh::gpuBytes() const
+{
+    return pGeometry ? bufferBytes(pGeometry->vbo) + bufferBytes(pGeometry->ebo) : 0;
+}
+
+
+glm::vec4 ParametricMesh::boundingSphere() const
+{
+    // The model matrix already holds the center.
+    ParametricSurface surface {shapetype, {0.0f, 0.0f, 0.0f}, radius, minorradius};
+    return {0.0f, 0.0f, 0.0f, surface.boundingRadius()};
+}
+
+
+void ParametricMesh::setModel(const glm::mat4 & newModel)
+{
+    GLShape::setModel(glm::translate(newModel, center));
+}
+
+
+void ParametricMesh::setLevel(float level)
+{
+    int newSegments = segmentsForLevel(level);
+
+    if (pGeometry && newSegments == segments)
+    {
+        return;
+    }
+
+    segments = newSegments;
+    pGeometry = acquire({shapetype, radius, minorradius, segments});
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, pGeometry->vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pGeometry->ebo);
+
+    Mesh::configureVertexAttributes();
+    glDisableVertexAttribArray(2);
+
+    // The element buffer binding is VAO state and stays with it.
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+int ParametricMesh::segmentsForLevel(float level)
+{
+    // In fixed mode every patch edge gets max(1, level * patch span), rounded up by equal_spacing.
+    int patches = Sphere::kDefaultPatchesU;
+    auto perPatch = static_cast<int>(std::ceil(std::max(1.0f, level / static_cast<float>(patches))));
+
+    return patches * perPatch;
+}
+
+
+ParametricMesh::Geometry::~Geometry() noexcept
+{
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ebo);
+}
+
+
+std::shared_ptr<const ParametricMesh::Geometry> ParametricMesh::acquire(const Key & key)
+{
+    if (auto it = cache.find(key); it != cache.end())
+    {
+        if (std::shared_ptr<const Geometry> pCached = it->second.lock())
+        {
+            return pCached;
+        }
+    }
+
+    std::shared_ptr<const Geometry> pBaked = bake(key);
+    cache[key] = pBaked;
+
+    return pBaked;
+}
+
+
+std::shared_ptr<const ParametricMesh::Geometry> ParametricMesh::bake(const Key & key)
+{
+    auto [shapeType, radius, minorradius, segments] = key;
+
+    ParametricSurface surface {shapeType, {0.0f, 0.0f, 0.0f}, radius, minorradius};
+    ParametricSurface::Grid grid = surface.evaluateGrid(segments, segments);
+
+    // Normals are radial from the center, as in sphere.tese.glsl.
+    GeometrySoA geometry;
+    geometry.px.assign(grid.x.begin(), grid.x.end());
+    geometry.py.assign(grid.y.begin(), grid.y.end());
+    geometry.pz.assign(grid.z.begin(), grid.z.end());
+    geometry.nx = geometry.px;
+    geometry.ny = geometry.py;
+    geometry.nz = geometry.pz;
+    geometry.normalizeNormals();
+    geometry.setColor(glm::vec3(1.0f));
+
+    // Two triangles per grid cell, counter-clockwise in (u, v) like the "ccw" quads of the TES.
+    // Column segments and (on the torus) row segments wrap to index 0.
+    std::vector<GLuint> indices;
+    indices.reserve(static_cast<std::size_t>(segments) * static_cast<std::size_t>(segments) * 6U);
+
+    auto index = [&grid](int i, int j)
+    {
+        return static_cast<GLuint>((j % grid.rows) * grid.columns + i % grid.columns);
+    };
+
+    for (int j = 0; j != segments; ++j)
+    {
+        for (int i = 0; i != segments; ++i)
+        {
+            GLuint i00 = index(i, j);
+            GLuint i10 = index(i + 1, j);
+            GLuint i11 = index(i + 1, j + 1);
+            GLuint i01 = index(i, j + 1);
+
+            indices.insert(indices.end(), {i00, i10, i11, i00, i11, i01});
+        }
+    }
+
+    auto pGeometry = std::make_shared<Geometry>();
+    pGeometry->indexCount = static_cast<GLsizei>(indices.size());
+
+    glGenBuffers(1, &pGeometry->vbo);
+    geometry.upload(pGeometry->vbo, GL_STATIC_DRAW);
+
+    // Bind through GL_ARRAY_BUFFER so no VAO's element binding is touched.
+    glGenBuffers(1, &pGeometry->ebo);
+    glBindBuffer(GL_ARRAY_BUFFER, pGeometry->ebo);
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(indices.size() * sizeof(GLuint)),
+                 indices.data(),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return pGeometry;
+}
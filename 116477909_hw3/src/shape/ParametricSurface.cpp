@@ -0,0 +1,229 @@
+#include <cmath>
+#include <cstddef>
+
+#include "shape/ParametricSurface.h"
+
+
+namespace
+{
+
+constexpr float kPi = 3.14159265358979323846f;
+
+// Superquadric constants from sphere.tese.glsl.
+constexpr float kSuperQuadricA = 0.5f;
+constexpr float kSuperQuadricN1 = 1.0f;
+constexpr float kSuperQuadricN2 = 1.0f;
+constexpr float kSuperQuadricVMax = 1.25f;
+
+// Height of the cylinder and the cone.
+constexpr float kHeight = 2.0f;
+
+float power(float base, float exp)
+{
+    return std::copysign(std::pow(std::abs(base), exp), base);
+}
+
+}  // namespace
+
+
+glm::vec3 ParametricSurface::evaluate(float u, float v) const
+{
+    glm::vec3 pos;
+
+    switch (shapeType)
+    {
+    case kCylinder:
+    {
+        float theta = u * 2.0f * kPi;
+        pos = {radius * std::cos(theta), kHeight * (v - 0.5f), radius * std::sin(theta)};
+        break;
+    }
+    case kCone:
+    {
+        float theta = u * 2.0f * kPi;
+        pos = {radius * (1.0f - v) * std::cos(theta), kHeight * v, radius * (1.0f - v) * std::sin(theta)};
+        break;
+    }
+    case kTorus:
+    {
+        float xAngle = u * 2.0f * kPi;
+        float zAngle = v * 2.0f * kPi;
+        float ring = radius + minorradius * std::cos(zAngle);
+        pos = {ring * std::cos(xAngle), ring * std::sin(xAngle), minorradius * std::sin(zAngle)};
+        break;
+    }
+    case kSuperQuadric:
+    {
+        float su = u * 2.0f * kPi;
+        float sv = -kSuperQuadricVMax + v * 2.0f * kSuperQuadricVMax;
+        pos = {kSuperQuadricA * power(std::cosh(sv), kSuperQuadricN1) * power(std::cos(su), kSuperQuadricN2),
+               kSuperQuadricA * power(std::sinh(sv), kSuperQuadricN1),
+               kSuperQuadricA * power(std::cosh(sv), kSuperQuadricN1) * power(std::sin(su), kSuperQuadricN2)};
+        break;
+    }
+    case kPentagon:
+    case kSphere:
+    default:
+    {
+        // The pentagon is projected onto the unit sphere in the shader; treat it as one here.
+        float r = shapeType == kPentagon ? 1.0f : radius;
+        float phi = 2.0f * kPi * u;
+        float theta = kPi * v;
+        pos = {r * std::sin(theta) * std::cos(phi), r * std::sin(theta) * std::sin(phi), r * std::cos(theta)};
+        break;
+    }
+    }
+
+    return center + pos;
+}
+
+
+glm::vec3 ParametricSurface::normal(const glm::vec3 & position) const
+{
+    return glm::normalize(position - center);
+}
+
+
+float ParametricSurface::boundingRadius() const
+{
+    switch (shapeType)
+    {
+    case kCylinder:
+    {
+        // height 2, centered on center
+        return std::sqrt(radius * radius + 0.25f * kHeight * kHeight);
+    }
+    case kCone:
+    {
+        // base on center, apex kHeight above
+        return std::sqrt(radius * radius + kHeight * kHeight);
+    }
+    case kTorus:
+    {
+        return radius + minorradius;
+    }
+    case kSuperQuadric:
+    {
+        float xz = kSuperQuadricA * std::cosh(kSuperQuadricVMax);
+        float y = kSuperQuadricA * std::sinh(kSuperQuadricVMax);
+        return std::sqrt(2.0f * xz * xz + y * y);
+    }
+    case kPentagon:
+    {
+        return 1.0f;
+    }
+    default:
+    {
+        return radius;
+    }
+    }
+}
+
+
+bool ParametricSurface::wrapsV() const
+{
+    return shapeType == kTorus;
+}
+
+
+ParametricSurface::Grid ParametricSurface::evaluateGrid(int segmentsU, int segmentsV) const
+{
+    Grid grid;
+    grid.columns = segmentsU;
+    grid.rows = wrapsV() ? segmentsV : segmentsV + 1;
+
+    auto count = static_cast<std::size_t>(grid.columns) * static_cast<std::size_t>(grid.rows);
+    grid.x.resize(count);
+    grid.y.resize(count);
+    grid.z.resize(count);
+
+    // Ring in u: (cosU, sinU) spans the ring plane.
+    std::vector<float> cosU(static_cast<std::size_t>(grid.columns));
+    std::vector<float> sinU(static_cast<std::size_t>(grid.columns));
+
+    for (int i = 0; i != grid.columns; ++i)
+    {
+        float angle = 2.0f * kPi * static_cast<float>(i) / static_cast<float>(segmentsU);
+        cosU[i] = std::cos(angle);
+        sinU[i] = std::sin(angle);
+
+        if (shapeType == kSuperQuadric)
+        {
+            cosU[i] = power(cosU[i], kSuperQuadricN2);
+            sinU[i] = power(sinU[i], kSuperQuadricN2);
+        }
+    }
+
+    // Profile in v: ring radius and offset along the axis.
+    std::vector<float> ring(static_cast<std::size_t>(grid.rows));
+    std::vector<float> axis(static_cast<std::size_t>(grid.rows));
+
+    for (int j = 0; j != grid.rows; ++j)
+    {
+        float v = static_cast<float>(j) / static_cast<float>(segmentsV);
+
+        switch (shapeType)
+        {
+        case kCylinder:
+        {
+            ring[j] = radius;
+            axis[j] = kHeight * (v - 0.5f);
+            break;
+        }
+        case kCone:
+        {
+            ring[j] = radius * (1.0f - v);
+            axis[j] = kHeight * v;
+            break;
+        }
+        case kTorus:
+        {
+            float zAngle = v * 2.0f * kPi;
+            ring[j] = radius + minorradius * std::cos(zAngle);
+            axis[j] = minorradius * std::sin(zAngle);
+            break;
+        }
+        case kSuperQuadric:
+        {
+            float sv = -kSuperQuadricVMax + v * 2.0f * kSuperQuadricVMax;
+            ring[j] = kSuperQuadricA * power(std::cosh(sv), kSuperQuadricN1);
+            axis[j] = kSuperQuadricA * power(std::sinh(sv), kSuperQuadricN1);
+            break;
+        }
+        case kPentagon:
+        case kSphere:
+        default:
+        {
+            float r = shapeType == kPentagon ? 1.0f : radius;
+            ring[j] = r * std::sin(kPi * v);
+            axis[j] = r * std::cos(kPi * v);
+            break;
+        }
+        }
+    }
+
+    // Sphere and torus rings lie in the xy plane around z; the others in the xz plane around y.
+    bool ringInXY = shapeType == kSphere || shapeType == kTorus || shapeType == kPentagon;
+
+    float * ringX = grid.x.data();
+    float * ringY = ringInXY ? grid.y.data() : grid.z.data();
+    float * along = ringInXY ? grid.z.data() : grid.y.data();
+    float centerAlong = ringInXY ? center.z : center.y;
+    float centerRingY = ringInXY ? center.y : center.z;
+
+    for (int j = 0; j != grid.rows; ++j)
+    {
+        std::size_t row = static_cast<std::size_t>(j) * static_cast<std::size_t>(grid.columns);
+        float r = ring[j];
+        float a = axis[j] + centerAlong;
+
+        for (int i = 0; i != grid.columns; ++i)
+        {
+            ringX[row + i] = center.x + r * cosU[i];
+            ringY[row + i] = centerRingY + r * sinU[i];
+            along[row + i] = a;
+        }
+    }
+
+    return grid;
+}
@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+#include "shape/GLShape.h"
+#include "shape/RenderWorld.h"
+#include "util/Parallel.h"
+
+
+RenderWorld::Entity RenderWorld::create(Renderable * pRenderable, GLShape * pShape, const glm::mat4 & model)
+{
+    std::uint32_t slot;
+
+    if (freeSlots.empty())
+    {
+        slot = static_cast<std::uint32_t>(denseOf.size());
+
+        if (kSlotMask < slot)
+        {
+            throw std::runtime_error("RenderWorld: too many entities");
+        }
+
+        denseOf.push_back(0U);
+        generations.push_back(0U);
+    }
+    else
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+
+    Entity entity = slot | static_cast<Entity>(generations[slot]) << kSlotBits;
+    denseOf[slot] = static_cast<std::uint32_t>(entities.size());
+
+    entities.push_back(entity);
+    transforms.push_back(model);
+    localBounds.push_back(pShape ? pShape->boundingSphere() : glm::vec4(0.0f, 0.0f, 0.0f, -1.0f));
+    centerX.push_back(0.0f);
+    centerY.push_back(0.0f);
+    centerZ.push_back(0.0f);
+    radii.push_back(0.0f);
+    meshes.push_back(pRenderable);
+    shapes.push_back(pShape);
+    materials.push_back(pShape ? pShape->shader() : nullptr);
+    flags.push_back(0U);
+
+    updateBounds(entities.size() - 1);
+
+    return entity;
+}
+
+
+void RenderWorld::destroy(Entity entity)
+{
+    std::uint32_t i = denseIndex(entity);
+    std::uint32_t last = static_cast<std::uint32_t>(entities.size()) - 1U;
+
+    if (i != last)
+    {
+        entities[i] = entities[last];
+        transforms[i] = transforms[last];
+        localBounds[i] = localBounds[last];
+        centerX[i] = centerX[last];
+        centerY[i] = centerY[last];
+        centerZ[i] = centerZ[last];
+        radii[i] = radii[last];
+        meshes[i] = meshes[last];
+        shapes[i] = shapes[last];
+        materials[i] = materials[last];
+        flags[i] = flags[last];
+
+        denseOf[entities[i] & kSlotMask] = i;
+    }
+
+    entities.pop_back();
+    transforms.pop_back();
+    localBounds.pop_back();
+    centerX.pop_back();
+    centerY.pop_back();
+    centerZ.pop_back();
+    radii.pop_back();
+    meshes.pop_back();
+    shapes.pop_back();
+    materials.pop_back();
+    flags.pop_back();
+
+    std::uint32_t slot = entity & kSlotMask;
+    ++generations[slot];
+    freeSlots.push_back(slot);
+}
+
+
+void RenderWorld::clear()
+{
+    while (!entities.empty())
+    {
+        destroy(entities.back());
+    }
+}
+
+
+bool RenderWorld::alive(Entity entity) const
+{
+    std::uint32_t slot = entity & kSlotMask;
+
+    return entity != kNull && slot < denseOf.size() &&
+           generations[slot] == static_cast<std::uint8_t>(entity >> kSlotBits) &&
+           denseOf[slot] < entities.size() && entities[denseOf[slot]] == entity;
+}
+
+
+void RenderWorld::setTransform(Entity entity, const glm::mat4 & model)
+{
+    std::uint32_t i = denseIndex(entity);
+    transforms[i] = model;
+
+    if (shapes[i])
+    {
+        shapes[i]->setModel(model);
+    }
+
+    updateBounds(i);
+}
+
+
+void RenderWorld::refreshBounds(Entity entity)
+{
+    std::uint32_t i = denseIndex(entity);
+
+    if (shapes[i])
+    {
+        localBounds[i] = shapes[i]->boundingSphere();
+        materials[i] = shapes[i]->shader();
+    }
+
+    updateBounds(i);
+}
+
+
+void RenderWorld::setHidden(Entity entity, bool hidden)
+{
+    std::uint8_t & f = flags[denseIndex(entity)];
+    f = hidden ? static_cast<std::uint8_t>(f | kHidden) : static_cast<std::uint8_t>(f & ~kHidden);
+}
+
+
+bool RenderWorld::visible(const Frame & frame, Entity entity) const
+{
+    return frame.visible[denseIndex(entity)];
+}
+
+
+float RenderWorld::screenRadius(const Frame & frame, Entity entity) const
+{
+    return frame.screenRadii[denseIndex(entity)];
+}
+
+
+void RenderWorld::prepare(const RenderContext & context, Frame & frame) const
+{
+    frame.context = context;
+
+    cull(frame);
+    selectLod(frame);
+    buildDrawList(frame);
+}
+
+
+void RenderWorld::cull(Frame & frame) const
+{
+    // Gribb-Hartmann: the clip-space half-spaces as world-space planes, normalized.
+    glm::mat4 viewProjection = frame.context.projection * frame.context.view;
+    glm::vec4 rows[4];
+
+    for (int r = 0; r != 4; ++r)
+    {
+        rows[r] = {viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]};
+    }
+
+    glm::vec4 planes[6] {
+        rows[3] + rows[0], rows[3] - rows[0],
+        rows[3] + rows[1], rows[3] - rows[1],
+        rows[3] + rows[2], rows[3] - rows[2],
+    };
+
+    for (glm::vec4 & plane : planes)
+    {
+        plane = plane / glm::length(glm::vec3(plane));
+    }
+
+    const std::size_t count = entities.size();
+    frame.visible.resize(count);
+
+    parallelFor(0, count, [&](std::size_t i)
+    {
+        bool inside = true;
+
+        for (const glm::vec4 & plane : planes)
+        {
+            inside = inside && -radii[i] <= plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w;
+        }
+
+        std::uint8_t f = flags[i];
+        frame.visible[i] = !(f & kHidden) && ((f & kUnbounded) || inside);
+    }, kGrain);
+}
+
+
+void RenderWorld::selectLod(Frame & frame) const
+{
+    const RenderContext & context = frame.context;
+    const glm::mat4 & view = context.view;
+    const std::size_t count = entities.size();
+    frame.screenRadii.assign(count, 0.0f);
+
+    parallelFor(0, count, [&](std::size_t i)
+    {
+        if (!frame.visible[i] || (flags[i] & kUnbounded))
+        {
+            return;
+        }
+
+        float depth = -(view[0][2] * centerX[i] + view[1][2] * centerY[i] + view[2][2] * centerZ[i] + view[3][2]);
+
+        // Spheres around the eye cover the screen.
+        if (depth <= radii[i])
+        {
+            frame.screenRadii[i] = context.viewportSize.y;
+            return;
+        }
+
+        // Scaled at the nearest depth, so detail chosen from it suits the whole object.
+        frame.screenRadii[i] = radii[i] * context.pixelsPerUnit(depth - radii[i]);
+
+        if (frame.screenRadii[i] < kMinScreenRadius)
+        {
+            frame.visible[i] = 0U;
+        }
+    }, kGrain);
+}
+
+
+void RenderWorld::buildDrawList(Frame & frame) const
+{
+    frame.drawOrder.clear();
+
+    for (std::uint32_t i = 0; i != entities.size(); ++i)
+    {
+        if (frame.visible[i])
+        {
+            frame.drawOrder.push_back(i);
+        }
+    }
+
+    // Same material together; otherwise creation order, which scenes are written in.
+    std::stable_sort(frame.drawOrder.begin(), frame.drawOrder.end(), [this](std::uint32_t a, std::uint32_t b)
+    {
+        return std::less<const Shader *>()(materials[a], materials[b]);
+    });
+
+    frame.drawList.clear();
+    frame.drawShapes.clear();
+    frame.drawRadii.clear();
+
+    for (std::uint32_t i : frame.drawOrder)
+    {
+        frame.drawList.push_back(meshes[i]);
+        frame.drawShapes.push_back(shapes[i]);
+        frame.drawRadii.push_back(frame.screenRadii[i]);
+    }
+}
+
+
+std::uint32_t RenderWorld::denseIndex(Entity entity) const
+{
+    if (!alive(entity))
+    {
+        throw std::invalid_argument("RenderWorld: stale or invalid entity");
+    }
+
+    return denseOf[entity & kSlotMask];
+}
+
+
+void RenderWorld::updateBounds(std::size_t i)
+{
+    const glm::vec4 & local = localBounds[i];
+
+    if (local.w < 0.0f)
+    {
+        flags[i] = static_cast<std::uint8_t>(flags[i] | kUnbounded);
+        return;
+    }
+
+    flags[i] = static_cast<std::uint8_t>(flags[i] & ~kUnbounded);
+
+    const glm::mat4 & model = transforms[i];
+    glm::vec3 center {model * glm::vec4(glm::vec3(local), 1.0f)};
+    float scale = std::max({glm::length(glm::vec3(model[0])),
+                            glm::length(glm::vec3(model[1])),
+                            glm::length(glm::vec3(model[2]))});
+
+    centerX[i] = center.x;
+    centerY[i] = center.y;
+    centerZ[i] = center.z;
+    radii[i] = local.w * scale;
+}
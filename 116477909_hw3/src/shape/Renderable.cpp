@@ -4,3 +4,9 @@
 
 
 Renderable::~Renderable() noexcept = default;
+
+
+std::size_t Renderable::gpuBytes() const
+{
+    return 0;
+}
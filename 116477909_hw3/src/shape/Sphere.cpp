@@ -1,3 +1,5 @@
+#include <cstddef>
+
 #include "shape/Sphere.h"
 #include "util/Shader.h"
 
@@ -20,41 +22,161 @@ Sphere::Sphere(
     glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
-    // Placeholder attribute array "layout (position = 0) in float null"
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0,                             // index: corresponds to "0" in "layout (position = 0)"
-                          1,                             // size: each "vec3" generic vertex attribute has 3 values
-                          GL_FLOAT,                      // data type: "vec3" generic vertex attributes are GL_FLOAT
-                          GL_FALSE,                      // do not normalize data
-                          sizeof(float),                // stride between attributes in VBO data
-                          reinterpret_cast<void *>(0));  // offset of 1st attribute in VBO data
-
-    glBufferData(GL_ARRAY_BUFFER,
-                 static_cast<GLsizei>(sizeof(float)),
-                 &kNull,
-                 GL_STATIC_DRAW);
+    configurePatchAttributes();
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
+
+    setPatchGrid(kDefaultPatchesU, kDefaultPatchesV);
 }
 
 
 void Sphere::render(float timeElapsedSinceLastFrame)
 {
-    pShader->use();
-    pShader->setMat4("model", model);
-    pShader->setVec3("center", center);
-    pShader->setFloat("radius", radius);
-    pShader->setFloat("minorradius", minorradius);
-    pShader->setVec3("color", color);
-    pShader->setInt("shapeType", shapetype);
+    // shapeType is baked into the program instead of branched on per tessellated vertex.
+    Shader & shader = pShader->variant(variantCache, {{"SHAPE_TYPE", shapetype}});
+
+    shader.use();
+    shader.setMat4("model", model);
+    shader.setMat3("normalMatrix", normalMatrix);
+    shader.setVec3("center", center);
+    shader.setFloat("radius", radius);
+    shader.setFloat("minorradius", minorradius);
+    shader.setVec3("color", color);
 
     glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
-    glPatchParameteri(GL_PATCH_VERTICES, 1);
-    glDrawArrays(GL_PATCHES, 0, 1);
+    glPatchParameteri(GL_PATCH_VERTICES, 4);
+    glDrawArrays(GL_PATCHES, 0, patchVertexCount);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
-}
\ No newline at end of file
+}
+
+
+std::size_t Sphere::gpuBytes() const
+{
+    return bufferBytes(vbo);
+}
+
+
+glm::vec4 Sphere::boundingSphere() const
+{
+    return {center, boundingRadius()};
+}
+
+
+void Sphere::setPatchGrid(int patchesU, int patchesV)
+{
+    std::vector<PatchVertex> patches = buildPatches(surface(), patchesU, patchesV);
+    patchVertexCount = static_cast<GLsizei>(patches.size());
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(patches.size() * sizeof(PatchVertex)),
+                 patches.data(),
+                 GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+float Sphere::boundingRadius() const
+{
+    return surface().boundingRadius();
+}
+
+
+ParametricSurface Sphere::surface() const
+{
+    return {shapetype, center, radius, minorradius};
+}
+
+
+std::vector<Sphere::PatchVertex> Sphere::buildPatches(const ParametricSurface & surface, int patchesU, int patchesV)
+{
+    // Samples per patch side used to bound the curved surface, not just its corners.
+    constexpr int kBoundSamples = 5;
+
+    std::vector<PatchVertex> patches;
+    patches.reserve(static_cast<std::size_t>(patchesU * patchesV * 4));
+
+    // u (and v on the torus) wraps around: parameters 1 and 0 are the same point.
+    // Evaluating seam corners with the wrapped parameter makes both neighbours see bit-identical
+    // positions, which keeps their tessellation levels (and so the shared edge) crack-free.
+    bool wrapsV = surface.wrapsV();
+
+    auto corner = [&surface, wrapsV](float u, float v)
+    {
+        return surface.evaluate(u == 1.0f ? 0.0f : u, (wrapsV && v == 1.0f) ? 0.0f : v);
+    };
+
+    for (int j = 0; j != patchesV; ++j)
+    {
+        for (int i = 0; i != patchesU; ++i)
+        {
+            float u0 = static_cast<float>(i) / static_cast<float>(patchesU);
+            float u1 = static_cast<float>(i + 1) / static_cast<float>(patchesU);
+            float v0 = static_cast<float>(j) / static_cast<float>(patchesV);
+            float v1 = static_cast<float>(j + 1) / static_cast<float>(patchesV);
+
+            glm::vec3 lo {surface.evaluate(u0, v0)};
+            glm::vec3 hi {lo};
+
+            for (int b = 0; b != kBoundSamples; ++b)
+            {
+                for (int a = 0; a != kBoundSamples; ++a)
+                {
+                    float s = static_cast<float>(a) / static_cast<float>(kBoundSamples - 1);
+                    float t = static_cast<float>(b) / static_cast<float>(kBoundSamples - 1);
+                    glm::vec3 p = surface.evaluate(glm::mix(u0, u1, s), glm::mix(v0, v1, t));
+                    lo = glm::min(lo, p);
+                    hi = glm::max(hi, p);
+                }
+            }
+
+            // Half the box diagonal, padded for the bulge between samples.
+            glm::vec4 bound {(lo + hi) * 0.5f, 0.55f * glm::length(hi - lo)};
+
+            patches.push_back({corner(u0, v0), {u0, v0}, bound});
+            patches.push_back({corner(u1, v0), {u1, v0}, bound});
+            patches.push_back({corner(u1, v1), {u1, v1}, bound});
+            patches.push_back({corner(u0, v1), {u0, v1}, bound});
+        }
+    }
+
+    return patches;
+}
+
+
+void Sphere::configurePatchAttributes()
+{
+    // Patch corner position "layout (location = 0) in vec3 aPosition"
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0,                             // index: corresponds to "0" in "layout (location = 0)"
+                          3,                             // size: each "vec3" generic vertex attribute has 3 values
+                          GL_FLOAT,                      // data type: "vec3" generic vertex attributes are GL_FLOAT
+                          GL_FALSE,                      // do not normalize data
+                          sizeof(PatchVertex),           // stride between attributes in VBO data
+                          reinterpret_cast<void *>(offsetof(PatchVertex, position)));
+
+    // Corner parameters "layout (location = 1) in vec2 aUv"
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1,
+                          2,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          sizeof(PatchVertex),
+                          reinterpret_cast<void *>(offsetof(PatchVertex, uv)));
+
+    // Patch bounding sphere "layout (location = 2) in vec4 aBound"
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2,
+                          4,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          sizeof(PatchVertex),
+                          reinterpret_cast<void *>(offsetof(PatchVertex, bound)));
+}
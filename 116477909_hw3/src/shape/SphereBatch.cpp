@@ -0,0 +1,238 @@
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include "shape/Sphere.h"
+#include "shape/SphereBatch.h"
+#include "util/Shader.h"
+
+
+SphereBatch::SphereBatch(Shader * pShader, const glm::mat4 & model) : GLShape(pShader, model)
+{
+    glGenBuffers(1, &instanceVbo);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    Sphere::configurePatchAttributes();
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+
+    for (GLuint location = 3U; location != 6U; ++location)
+    {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1U);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    setPatchGrid(kDefaultPatchesU, kDefaultPatchesV);
+}
+
+
+SphereBatch::~SphereBatch() noexcept
+{
+    glDeleteBuffers(1, &instanceVbo);
+    instanceVbo = 0U;
+}
+
+
+void SphereBatch::render(float timeElapsedSinceLastFrame)
+{
+    if (instancesDirty)
+    {
+        upload();
+    }
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+
+    glPatchParameteri(GL_PATCH_VERTICES, 4);
+
+    std::size_t offset = 0;
+
+    for (int shapetype = 0; shapetype != kShapeTypes; ++shapetype)
+    {
+        const std::vector<Instance> & group = instances[shapetype];
+
+        if (group.empty())
+        {
+            continue;
+        }
+
+        Shader & shader = pShader->variant(variantCaches[shapetype], {{"SHAPE_TYPE", shapetype}, {"SPHERE_BATCH", 1}});
+
+        shader.use();
+        shader.setMat4("model", model);
+        shader.setMat3("normalMatrix", normalMatrix);
+
+        // GL 4.1 has no base instance, so the attribute pointers move to the group instead.
+        configureInstanceAttributes(offset);
+
+        glDrawArraysInstanced(GL_PATCHES, 0, patchVertexCount, static_cast<GLsizei>(group.size()));
+
+        offset += group.size() * sizeof(Instance);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+
+std::size_t SphereBatch::gpuBytes() const
+{
+    return bufferBytes(vbo) + bufferBytes(instanceVbo);
+}
+
+
+glm::vec4 SphereBatch::boundingSphere() const
+{
+    // Union of the instance spheres.
+    glm::vec3 lower {0.0f};
+    glm::vec3 upper {0.0f};
+    bool empty = true;
+
+    for (const auto & group : instances)
+    {
+        for (const Instance & instance : group)
+        {
+            glm::vec3 center {instance.centerRadius};
+            glm::vec3 extent {instance.boundingRadius};
+
+            lower = empty ? center - extent : glm::min(lower, center - extent);
+            upper = empty ? center + extent : glm::max(upper, center + extent);
+            empty = false;
+        }
+    }
+
+    if (empty)
+    {
+        return {0.0f, 0.0f, 0.0f, -1.0f};
+    }
+
+    glm::vec3 center = 0.5f * (lower + upper);
+    float radius = 0.0f;
+
+    for (const auto & group : instances)
+    {
+        for (const Instance & instance : group)
+        {
+            radius = std::max(radius, glm::length(glm::vec3(instance.centerRadius) - center) + instance.boundingRadius);
+        }
+    }
+
+    return {center, radius};
+}
+
+
+void SphereBatch::add(
+        const glm::vec3 & center,
+        float radius,
+        const glm::vec3 & color,
+        int shapetype,
+        float minorradius
+)
+{
+    if (shapetype < 0 || kShapeTypes <= shapetype)
+    {
+        throw std::invalid_argument("SphereBatch: shape type " + std::to_string(shapetype) + " cannot be instanced");
+    }
+
+    ParametricSurface surface {shapetype, center, radius, minorradius};
+
+    instances[shapetype].push_back({{center, radius}, {color, minorradius}, surface.boundingRadius()});
+    instancesDirty = true;
+}
+
+
+void SphereBatch::clear()
+{
+    for (std::vector<Instance> & group : instances)
+    {
+        group.clear();
+    }
+
+    instancesDirty = true;
+}
+
+
+std::size_t SphereBatch::size() const
+{
+    std::size_t count = 0;
+
+    for (const std::vector<Instance> & group : instances)
+    {
+        count += group.size();
+    }
+
+    return count;
+}
+
+
+void SphereBatch::setPatchGrid(int patchesU, int patchesV)
+{
+    // Only the corner parameters are used with SPHERE_BATCH; positions come from the instances.
+    std::vector<Sphere::PatchVertex> patches = Sphere::buildPatches(ParametricSurface {}, patchesU, patchesV);
+    patchVertexCount = static_cast<GLsizei>(patches.size());
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(patches.size() * sizeof(Sphere::PatchVertex)),
+                 patches.data(),
+                 GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+void SphereBatch::configureInstanceAttributes(std::size_t offset)
+{
+    // Center and radius "layout (location = 3) in vec4 aCenterRadius"
+    glVertexAttribPointer(3,
+                          4,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          sizeof(Instance),
+                          reinterpret_cast<void *>(offset + offsetof(Instance, centerRadius)));
+
+    // Color and minor radius "layout (location = 4) in vec4 aColorMinorRadius"
+    glVertexAttribPointer(4,
+                          4,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          sizeof(Instance),
+                          reinterpret_cast<void *>(offset + offsetof(Instance, colorMinorRadius)));
+
+    // Bounding radius "layout (location = 5) in float aBoundingRadius"
+    glVertexAttribPointer(5,
+                          1,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          sizeof(Instance),
+                          reinterpret_cast<void *>(offset + offsetof(Instance, boundingRadius)));
+}
+
+
+void SphereBatch::upload()
+{
+    std::vector<Instance> packed;
+    packed.reserve(size());
+
+    for (const std::vector<Instance> & group : instances)
+    {
+        packed.insert(packed.end(), group.begin(), group.end());
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(packed.size() * sizeof(Instance)),
+                 packed.data(),
+                 GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    instancesDirty = false;
+}
@@ -0,0 +1,77 @@
+#include <utility>
+
+#include "shape/StreamedMesh.h"
+
+
+StreamedMesh::StreamedMesh(Shader * pShader, const std::vector<Vertex> & placeholder, const glm::mat4 & model)
+        : Mesh(pShader, placeholder, model)
+{
+
+}
+
+
+void StreamedMesh::render(float timeElapsedSinceLastFrame)
+{
+    if (pLoaded)
+    {
+        pLoaded->render(timeElapsedSinceLastFrame);
+    }
+    else
+    {
+        Mesh::render(timeElapsedSinceLastFrame);
+    }
+}
+
+
+std::size_t StreamedMesh::gpuBytes() const
+{
+    return Mesh::gpuBytes() + (pLoaded ? pLoaded->gpuBytes() : 0);
+}
+
+
+glm::vec4 StreamedMesh::boundingSphere() const
+{
+    if (pLoaded)
+    {
+        return pLoadedShape ? pLoadedShape->boundingSphere() : glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+    }
+
+    return Mesh::boundingSphere();
+}
+
+
+void StreamedMesh::setModel(const glm::mat4 & newModel)
+{
+    Mesh::setModel(newModel);
+
+    if (pLoadedShape)
+    {
+        pLoadedShape->setModel(newModel);
+    }
+}
+
+
+void StreamedMesh::setScreenRadius(float pixels)
+{
+    if (pLoadedShape)
+    {
+        pLoadedShape->setScreenRadius(pixels);
+    }
+}
+
+
+void StreamedMesh::setLoaded(std::unique_ptr<Renderable> pShape)
+{
+    pLoaded = std::move(pShape);
+    pLoadedShape = dynamic_cast<GLShape *>(pLoaded.get());
+
+    if (pLoadedShape)
+    {
+        pLoadedShape->setModel(model);
+    }
+
+    if (onLoaded)
+    {
+        onLoaded();
+    }
+}
@@ -1,60 +1,80 @@
+#include <utility>
+
 #include <glm/glm.hpp>
 
+#include "shape/Meshlets.h"
 #include "shape/Tetrahedron.h"
+#include "util/GeometrySoA.h"
+#include "util/NormalGenerator.h"
 #include "util/Shader.h"
 
 
 Tetrahedron::Tetrahedron(
         Shader * pShader,
         const std::string & vertexFile,
-        const glm::mat4 & model
+        const glm::mat4 & model,
+        const RenderContext * pContext
 )
-        : Mesh(pShader, model)
+        : Tetrahedron(pShader, load(vertexFile), model, pContext)
 {
-    // Initialize vertex data
-    if (std::ifstream fin {vertexFile})
-    {
-        glm::vec3 v1;
-        glm::vec3 v2;
-        glm::vec3 v3;
-
-        while (fin >> v1.x >> v1.y >> v1.z >> v2.x >> v2.y >> v2.z >> v3.x >> v3.y >> v3.z)
-        {
-            glm::vec3 fn = glm::normalize(glm::cross(v2 - v1, v3 - v2));
-            vertices.emplace_back(v1, fn, kColor);
-            vertices.emplace_back(v2, fn, kColor);
-            vertices.emplace_back(v3, fn, kColor);
-        }
-    }
-    else
+
+}
+
+
+Tetrahedron::Tetrahedron(
+        Shader * pShader,
+        std::vector<Vertex> vertices,
+        const glm::mat4 & model,
+        const RenderContext * pContext,
+        GLuint filledVbo
+)
+        : Mesh(pShader, model, pContext)
+{
+    this->vertices = std::move(vertices);
+    buildMeshlets();
+
+    if (filledVbo)
     {
-        throw std::runtime_error("failed to open " + vertexFile);
+        adoptVertexBuffer(filledVbo);
+        return;
     }
 
     // OpenGL pipeline configuration
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    uploadVertices();
+}
 
-    glBufferData(GL_ARRAY_BUFFER,
-                 static_cast<GLsizei>(this->vertices.size() * sizeof(Vertex)),
-                 vertices.data(),
-                 GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+Tetrahedron::Tetrahedron(
+        Shader * pShader,
+        std::vector<Vertex> vertices,
+        CompressedVertices packed,
+        const glm::mat4 & model,
+        const RenderContext * pContext,
+        GLuint filledVbo
+)
+        : Mesh(pShader, model, pContext)
+{
+    this->vertices = std::move(vertices);
+    buildMeshlets();
+    useCompressedVertices(std::move(packed), filledVbo);
 }
 
 
-void Tetrahedron::render(float timeElapsedSinceLastFrame)
+std::vector<Mesh::Vertex> Tetrahedron::load(const std::string & vertexFile)
 {
-    pShader->use();
-    pShader->setMat4("model", model);
+    // Initialize vertex data
+    GeometrySoA geometry = GeometrySoA::readTriangles(vertexFile);
+    NormalGenerator::generate(geometry, NormalGenerator::Options {});
+    geometry.setColor(kColor);
+
+    std::vector<Vertex> vertices = geometry.toVertices();
+    Meshlets::order(vertices);
 
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    return vertices;
+}
 
-    glDrawArrays(GL_TRIANGLES,
-                 0,                                       // start from index 0 in current VBO
-                 static_cast<GLsizei>(vertices.size()));  // draw these number of elements
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+void Tetrahedron::render(float timeElapsedSinceLastFrame)
+{
+    Mesh::render(timeElapsedSinceLastFrame);
 }
\ No newline at end of file
@@ -1,116 +1,120 @@
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
 #include "shape/icosahedron.h"
+#include "shape/Meshlets.h"
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
+#include "util/GeometrySoA.h"
+#include "util/NormalGenerator.h"
 #include "util/Shader.h"
+#include "util/Subdivision.h"
 
 
 icosahedron::icosahedron(
     Shader* pShader,
+    const RenderContext* pContext,
     const std::string& vertexFile, 
     const glm::mat4& model,
     glm::vec3 scale
 )
-    : Mesh(pShader, model), Scale(scale)
+    : icosahedron(pShader, pContext, load(vertexFile, scale), model, scale)
+{
+
+}
+
+
+icosahedron::icosahedron(
+    Shader* pShader,
+    const RenderContext* pContext,
+    std::vector<Level> levels,
+    const glm::mat4& model,
+    glm::vec3 scale,
+    GLuint filledVbo
+)
+    : LodMesh(pShader, pContext, model), Scale(scale)
+{
+    this->levels = std::move(levels);
+
+    // "+" appends levels.
+    setBufferUsage(DynamicBuffer::Usage::kStreamed);
+    uploadLevels(filledVbo);
+}
+
+
+std::vector<LodMesh::Level> icosahedron::load(const std::string& vertexFile, glm::vec3 scale)
 {
     // Initialize vertex data
-    if (std::ifstream fin{ vertexFile })
+    GeometrySoA geometry = GeometrySoA::readTriangles(vertexFile);
+    geometry.transformPositions(glm::scale(glm::mat4(1.0f), scale));
+    NormalGenerator::generate(geometry, NormalGenerator::Options {});
+    geometry.setColor(kColor);
+
+    std::vector<Vertex> vertices = geometry.toVertices();
+
+    std::vector<Level> levels;
+    levels.push_back({vertices, sphericalError(vertices)});
+
+    for (int i = 0; i != kDefaultSubdivisions; ++i)
     {
-        glm::vec3 v1;
-        glm::vec3 v2;
-        glm::vec3 v3;
-
-        while (fin >> v1.x >> v1.y >> v1.z >> v2.x >> v2.y >> v2.z >> v3.x >> v3.y >> v3.z)
-        {
-            glm::vec3 fn = glm::normalize(glm::cross(v2 - v1, v3 - v2));
-            vertices.emplace_back(v1 * scale, fn, kColor);
-            vertices.emplace_back(v2 * scale, fn, kColor);
-            vertices.emplace_back(v3 * scale, fn, kColor);
-        }
+        std::vector<Vertex> finer = Subdivision::subdivide(levels.back().vertices, scale);
+        float error = sphericalError(finer);
+        levels.push_back({std::move(finer), error});
     }
-    else
+
+    for (Level & level : levels)
     {
-        throw std::runtime_error("failed to open " + vertexFile);
+        Meshlets::order(level.vertices);
     }
 
-    ConfigurePipeline();
+    return levels;
 }
 
 
 void icosahedron::subDivide()
 {
-    std::vector<Mesh::Vertex> NewMesh;
-
-    for (int i = 0; i < vertices.size(); i += 3) {
-        glm::vec3 v0 = vertices[i + 0].position;
-        glm::vec3 v1 = vertices[i + 1].position;
-        glm::vec3 v2 = vertices[i + 2].position;
-
-        // Find midpoints of the edges of the triangle
-        glm::vec3 mid01 = Scale * glm::normalize((v0 + v1) * 0.5f);
-        glm::vec3 mid12 = Scale * glm::normalize((v1 + v2) * 0.5f);
-        glm::vec3 mid20 = Scale * glm::normalize((v2 + v0) * 0.5f);
-
-        // Calculate direction vectors from the origin (assumed to be the center of the sphere)
-        glm::vec3 normal01 = glm::normalize(v0); // Normal pointing outwards from the origin to v0
-        glm::vec3 normal12 = glm::normalize(v1); // Normal pointing outwards from the origin to v1
-        glm::vec3 normal20 = glm::normalize(v2); // Normal pointing outwards from the origin to v2
-
-        // Calculate midpoints and their normals
-        glm::vec3 normalMid01 = glm::normalize( Scale * glm::normalize(normal01 + normal12) ); // Average of normals at mid01
-        glm::vec3 normalMid12 = glm::normalize( Scale * glm::normalize(normal12 + normal20) ); // Average of normals at mid12
-        glm::vec3 normalMid20 = glm::normalize( Scale * glm::normalize(normal20 + normal01) ); // Average of normals at mid20
-
-
-        glm::vec3 color = vertices[i + 0].color; // Example color, could be dynamic based on position
-
-        // Add the new triangles with position, normal, and color data
-        NewMesh.push_back(Vertex{ v0, normal01, color });
-        NewMesh.push_back(Vertex{ mid01, normalMid01, color });
-        NewMesh.push_back(Vertex{ mid20, normalMid20, color });
-
-
-        NewMesh.push_back(Vertex{ v1, normal12, color });
-        NewMesh.push_back(Vertex{ mid01, normalMid01, color });
-        NewMesh.push_back(Vertex{ mid12, normalMid12, color });
-      
-        NewMesh.push_back(Vertex{ v2, normal20, color });
-        NewMesh.push_back(Vertex{ mid12, normalMid12, color });
-        NewMesh.push_back(Vertex{ mid20, normalMid20, color });
-        
-        NewMesh.push_back(Vertex{ mid01, normalMid01, color });
-        NewMesh.push_back(Vertex{ mid12, normalMid12, color });
-        NewMesh.push_back(Vertex{ mid20, normalMid20, color });
+    std::vector<Vertex> finer = Subdivision::subdivide(levels.back().vertices, Scale);
+    float error = sphericalError(finer);
+    float previous = levels.back().error;
+    Meshlets::order(finer);
+    appendLevel({std::move(finer), error});
+
+    // Shrink the budget as much as the error shrank, so every view draws about one level
+    // finer than before and the new level is reachable at all.
+    if (0.0f < error && error < previous)
+    {
+        setPixelError(getPixelError() * error / previous);
     }
-
-    vertices = NewMesh;
-    ConfigurePipeline();
 }
 
-void icosahedron::render(float timeElapsedSinceLastFrame)
+
+float icosahedron::sphericalError(const std::vector<Vertex> & triangles)
 {
-    pShader->use();
-    pShader->setMat4("model", model);
+    // Vertices lie on the surface; the flat triangle center sinks below it the most.
+    float error = 0.0f;
 
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    for (std::size_t i = 0; i + 2 < triangles.size(); i += 3)
+    {
+        glm::vec3 v0 = triangles[i + 0].position;
+        glm::vec3 v1 = triangles[i + 1].position;
+        glm::vec3 v2 = triangles[i + 2].position;
 
-    glDrawArrays(GL_TRIANGLES,
-        0,                                       // start from index 0 in current VBO
-        static_cast<GLsizei>(vertices.size()));  // draw these number of elements
+        float surface = (glm::length(v0) + glm::length(v1) + glm::length(v2)) / 3.0f;
+        error = std::max(error, surface - glm::length((v0 + v1 + v2) / 3.0f));
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    return error;
 }
 
-void icosahedron::ConfigurePipeline()
+void icosahedron::render(float timeElapsedSinceLastFrame)
 {
-    // OpenGL pipeline configuration
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
-    glBufferData(GL_ARRAY_BUFFER,
-        static_cast<GLsizei>(this->vertices.size() * sizeof(Vertex)),
-        vertices.data(),
-        GL_STATIC_DRAW);
+    LodMesh::render(timeElapsedSinceLastFrame);
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+void icosahedron::ConfigurePipeline()
+{
+    // OpenGL pipeline configuration: every level of the chain in one buffer
+    uploadLevels();
 }
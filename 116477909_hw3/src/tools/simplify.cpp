@@ -0,0 +1,191 @@
+/// Offline LOD generator for the triangle files under var/ (one "x y z" vertex per line,
+/// three lines per triangle). Writes <output>.lod1.txt, <output>.lod2.txt, ... in the
+/// same format, each about ratio times the triangles of the previous one.
+///
+/// Usage: simplify <input.txt> <output> [-l levels] [-r ratio] [-m min-triangles]
+///                 [-e max-error] [-j threads] [--lock-boundary]
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "util/MeshSimplifier.h"
+
+
+namespace
+{
+
+std::vector<Mesh::Vertex> readTriangles(const std::string & path)
+{
+    std::vector<Mesh::Vertex> vertices;
+
+    if (std::ifstream fin {path})
+    {
+        glm::vec3 v1;
+        glm::vec3 v2;
+        glm::vec3 v3;
+
+        while (fin >> v1.x >> v1.y >> v1.z >> v2.x >> v2.y >> v2.z >> v3.x >> v3.y >> v3.z)
+        {
+            glm::vec3 fn = glm::normalize(glm::cross(v2 - v1, v3 - v2));
+            vertices.emplace_back(v1, fn, glm::vec3(1.0f));
+            vertices.emplace_back(v2, fn, glm::vec3(1.0f));
+            vertices.emplace_back(v3, fn, glm::vec3(1.0f));
+        }
+    }
+    else
+    {
+        throw std::runtime_error("failed to open " + path);
+    }
+
+    return vertices;
+}
+
+
+void writeTriangles(const std::string & path, const std::vector<Mesh::Vertex> & vertices)
+{
+    std::ofstream fout {path};
+
+    if (!fout)
+    {
+        throw std::runtime_error("failed to open " + path + " for writing");
+    }
+
+    for (const Mesh::Vertex & v : vertices)
+    {
+        fout << v.position.x << ' ' << v.position.y << ' ' << v.position.z << '\n';
+    }
+}
+
+
+[[noreturn]] void usage()
+{
+    std::cerr << "usage: simplify <input.txt> <output> [-l levels] [-r ratio] [-m min-triangles]\n"
+                 "                [-e max-error] [-j threads] [--lock-boundary]\n";
+    std::exit(EXIT_FAILURE);
+}
+
+
+// The whole of value converted by convert, a std::sto* call; a usage error naming flag otherwise.
+template <typename Convert>
+auto flagValue(const std::string & flag, const std::string & value, Convert convert)
+{
+    try
+    {
+        std::size_t end = 0;
+        auto number = convert(value, &end);
+
+        if (end == value.size())
+        {
+            return number;
+        }
+    }
+    catch (const std::logic_error &)
+    {
+        // std::invalid_argument or std::out_of_range: reported below.
+    }
+
+    std::cerr << "simplify: invalid value \"" << value << "\" for " << flag << '\n';
+    usage();
+}
+
+
+unsigned long toCount(const std::string & value, std::size_t * pEnd)
+{
+    // std::stoul wraps negative numbers around instead of rejecting them.
+    if (value.find('-') != std::string::npos)
+    {
+        throw std::invalid_argument(value);
+    }
+
+    return std::stoul(value, pEnd);
+}
+
+}  // namespace
+
+
+int main(int argc, char * argv[])
+{
+    if (argc < 3)
+    {
+        usage();
+    }
+
+    std::string input = argv[1];
+    std::string output = argv[2];
+    MeshSimplifier::ChainOptions options;
+
+    for (int i = 3; i < argc; ++i)
+    {
+        std::string flag = argv[i];
+
+        if (flag == "--lock-boundary")
+        {
+            options.lockBoundary = true;
+            continue;
+        }
+
+        if (i + 1 == argc)
+        {
+            usage();
+        }
+
+        std::string value = argv[++i];
+
+        if (flag == "-l")
+        {
+            options.levels = flagValue(flag, value, [](const std::string & s, std::size_t * pEnd) { return std::stoi(s, pEnd); });
+        }
+        else if (flag == "-r")
+        {
+            options.ratio = flagValue(flag, value, [](const std::string & s, std::size_t * pEnd) { return std::stof(s, pEnd); });
+        }
+        else if (flag == "-m")
+        {
+            options.minTriangles = flagValue(flag, value, toCount);
+        }
+        else if (flag == "-e")
+        {
+            options.maxError = flagValue(flag, value, [](const std::string & s, std::size_t * pEnd) { return std::stof(s, pEnd); });
+        }
+        else if (flag == "-j")
+        {
+            options.threads = static_cast<unsigned>(flagValue(flag, value, toCount));
+        }
+        else
+        {
+            usage();
+        }
+    }
+
+    try
+    {
+        std::vector<LodMesh::Level> chain = MeshSimplifier::buildLodChain(readTriangles(input), options);
+
+        // chain is coarsest first and ends with the input, which is not written again.
+        std::cout << "lod0: " << chain.back().vertices.size() / 3 << " triangles (input)\n";
+
+        for (std::size_t lod = 1; lod < chain.size(); ++lod)
+        {
+            const LodMesh::Level & level = chain[chain.size() - 1 - lod];
+            std::string path = output + ".lod" + std::to_string(lod) + ".txt";
+
+            writeTriangles(path, level.vertices);
+
+            std::cout << "lod" << lod << ": " << level.vertices.size() / 3 << " triangles, error "
+                      << level.error << " -> " << path << '\n';
+        }
+    }
+    catch (const std::exception & e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
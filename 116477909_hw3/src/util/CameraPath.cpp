@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "util/CameraPath.h"
+
+
+namespace
+{
+
+// Rotation vector of unit quaternion q: log(q) without its zero real part.
+glm::vec3 logUnit(const glm::quat & q)
+{
+    glm::vec3 v {q.x, q.y, q.z};
+    float sine = glm::length(v);
+
+    if (sine < 1e-6f)
+    {
+        return glm::vec3(0.0f);
+    }
+
+    return v * (std::atan2(sine, q.w) / sine);
+}
+
+
+// Inverse of logUnit().
+glm::quat expPure(const glm::vec3 & v)
+{
+    float angle = glm::length(v);
+
+    if (angle < 1e-6f)
+    {
+        return {1.0f, 0.0f, 0.0f, 0.0f};
+    }
+
+    glm::vec3 axis = v * (std::sin(angle) / angle);
+
+    return {std::cos(angle), axis.x, axis.y, axis.z};
+}
+
+
+// Centripetal knot spacing; coincident keys get a tiny one instead of none.
+float knot(const glm::vec3 & a, const glm::vec3 & b)
+{
+    return std::max(std::sqrt(glm::length(b - a)), 1e-4f);
+}
+
+}  // namespace
+
+
+CameraPath::CameraPath(const std::vector<Pose> & keys)
+{
+    if (keys.empty())
+    {
+        throw std::invalid_argument("CameraPath: no keys");
+    }
+
+    first = keys.front();
+    segments.resize(keys.size() - 1);
+
+    fitPositions(keys);
+    fitRotations(keys);
+    measure();
+}
+
+
+CameraPath::Pose CameraPath::at(std::size_t segment, float u) const
+{
+    if (segments.empty())
+    {
+        return first;
+    }
+
+    const Segment & s = segments.at(segment);
+    u = std::clamp(u, 0.0f, 1.0f);
+
+    // Squad: slerp between the key rotations, bent toward the control rotations mid-segment.
+    glm::quat outer = glm::slerp(s.q0, s.q1, u);
+    glm::quat inner = glm::slerp(s.s0, s.s1, u);
+
+    return {positionAt(s, u), glm::normalize(glm::slerp(outer, inner, 2.0f * u * (1.0f - u)))};
+}
+
+
+CameraPath::Pose CameraPath::atFraction(float fraction) const
+{
+    fraction = std::clamp(fraction, 0.0f, 1.0f);
+
+    if (parameters.empty())
+    {
+        return atParameter(fraction * static_cast<float>(segments.size()));
+    }
+
+    float x = fraction * static_cast<float>(parameters.size() - 1);
+    std::size_t i = std::min(static_cast<std::size_t>(x), parameters.size() - 2);
+
+    return atParameter(glm::mix(parameters[i], parameters[i + 1], x - static_cast<float>(i)));
+}
+
+
+CameraPath::Pose CameraPath::atSegmentFraction(std::size_t segment, float fraction) const
+{
+    if (segments.empty())
+    {
+        return first;
+    }
+
+    float start = distances.at(segment);
+    float extent = distances.at(segment + 1) - start;
+
+    if (extent <= 0.0f)
+    {
+        return at(segment, fraction);
+    }
+
+    return atFraction((start + std::clamp(fraction, 0.0f, 1.0f) * extent) / length());
+}
+
+
+CameraPath::Pose CameraPath::atParameter(float g) const
+{
+    if (segments.empty())
+    {
+        return first;
+    }
+
+    g = std::max(g, 0.0f);
+    std::size_t segment = std::min(static_cast<std::size_t>(g), segments.size() - 1);
+
+    return at(segment, g - static_cast<float>(segment));
+}
+
+
+glm::vec3 CameraPath::positionAt(const Segment & segment, float u)
+{
+    return segment.c0 + u * (segment.c1 + u * (segment.c2 + u * segment.c3));
+}
+
+
+void CameraPath::fitPositions(const std::vector<Pose> & keys)
+{
+    const std::size_t count = keys.size();
+
+    for (std::size_t i = 0; i != segments.size(); ++i)
+    {
+        const glm::vec3 & p1 = keys[i].position;
+        const glm::vec3 & p2 = keys[i + 1].position;
+
+        // Phantom keys mirror the neighbour across the end, continuing the path straight.
+        glm::vec3 p0 = 0 < i ? keys[i - 1].position : 2.0f * p1 - p2;
+        glm::vec3 p3 = i + 2 < count ? keys[i + 2].position : 2.0f * p2 - p1;
+
+        float t01 = knot(p0, p1);
+        float t12 = knot(p1, p2);
+        float t23 = knot(p2, p3);
+
+        // Tangents of the non-uniform Catmull-Rom at p1 and p2, scaled to u in [0, 1].
+        glm::vec3 m1 = t12 * ((p1 - p0) / t01 - (p2 - p0) / (t01 + t12) + (p2 - p1) / t12);
+        glm::vec3 m2 = t12 * ((p2 - p1) / t12 - (p3 - p1) / (t12 + t23) + (p3 - p2) / t23);
+
+        Segment & s = segments[i];
+        s.c0 = p1;
+        s.c1 = m1;
+        s.c2 = 3.0f * (p2 - p1) - 2.0f * m1 - m2;
+        s.c3 = 2.0f * (p1 - p2) + m1 + m2;
+    }
+}
+
+
+void CameraPath::fitRotations(const std::vector<Pose> & keys)
+{
+    // Each rotation on the same hemisphere as the previous, so every segment turns the short way.
+    std::vector<glm::quat> q;
+    q.reserve(keys.size());
+
+    for (const Pose & key : keys)
+    {
+        glm::quat rotation = glm::normalize(key.rotation);
+
+        if (!q.empty() && glm::dot(q.back(), rotation) < 0.0f)
+        {
+            rotation = -rotation;
+        }
+
+        q.push_back(rotation);
+    }
+
+    // Shoemake's control rotations, matching the angular velocity on both sides of each key.
+    std::vector<glm::quat> controls(q);
+
+    for (std::size_t i = 1; i + 1 < q.size(); ++i)
+    {
+        glm::quat inverse = glm::conjugate(q[i]);
+        glm::vec3 turn = logUnit(inverse * q[i + 1]) + logUnit(inverse * q[i - 1]);
+        controls[i] = glm::normalize(q[i] * expPure(-0.25f * turn));
+    }
+
+    for (std::size_t i = 0; i != segments.size(); ++i)
+    {
+        segments[i].q0 = q[i];
+        segments[i].q1 = q[i + 1];
+        segments[i].s0 = controls[i];
+        segments[i].s1 = controls[i + 1];
+    }
+}
+
+
+void CameraPath::measure()
+{
+    // Polyline length at global parameters k / kSamplesPerSegment.
+    std::vector<float> cumulative {0.0f};
+    cumulative.reserve(segments.size() * kSamplesPerSegment + 1);
+
+    for (const Segment & segment : segments)
+    {
+        glm::vec3 previous = positionAt(segment, 0.0f);
+
+        for (std::size_t k = 1; k <= kSamplesPerSegment; ++k)
+        {
+            glm::vec3 next = positionAt(segment, static_cast<float>(k) / kSamplesPerSegment);
+            cumulative.push_back(cumulative.back() + glm::length(next - previous));
+            previous = next;
+        }
+    }
+
+    distances.clear();
+
+    for (std::size_t i = 0; i <= segments.size(); ++i)
+    {
+        distances.push_back(cumulative[i * kSamplesPerSegment]);
+    }
+
+    parameters.clear();
+
+    if (!(0.0f < length()))
+    {
+        return;
+    }
+
+    // Inverts cumulative at even distances; both only grow, so one pass does.
+    const std::size_t samples = cumulative.size() - 1;
+    const float step = length() / static_cast<float>(samples);
+    parameters.reserve(samples + 1);
+
+    std::size_t k = 0;
+
+    for (std::size_t j = 0; j != samples; ++j)
+    {
+        float distance = static_cast<float>(j) * step;
+
+        while (k + 1 < samples && cumulative[k + 1] < distance)
+        {
+            ++k;
+        }
+
+        float extent = cumulative[k + 1] - cumulative[k];
+        float t = 0.0f < extent ? std::clamp((distance - cumulative[k]) / extent, 0.0f, 1.0f) : 0.0f;
+
+        parameters.push_back((static_cast<float>(k) + t) / kSamplesPerSegment);
+    }
+
+    parameters.push_back(static_cast<float>(segments.size()));
+}
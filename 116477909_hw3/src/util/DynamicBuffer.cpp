@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "util/DynamicBuffer.h"
+
+
+DynamicBuffer::DynamicBuffer(GLenum target, Usage usage) : target(target), usage(usage)
+{
+
+}
+
+
+DynamicBuffer::~DynamicBuffer() noexcept
+{
+    releaseFence();
+}
+
+
+void DynamicBuffer::attach(GLuint newBuffer, std::size_t newBytes)
+{
+    releaseFence();
+    dirtyRanges.clear();
+
+    buffer = newBuffer;
+    bytes = newBytes;
+    capacity = newBytes;
+}
+
+
+void DynamicBuffer::respecify(const void * pData, std::size_t newBytes, std::size_t reserveBytes)
+{
+    dirtyRanges.clear();
+    bytes = newBytes;
+
+    glBindBuffer(target, buffer);
+
+    if (usage == Usage::kStatic)
+    {
+        capacity = bytes;
+        glBufferData(target, static_cast<GLsizeiptr>(bytes), pData, GL_STATIC_DRAW);
+    }
+    else
+    {
+        // Growing by half keeps meshes that grow a little per update from reallocating each time.
+        if (capacity < bytes)
+        {
+            capacity = std::max(bytes, capacity + capacity / 2);
+        }
+
+        capacity = std::max(capacity, reserveBytes);
+
+        orphan(pData);
+    }
+
+    glBindBuffer(target, 0U);
+    releaseFence();
+}
+
+
+bool DynamicBuffer::append(const void * pData, std::size_t count)
+{
+    if (capacity < bytes || capacity - bytes < count)
+    {
+        return false;
+    }
+
+    if (count != 0)
+    {
+        glBindBuffer(target, buffer);
+        write(static_cast<const unsigned char *>(pData), bytes, bytes + count);
+        glBindBuffer(target, 0U);
+    }
+
+    bytes += count;
+
+    return true;
+}
+
+
+void DynamicBuffer::markDirty(std::size_t offset, std::size_t count)
+{
+    if (bytes < offset || bytes - offset < count)
+    {
+        throw std::out_of_range("DynamicBuffer: dirty range past the end of the contents");
+    }
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::size_t begin = offset;
+    std::size_t end = offset + count;
+
+    // Absorbs every range overlapping or touching [begin, end).
+    auto first = std::lower_bound(dirtyRanges.begin(), dirtyRanges.end(), begin,
+                                  [](const auto & range, std::size_t value) { return range.second < value; });
+    auto last = first;
+
+    while (last != dirtyRanges.end() && last->first <= end)
+    {
+        begin = std::min(begin, last->first);
+        end = std::max(end, last->second);
+        ++last;
+    }
+
+    first = dirtyRanges.erase(first, last);
+    dirtyRanges.insert(first, {begin, end});
+
+    if (kMaxRanges < dirtyRanges.size())
+    {
+        dirtyRanges = {{dirtyRanges.front().first, dirtyRanges.back().second}};
+    }
+}
+
+
+void DynamicBuffer::flush(const void * pSource)
+{
+    if (dirtyRanges.empty())
+    {
+        return;
+    }
+
+    glBindBuffer(target, buffer);
+
+    if (usage == Usage::kStreamed && busy())
+    {
+        orphan(pSource);
+    }
+    else
+    {
+        // Nothing reads the buffer any more.
+        for (const auto & [begin, end] : dirtyRanges)
+        {
+            write(static_cast<const unsigned char *>(pSource) + begin, begin, end);
+        }
+    }
+
+    glBindBuffer(target, 0U);
+    dirtyRanges.clear();
+}
+
+
+void DynamicBuffer::fenceAfterDraw()
+{
+    if (usage != Usage::kStreamed || buffer == 0U)
+    {
+        return;
+    }
+
+    // The latest fence covers every earlier draw too.
+    releaseFence();
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+
+bool DynamicBuffer::busy()
+{
+    if (!fence)
+    {
+        return false;
+    }
+
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+    {
+        return true;
+    }
+
+    releaseFence();
+
+    return false;
+}
+
+
+void DynamicBuffer::releaseFence()
+{
+    if (fence)
+    {
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+
+void DynamicBuffer::write(const unsigned char * pBytes, std::size_t begin, std::size_t end)
+{
+    const auto offset = static_cast<GLintptr>(begin);
+    const auto count = static_cast<GLsizeiptr>(end - begin);
+
+    if (usage == Usage::kStatic)
+    {
+        glBufferSubData(target, offset, count, pBytes);
+        return;
+    }
+
+    // The caller vouches that nothing reads the range, so the driver need not check either.
+    void * pMapped = glMapBufferRange(target, offset, count,
+                                      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+    if (pMapped)
+    {
+        std::memcpy(pMapped, pBytes, end - begin);
+    }
+
+    if (!pMapped || glUnmapBuffer(target) == GL_FALSE)
+    {
+        glBufferSubData(target, offset, count, pBytes);
+    }
+}
+
+
+void DynamicBuffer::orphan(const void * pData)
+{
+    // Same size and usage as before, so drivers recycle a store instead of allocating one.
+    glBufferData(target, static_cast<GLsizeiptr>(capacity), nullptr, GL_STREAM_DRAW);
+
+    if (pData && bytes != 0)
+    {
+        glBufferSubData(target, 0, static_cast<GLsizeiptr>(bytes), pData);
+    }
+
+    releaseFence();
+}
@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+#include "util/GeometrySoA.h"
+
+
+namespace
+{
+
+// Thin wrappers so every kernel is written once for whichever instruction set the build targets.
+#if defined(__AVX2__)
+
+using Lane = __m256;
+constexpr std::size_t kWidth {8};
+
+inline Lane broadcast(float value) { return _mm256_set1_ps(value); }
+inline Lane load(const float * p) { return _mm256_load_ps(p); }
+inline void store(float * p, Lane a) { _mm256_store_ps(p, a); }
+inline Lane add(Lane a, Lane b) { return _mm256_add_ps(a, b); }
+inline Lane mul(Lane a, Lane b) { return _mm256_mul_ps(a, b); }
+inline Lane div(Lane a, Lane b) { return _mm256_div_ps(a, b); }
+inline Lane min(Lane a, Lane b) { return _mm256_min_ps(a, b); }
+inline Lane max(Lane a, Lane b) { return _mm256_max_ps(a, b); }
+inline Lane sqrt(Lane a) { return _mm256_sqrt_ps(a); }
+
+#ifdef __FMA__
+inline Lane madd(Lane a, Lane b, Lane c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+inline Lane madd(Lane a, Lane b, Lane c) { return add(mul(a, b), c); }
+#endif
+
+#elif defined(__SSE__) || defined(_M_X64)
+
+using Lane = __m128;
+constexpr std::size_t kWidth {4};
+
+inline Lane broadcast(float value) { return _mm_set1_ps(value); }
+inline Lane load(const float * p) { return _mm_load_ps(p); }
+inline void store(float * p, Lane a) { _mm_store_ps(p, a); }
+inline Lane add(Lane a, Lane b) { return _mm_add_ps(a, b); }
+inline Lane mul(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+inline Lane div(Lane a, Lane b) { return _mm_div_ps(a, b); }
+inline Lane min(Lane a, Lane b) { return _mm_min_ps(a, b); }
+inline Lane max(Lane a, Lane b) { return _mm_max_ps(a, b); }
+inline Lane sqrt(Lane a) { return _mm_sqrt_ps(a); }
+inline Lane madd(Lane a, Lane b, Lane c) { return add(mul(a, b), c); }
+
+#else
+
+using Lane = float;
+constexpr std::size_t kWidth {1};
+
+inline Lane broadcast(float value) { return value; }
+inline Lane load(const float * p) { return *p; }
+inline void store(float * p, Lane a) { *p = a; }
+inline Lane add(Lane a, Lane b) { return a + b; }
+inline Lane mul(Lane a, Lane b) { return a * b; }
+inline Lane div(Lane a, Lane b) { return a / b; }
+inline Lane min(Lane a, Lane b) { return std::min(a, b); }
+inline Lane max(Lane a, Lane b) { return std::max(a, b); }
+inline Lane sqrt(Lane a) { return std::sqrt(a); }
+inline Lane madd(Lane a, Lane b, Lane c) { return a * b + c; }
+
+#endif
+
+
+// Smallest length normalizeNormals() divides by, so zero vectors stay zero without a branch.
+constexpr float kTinyLength {1e-30f};
+
+
+// Applies the 3x3 part of m (and its translation if affine) to the vectors (x, y, z)
+// in place, count entries, kWidth at a time. The arrays come from a GeometrySoA, so they
+// start kAlignment-aligned.
+void transformArrays(const glm::mat4 & m, bool affine, float * x, float * y, float * z, std::size_t count)
+{
+    const Lane m00 = broadcast(m[0][0]), m01 = broadcast(m[0][1]), m02 = broadcast(m[0][2]);
+    const Lane m10 = broadcast(m[1][0]), m11 = broadcast(m[1][1]), m12 = broadcast(m[1][2]);
+    const Lane m20 = broadcast(m[2][0]), m21 = broadcast(m[2][1]), m22 = broadcast(m[2][2]);
+    const Lane tx = broadcast(affine ? m[3][0] : 0.0f);
+    const Lane ty = broadcast(affine ? m[3][1] : 0.0f);
+    const Lane tz = broadcast(affine ? m[3][2] : 0.0f);
+
+    std::size_t i = 0;
+
+    for (; i + kWidth <= count; i += kWidth)
+    {
+        const Lane vx = load(x + i);
+        const Lane vy = load(y + i);
+        const Lane vz = load(z + i);
+
+        store(x + i, madd(m00, vx, madd(m10, vy, madd(m20, vz, tx))));
+        store(y + i, madd(m01, vx, madd(m11, vy, madd(m21, vz, ty))));
+        store(z + i, madd(m02, vx, madd(m12, vy, madd(m22, vz, tz))));
+    }
+
+    for (; i < count; ++i)
+    {
+        glm::vec4 v = m * glm::vec4(x[i], y[i], z[i], affine ? 1.0f : 0.0f);
+        x[i] = v.x;
+        y[i] = v.y;
+        z[i] = v.z;
+    }
+}
+
+}  // namespace
+
+
+const std::size_t GeometrySoA::kLanes {kWidth};
+
+
+GeometrySoA::GeometrySoA(const std::vector<Mesh::Vertex> & vertices)
+{
+    resize(vertices.size());
+
+    for (std::size_t i = 0; i != vertices.size(); ++i)
+    {
+        px[i] = vertices[i].position.x;
+        py[i] = vertices[i].position.y;
+        pz[i] = vertices[i].position.z;
+        nx[i] = vertices[i].normal.x;
+        ny[i] = vertices[i].normal.y;
+        nz[i] = vertices[i].normal.z;
+        r[i] = vertices[i].color.x;
+        g[i] = vertices[i].color.y;
+        b[i] = vertices[i].color.z;
+    }
+}
+
+
+GeometrySoA GeometrySoA::readTriangles(const std::string & file)
+{
+    std::ifstream fin {file};
+
+    if (!fin)
+    {
+        throw std::runtime_error("failed to open " + file);
+    }
+
+    GeometrySoA geometry;
+    float corner[9];
+
+    while (fin >> corner[0] >> corner[1] >> corner[2]
+               >> corner[3] >> corner[4] >> corner[5]
+               >> corner[6] >> corner[7] >> corner[8])
+    {
+        for (int k = 0; k != 3; ++k)
+        {
+            geometry.px.push_back(corner[3 * k]);
+            geometry.py.push_back(corner[3 * k + 1]);
+            geometry.pz.push_back(corner[3 * k + 2]);
+        }
+    }
+
+    std::size_t count = geometry.px.size();
+    geometry.nx.assign(count, 0.0f);
+    geometry.ny.assign(count, 0.0f);
+    geometry.nz.assign(count, 0.0f);
+    geometry.setColor(glm::vec3(1.0f));
+
+    return geometry;
+}
+
+
+std::size_t GeometrySoA::size() const
+{
+    return px.size();
+}
+
+
+void GeometrySoA::resize(std::size_t count)
+{
+    for (Array * pArray : {&px, &py, &pz, &nx, &ny, &nz, &r, &g, &b})
+    {
+        pArray->resize(count, 0.0f);
+    }
+}
+
+
+void GeometrySoA::transformPositions(const glm::mat4 & model)
+{
+    transformArrays(model, true, px.data(), py.data(), pz.data(), size());
+}
+
+
+void GeometrySoA::normalizeNormals()
+{
+    const std::size_t count = size();
+    const Lane tiny = broadcast(kTinyLength);
+
+    std::size_t i = 0;
+
+    for (; i + kWidth <= count; i += kWidth)
+    {
+        const Lane x = load(&nx[i]);
+        const Lane y = load(&ny[i]);
+        const Lane z = load(&nz[i]);
+
+        const Lane length = max(sqrt(madd(x, x, madd(y, y, mul(z, z)))), tiny);
+
+        store(&nx[i], div(x, length));
+        store(&ny[i], div(y, length));
+        store(&nz[i], div(z, length));
+    }
+
+    for (; i < count; ++i)
+    {
+        float length = std::max(std::sqrt(nx[i] * nx[i] + ny[i] * ny[i] + nz[i] * nz[i]), kTinyLength);
+        nx[i] /= length;
+        ny[i] /= length;
+        nz[i] /= length;
+    }
+}
+
+
+GeometrySoA::Bounds GeometrySoA::bounds() const
+{
+    const std::size_t count = size();
+
+    if (count == 0)
+    {
+        return {};
+    }
+
+    constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+    Lane loX = broadcast(kInfinity), loY = broadcast(kInfinity), loZ = broadcast(kInfinity);
+    Lane hiX = broadcast(-kInfinity), hiY = broadcast(-kInfinity), hiZ = broadcast(-kInfinity);
+
+    std::size_t i = 0;
+
+    for (; i + kWidth <= count; i += kWidth)
+    {
+        const Lane x = load(&px[i]);
+        const Lane y = load(&py[i]);
+        const Lane z = load(&pz[i]);
+
+        loX = min(loX, x);
+        loY = min(loY, y);
+        loZ = min(loZ, z);
+        hiX = max(hiX, x);
+        hiY = max(hiY, y);
+        hiZ = max(hiZ, z);
+    }
+
+    // Reduce the lanes, then fold in the tail.
+    alignas(kAlignment) float lanes[6][kWidth];
+    store(lanes[0], loX);
+    store(lanes[1], loY);
+    store(lanes[2], loZ);
+    store(lanes[3], hiX);
+    store(lanes[4], hiY);
+    store(lanes[5], hiZ);
+
+    Bounds result {glm::vec3(kInfinity), glm::vec3(-kInfinity)};
+
+    for (std::size_t lane = 0; lane != kWidth; ++lane)
+    {
+        result.min = glm::min(result.min, glm::vec3(lanes[0][lane], lanes[1][lane], lanes[2][lane]));
+        result.max = glm::max(result.max, glm::vec3(lanes[3][lane], lanes[4][lane], lanes[5][lane]));
+    }
+
+    for (; i < count; ++i)
+    {
+        result.min = glm::min(result.min, glm::vec3(px[i], py[i], pz[i]));
+        result.max = glm::max(result.max, glm::vec3(px[i], py[i], pz[i]));
+    }
+
+    return result;
+}
+
+
+void GeometrySoA::setColor(const glm::vec3 & color)
+{
+    r.assign(size(), color.x);
+    g.assign(size(), color.y);
+    b.assign(size(), color.z);
+}
+
+
+void GeometrySoA::interleave(Mesh::Vertex * pOut) const
+{
+    for (std::size_t i = 0, count = size(); i != count; ++i)
+    {
+        new (pOut + i) Mesh::Vertex({px[i], py[i], pz[i]}, {nx[i], ny[i], nz[i]}, {r[i], g[i], b[i]});
+    }
+}
+
+
+std::vector<Mesh::Vertex> GeometrySoA::toVertices() const
+{
+    std::vector<Mesh::Vertex> vertices;
+    vertices.reserve(size());
+
+    for (std::size_t i = 0, count = size(); i != count; ++i)
+    {
+        vertices.emplace_back(glm::vec3(px[i], py[i], pz[i]),
+                              glm::vec3(nx[i], ny[i], nz[i]),
+                              glm::vec3(r[i], g[i], b[i]));
+    }
+
+    return vertices;
+}
+
+
+void GeometrySoA::upload(GLuint vbo, GLenum usage) const
+{
+    const auto bytes = static_cast<GLsizeiptr>(size() * sizeof(Mesh::Vertex));
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, usage);
+
+    if (0 < bytes)
+    {
+        void * pMapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+        if (pMapped)
+        {
+            interleave(static_cast<Mesh::Vertex *>(pMapped));
+        }
+
+        // GL_FALSE means the store's contents were corrupted while mapped, as a screen mode change
+        // or other display event can do; upload through a copy then.
+        if (!pMapped || glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE)
+        {
+            std::vector<Mesh::Vertex> vertices = toVertices();
+            glBufferData(GL_ARRAY_BUFFER, bytes, vertices.data(), usage);
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
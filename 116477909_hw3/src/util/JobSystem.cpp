@@ -0,0 +1,631 @@
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#include "util/JobSystem.h"
+
+
+namespace
+{
+
+// The system and deque of the calling thread, if it owns one.
+thread_local const JobSystem * tlsSystem {nullptr};
+thread_local unsigned tlsDeque {0};
+
+// Whether the calling thread is running a background job, whose jobs are background too.
+thread_local bool tlsBackground {false};
+
+// Victim choice; any cheap per-thread sequence will do.
+thread_local std::uint32_t tlsRandom {0x9E3779B9U};
+
+std::uint32_t nextRandom()
+{
+    tlsRandom ^= tlsRandom << 13U;
+    tlsRandom ^= tlsRandom >> 17U;
+    tlsRandom ^= tlsRandom << 5U;
+    return tlsRandom;
+}
+
+}  // namespace
+
+
+JobSystem::Deque::Ring::Ring(std::int64_t capacity)
+        : capacity(capacity), slots(std::make_unique<std::atomic<Job *>[]>(static_cast<std::size_t>(capacity)))
+{
+
+}
+
+
+JobSystem::Deque::Deque() : ring(new Ring(kInitialCapacity))
+{
+
+}
+
+
+JobSystem::Deque::~Deque()
+{
+    delete ring.load(std::memory_order_relaxed);
+}
+
+
+void JobSystem::Deque::push(Job * pJob)
+{
+    std::int64_t b = bottom.load(std::memory_order_relaxed);
+    std::int64_t t = top.load(std::memory_order_acquire);
+    Ring * pRing = ring.load(std::memory_order_relaxed);
+
+    if (pRing->capacity - 1 < b - t)
+    {
+        auto pGrown = new Ring(2 * pRing->capacity);
+
+        for (std::int64_t i = t; i != b; ++i)
+        {
+            pGrown->put(i, pRing->get(i));
+        }
+
+        retired.emplace_back(pRing);
+        ring.store(pGrown, std::memory_order_release);
+        pRing = pGrown;
+    }
+
+    pRing->put(b, pJob);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+
+JobSystem::Job * JobSystem::Deque::pop()
+{
+    std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    Ring * pRing = ring.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t t = top.load(std::memory_order_relaxed);
+
+    if (b < t)
+    {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job * pJob = pRing->get(b);
+
+    // The last job: race thieves for it.
+    if (t == b)
+    {
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            pJob = nullptr;
+        }
+
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    return pJob;
+}
+
+
+JobSystem::Job * JobSystem::Deque::steal()
+{
+    std::int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t b = bottom.load(std::memory_order_acquire);
+
+    if (b <= t)
+    {
+        return nullptr;
+    }
+
+    Job * pJob = ring.load(std::memory_order_acquire)->get(t);
+
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+
+    return pJob;
+}
+
+
+JobSystem::JobSystem(unsigned threads) : posted(std::make_unique<PostedSlot[]>(kPostSlots))
+{
+    if (threads == 0)
+    {
+        threads = std::max(2U, std::thread::hardware_concurrency()) - 1U;
+    }
+
+    for (unsigned i = 0; i <= threads; ++i)
+    {
+        deques.push_back(std::make_unique<Deque>());
+    }
+
+    tlsSystem = this;
+    tlsDeque = 0;
+
+    workers.reserve(threads);
+
+    for (unsigned i = 1; i <= threads; ++i)
+    {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+
+JobSystem::~JobSystem() noexcept
+{
+    shutdown();
+
+    if (tlsSystem == this)
+    {
+        tlsSystem = nullptr;
+    }
+}
+
+
+JobSystem & JobSystem::shared()
+{
+    static JobSystem instance;
+    return instance;
+}
+
+
+void JobSystem::submit(Task task, Counter * pCounter)
+{
+    if (pCounter)
+    {
+        pCounter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto pJob = new Job {std::move(task), pCounter, tlsBackground};
+
+    // Nobody left to run it.
+    if (stopping.load(std::memory_order_acquire))
+    {
+        runInline(pJob);
+        return;
+    }
+
+    enqueue(pJob);
+}
+
+
+void JobSystem::submitBackground(Task task, Counter * pCounter)
+{
+    if (pCounter)
+    {
+        pCounter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto pJob = new Job {std::move(task), pCounter, true};
+
+    if (stopping.load(std::memory_order_acquire))
+    {
+        runInline(pJob);
+        return;
+    }
+
+    enqueue(pJob);
+}
+
+
+bool JobSystem::post(PostedFunction function, const void * pArguments, std::size_t bytes)
+{
+    if (kPostBytes < bytes)
+    {
+        throw std::invalid_argument("JobSystem: posted arguments larger than kPostBytes");
+    }
+
+    if (stopping.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    // Counted before it can be taken, so shutdown() waits for it.
+    outstanding.fetch_add(1, std::memory_order_acq_rel);
+
+    std::uint64_t ticket = postTicket.fetch_add(1, std::memory_order_relaxed);
+    PostedSlot & slot = posted[ticket % kPostSlots];
+    int expected = PostedSlot::kFree;
+
+    // Still taken a lap ago: the ring is full.
+    if (!slot.state.compare_exchange_strong(expected, PostedSlot::kWriting, std::memory_order_acquire))
+    {
+        outstanding.fetch_sub(1, std::memory_order_acq_rel);
+        return false;
+    }
+
+    slot.ticket = ticket;
+    slot.function = function;
+
+    if (bytes != 0)
+    {
+        std::memcpy(slot.arguments, pArguments, bytes);
+    }
+
+    slot.state.store(PostedSlot::kReady, std::memory_order_release);
+    postedReady.fetch_add(1, std::memory_order_release);
+    work.fetch_add(1, std::memory_order_seq_cst);
+
+    return true;
+}
+
+
+void JobSystem::after(Counter & dependency, Task task, Counter * pCounter)
+{
+    if (pCounter)
+    {
+        pCounter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto pJob = new Job {std::move(task), pCounter, tlsBackground};
+
+    {
+        std::lock_guard lock(dependency.mutex);
+
+        if (!dependency.done())
+        {
+            dependency.continuations.push_back(pJob);
+            return;
+        }
+    }
+
+    if (stopping.load(std::memory_order_acquire))
+    {
+        runInline(pJob);
+    }
+    else
+    {
+        enqueue(pJob);
+    }
+}
+
+
+void JobSystem::wait(Counter & counter)
+{
+    unsigned index = self();
+
+    while (!counter.done())
+    {
+        if (Job * pJob = find(index))
+        {
+            run(pJob);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    // Taking the lock also waits out a finish() still holding it, before counter may go away.
+    std::exception_ptr error;
+
+    {
+        std::lock_guard lock(counter.mutex);
+        std::swap(error, counter.error);
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+
+void JobSystem::rethrowUncaught()
+{
+    std::exception_ptr error;
+
+    {
+        std::lock_guard lock(uncaughtMutex);
+        std::swap(error, uncaught);
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+
+void JobSystem::shutdown()
+{
+    if (stopping.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    // Help with whatever is still queued, so no job is dropped.
+    unsigned index = self();
+
+    while (outstanding.load(std::memory_order_acquire) != 0)
+    {
+        if (Job * pJob = find(index))
+        {
+            run(pJob);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    stopping.store(true, std::memory_order_release);
+
+    {
+        std::lock_guard lock(sleepMutex);
+        wake.notify_all();
+    }
+
+    for (std::thread & worker : workers)
+    {
+        worker.join();
+    }
+
+    workers.clear();
+}
+
+
+void JobSystem::workerLoop(unsigned index)
+{
+    tlsSystem = this;
+    tlsDeque = index;
+    tlsRandom ^= index * 0x85EBCA6BU;
+
+    while (!stopping.load(std::memory_order_acquire))
+    {
+        std::uint64_t seen = work.load(std::memory_order_seq_cst);
+
+        if (Job * pJob = find(index))
+        {
+            run(pJob);
+            continue;
+        }
+
+        // Announce sleeping before the last look, so a submitter either sees a sleeper
+        // to wake or its job is found here.
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+
+        if (Job * pJob = find(index))
+        {
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+            run(pJob);
+            continue;
+        }
+
+        {
+            std::unique_lock lock(sleepMutex);
+            wake.wait_for(lock, kIdleWait, [this, seen]
+            {
+                return work.load(std::memory_order_seq_cst) != seen || stopping.load(std::memory_order_acquire);
+            });
+        }
+
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+
+JobSystem::Job * JobSystem::find(unsigned self)
+{
+    if (self != kNoDeque)
+    {
+        if (Job * pJob = deques[self]->pop())
+        {
+            return pJob;
+        }
+    }
+
+    // try_lock: a worker never blocks behind a submitter.
+    {
+        std::unique_lock lock(injectionMutex, std::try_to_lock);
+
+        if (lock.owns_lock() && !injected.empty())
+        {
+            Job * pJob = injected.back();
+            injected.pop_back();
+            return pJob;
+        }
+    }
+
+    if (Job * pJob = takePosted())
+    {
+        return pJob;
+    }
+
+    const auto count = static_cast<unsigned>(deques.size());
+    unsigned first = nextRandom() % count;
+
+    for (unsigned i = 0; i != count; ++i)
+    {
+        unsigned victim = (first + i) % count;
+
+        if (victim == self)
+        {
+            continue;
+        }
+
+        if (Job * pJob = deques[victim]->steal())
+        {
+            return pJob;
+        }
+    }
+
+    if (self == 0 || self == kNoDeque)
+    {
+        return nullptr;
+    }
+
+    std::unique_lock lock(backgroundMutex, std::try_to_lock);
+
+    if (!lock.owns_lock() || background.empty())
+    {
+        return nullptr;
+    }
+
+    Job * pJob = background.front();
+    background.pop_front();
+
+    return pJob;
+}
+
+
+JobSystem::Job * JobSystem::takePosted()
+{
+    if (postedReady.load(std::memory_order_acquire) == 0)
+    {
+        return nullptr;
+    }
+
+    std::unique_lock lock(postedMutex, std::try_to_lock);
+
+    if (!lock.owns_lock())
+    {
+        return nullptr;
+    }
+
+    // Slots fill out of order when producers race, so the lowest ticket goes first.
+    PostedSlot * pOldest = nullptr;
+
+    for (std::size_t i = 0; i != kPostSlots; ++i)
+    {
+        PostedSlot & slot = posted[i];
+
+        if (slot.state.load(std::memory_order_acquire) == PostedSlot::kReady &&
+            (!pOldest || slot.ticket < pOldest->ticket))
+        {
+            pOldest = &slot;
+        }
+    }
+
+    if (!pOldest)
+    {
+        return nullptr;
+    }
+
+    PostedFunction function = pOldest->function;
+    std::array<unsigned char, kPostBytes> arguments {};
+    std::memcpy(arguments.data(), pOldest->arguments, kPostBytes);
+
+    pOldest->state.store(PostedSlot::kFree, std::memory_order_release);
+    postedReady.fetch_sub(1, std::memory_order_relaxed);
+
+    // Already counted in outstanding by post().
+    return new Job {[function, arguments] { function(arguments.data()); }, nullptr, false};
+}
+
+
+unsigned JobSystem::self() const
+{
+    return tlsSystem == this ? tlsDeque : kNoDeque;
+}
+
+
+void JobSystem::run(Job * pJob)
+{
+    const bool wasBackground = tlsBackground;
+    tlsBackground = pJob->background;
+
+    try
+    {
+        pJob->task();
+    }
+    catch (...)
+    {
+        if (pJob->pCounter)
+        {
+            std::lock_guard lock(pJob->pCounter->mutex);
+
+            if (!pJob->pCounter->error)
+            {
+                pJob->pCounter->error = std::current_exception();
+            }
+        }
+        else
+        {
+            std::lock_guard lock(uncaughtMutex);
+
+            if (!uncaught)
+            {
+                uncaught = std::current_exception();
+            }
+        }
+    }
+
+    tlsBackground = wasBackground;
+
+    Counter * pCounter = pJob->pCounter;
+    delete pJob;
+
+    if (pCounter)
+    {
+        finish(*pCounter);
+    }
+
+    outstanding.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+
+void JobSystem::runInline(Job * pJob)
+{
+    outstanding.fetch_add(1, std::memory_order_acq_rel);
+    run(pJob);
+}
+
+
+void JobSystem::enqueue(Job * pJob)
+{
+    outstanding.fetch_add(1, std::memory_order_acq_rel);
+
+    unsigned index = self();
+
+    if (pJob->background)
+    {
+        std::lock_guard lock(backgroundMutex);
+        background.push_back(pJob);
+    }
+    else if (index != kNoDeque)
+    {
+        deques[index]->push(pJob);
+    }
+    else
+    {
+        std::lock_guard lock(injectionMutex);
+        injected.push_back(pJob);
+    }
+
+    work.fetch_add(1, std::memory_order_seq_cst);
+
+    if (sleepers.load(std::memory_order_seq_cst) != 0)
+    {
+        wake.notify_one();
+    }
+}
+
+
+void JobSystem::finish(Counter & counter)
+{
+    std::vector<Job *> ready;
+
+    {
+        std::lock_guard lock(counter.mutex);
+
+        if (counter.pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+
+        std::swap(ready, counter.continuations);
+    }
+
+    for (Job * pJob : ready)
+    {
+        if (stopping.load(std::memory_order_acquire))
+        {
+            runInline(pJob);
+        }
+        else
+        {
+            enqueue(pJob);
+        }
+    }
+}
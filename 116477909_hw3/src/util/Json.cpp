@@ -0,0 +1,581 @@
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include "util/Json.h"
+
+
+class Json::Parser
+{
+public:
+    explicit Parser(const std::string & text) : text(text) {}
+
+    Json parseDocument()
+    {
+        Json value = parseValue("", 0);
+        skipWhitespace();
+
+        if (position != text.size())
+        {
+            error("end of input");
+        }
+
+        return value;
+    }
+
+private:
+    // depth: arrays and objects enclosing the value.
+    Json parseValue(const std::string & path, std::size_t depth)
+    {
+        skipWhitespace();
+
+        if (position == text.size())
+        {
+            error("a value");
+        }
+
+        Json value;
+        value.location = path;
+
+        // Each level is a native stack frame, so runaway nesting is an error, not a crash.
+        if ((text[position] == '{' || text[position] == '[') && kMaxDepth <= depth)
+        {
+            error("at most " + std::to_string(kMaxDepth) + " nested arrays and objects in " +
+                  (path.empty() ? std::string("document root") : path));
+        }
+
+        switch (text[position])
+        {
+            case '{':
+                value.valueType = Type::kObject;
+                parseObject(value, depth + 1);
+                break;
+            case '[':
+                value.valueType = Type::kArray;
+                parseArray(value, depth + 1);
+                break;
+            case '"':
+                value.valueType = Type::kString;
+                value.string = parseString();
+                break;
+            case 't':
+                expectWord("true");
+                value.valueType = Type::kBool;
+                value.boolean = true;
+                break;
+            case 'f':
+                expectWord("false");
+                value.valueType = Type::kBool;
+                break;
+            case 'n':
+                expectWord("null");
+                break;
+            default:
+                value.valueType = Type::kNumber;
+                value.number = parseNumber();
+                break;
+        }
+
+        return value;
+    }
+
+    void parseObject(Json & value, std::size_t depth)
+    {
+        ++position;  // '{'
+        skipWhitespace();
+
+        if (consume('}'))
+        {
+            return;
+        }
+
+        do
+        {
+            skipWhitespace();
+
+            if (position == text.size() || text[position] != '"')
+            {
+                error("a member name");
+            }
+
+            std::string key = parseString();
+            skipWhitespace();
+
+            if (!consume(':'))
+            {
+                error("':'");
+            }
+
+            std::string memberPath = value.location.empty() ? key : value.location + "." + key;
+            value.object.emplace_back(key, parseValue(memberPath, depth));
+            skipWhitespace();
+        }
+        while (consume(','));
+
+        if (!consume('}'))
+        {
+            error("',' or '}'");
+        }
+    }
+
+    void parseArray(Json & value, std::size_t depth)
+    {
+        ++position;  // '['
+        skipWhitespace();
+
+        if (consume(']'))
+        {
+            return;
+        }
+
+        do
+        {
+            value.array.push_back(parseValue(value.location + "[" + std::to_string(value.array.size()) + "]", depth));
+            skipWhitespace();
+        }
+        while (consume(','));
+
+        if (!consume(']'))
+        {
+            error("',' or ']'");
+        }
+    }
+
+    std::string parseString()
+    {
+        ++position;  // '"'
+        std::string result;
+
+        while (true)
+        {
+            if (position == text.size())
+            {
+                error("closing '\"'");
+            }
+
+            char c = text[position++];
+
+            if (c == '"')
+            {
+                return result;
+            }
+
+            if (static_cast<unsigned char>(c) < 0x20U)
+            {
+                --position;
+                error("no control characters in strings");
+            }
+
+            if (c != '\\')
+            {
+                result += c;
+                continue;
+            }
+
+            if (position == text.size())
+            {
+                error("an escape sequence");
+            }
+
+            switch (text[position++])
+            {
+                case '"': result += '"'; break;
+                case '\\': result += '\\'; break;
+                case '/': result += '/'; break;
+                case 'b': result += '\b'; break;
+                case 'f': result += '\f'; break;
+                case 'n': result += '\n'; break;
+                case 'r': result += '\r'; break;
+                case 't': result += '\t'; break;
+                case 'u': appendUtf8(result, parseCodePoint()); break;
+                default:
+                    --position;
+                    error("a valid escape sequence");
+            }
+        }
+    }
+
+    // After "\u": one UTF-16 unit, or a surrogate pair spelled as two escapes.
+    unsigned parseCodePoint()
+    {
+        unsigned unit = parseHex4();
+
+        if (0xD800U <= unit && unit <= 0xDBFFU)
+        {
+            if (!consume('\\') || !consume('u'))
+            {
+                error("a low surrogate escape");
+            }
+
+            unsigned low = parseHex4();
+
+            if (low < 0xDC00U || 0xDFFFU < low)
+            {
+                error("a low surrogate");
+            }
+
+            return 0x10000U + ((unit - 0xD800U) << 10U) + (low - 0xDC00U);
+        }
+
+        if (0xDC00U <= unit && unit <= 0xDFFFU)
+        {
+            position -= 4;
+            error("a high surrogate before a low surrogate");
+        }
+
+        return unit;
+    }
+
+    unsigned parseHex4()
+    {
+        unsigned value = 0;
+
+        for (int i = 0; i != 4; ++i)
+        {
+            if (position == text.size() || !std::isxdigit(static_cast<unsigned char>(text[position])))
+            {
+                error("four hex digits");
+            }
+
+            char c = text[position++];
+            value = value * 16U + static_cast<unsigned>(std::isdigit(static_cast<unsigned char>(c))
+                                                        ? c - '0'
+                                                        : (std::tolower(static_cast<unsigned char>(c)) - 'a' + 10));
+        }
+
+        return value;
+    }
+
+    static void appendUtf8(std::string & out, unsigned codePoint)
+    {
+        if (codePoint < 0x80U)
+        {
+            out += static_cast<char>(codePoint);
+        }
+        else if (codePoint < 0x800U)
+        {
+            out += static_cast<char>(0xC0U | (codePoint >> 6U));
+            out += static_cast<char>(0x80U | (codePoint & 0x3FU));
+        }
+        else if (codePoint < 0x10000U)
+        {
+            out += static_cast<char>(0xE0U | (codePoint >> 12U));
+            out += static_cast<char>(0x80U | ((codePoint >> 6U) & 0x3FU));
+            out += static_cast<char>(0x80U | (codePoint & 0x3FU));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0U | (codePoint >> 18U));
+            out += static_cast<char>(0x80U | ((codePoint >> 12U) & 0x3FU));
+            out += static_cast<char>(0x80U | ((codePoint >> 6U) & 0x3FU));
+            out += static_cast<char>(0x80U | (codePoint & 0x3FU));
+        }
+    }
+
+    double parseNumber()
+    {
+        // Validate the JSON grammar first; strtod alone would also take "0x1p3", "inf" or "+1".
+        std::size_t start = position;
+
+        consume('-');
+
+        if (consume('0'))
+        {
+        }
+        else if (!digits())
+        {
+            error("a value");
+        }
+
+        if (consume('.') && !digits())
+        {
+            error("digits after '.'");
+        }
+
+        if (consume('e') || consume('E'))
+        {
+            if (!consume('+'))
+            {
+                consume('-');
+            }
+
+            if (!digits())
+            {
+                error("exponent digits");
+            }
+        }
+
+        double value = std::strtod(text.substr(start, position - start).c_str(), nullptr);
+
+        // Values such as 1e999 overflow to infinity, which no accessor or writer can hold.
+        if (!std::isfinite(value))
+        {
+            position = start;
+            error("a number within the range of a double");
+        }
+
+        return value;
+    }
+
+    bool digits()
+    {
+        std::size_t start = position;
+
+        while (position != text.size() && std::isdigit(static_cast<unsigned char>(text[position])))
+        {
+            ++position;
+        }
+
+        return position != start;
+    }
+
+    void expectWord(const char * word)
+    {
+        std::size_t length = std::char_traits<char>::length(word);
+
+        if (text.compare(position, length, word) != 0)
+        {
+            error("a value");
+        }
+
+        position += length;
+    }
+
+    bool consume(char c)
+    {
+        if (position != text.size() && text[position] == c)
+        {
+            ++position;
+            return true;
+        }
+
+        return false;
+    }
+
+    void skipWhitespace()
+    {
+        while (position != text.size() &&
+               (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r'))
+        {
+            ++position;
+        }
+    }
+
+    [[noreturn]] void error(const std::string & expected) const
+    {
+        std::size_t line = 1;
+        std::size_t column = 1;
+
+        for (std::size_t i = 0; i != position && i != text.size(); ++i)
+        {
+            if (text[i] == '\n')
+            {
+                ++line;
+                column = 1;
+            }
+            else
+            {
+                ++column;
+            }
+        }
+
+        throw std::runtime_error("JSON syntax error at line " + std::to_string(line) +
+                                 ", column " + std::to_string(column) + ": expected " + expected);
+    }
+
+    const std::string & text;
+    std::size_t position {0};
+};
+
+
+Json Json::parse(const std::string & text)
+{
+    return Parser(text).parseDocument();
+}
+
+
+Json Json::load(const std::string & file)
+{
+    std::ifstream fin {file};
+
+    if (!fin)
+    {
+        throw std::runtime_error("failed to open " + file);
+    }
+
+    std::ostringstream contents;
+    contents << fin.rdbuf();
+
+    try
+    {
+        return parse(contents.str());
+    }
+    catch (const std::runtime_error & e)
+    {
+        throw std::runtime_error(file + ": " + e.what());
+    }
+}
+
+
+bool Json::asBool() const
+{
+    if (valueType != Type::kBool)
+    {
+        fail("true or false");
+    }
+
+    return boolean;
+}
+
+
+double Json::asNumber() const
+{
+    if (valueType != Type::kNumber)
+    {
+        fail("a number");
+    }
+
+    return number;
+}
+
+
+float Json::asFloat() const
+{
+    return static_cast<float>(asNumber());
+}
+
+
+int Json::asInt() const
+{
+    double value = asNumber();
+
+    if (value != std::floor(value))
+    {
+        fail("an integer");
+    }
+
+    // Casting a double outside the range of int is undefined.
+    if (value < static_cast<double>(std::numeric_limits<int>::min()) ||
+        static_cast<double>(std::numeric_limits<int>::max()) < value)
+    {
+        fail("an integer between " + std::to_string(std::numeric_limits<int>::min()) +
+             " and " + std::to_string(std::numeric_limits<int>::max()));
+    }
+
+    return static_cast<int>(value);
+}
+
+
+const std::string & Json::asString() const
+{
+    if (valueType != Type::kString)
+    {
+        fail("a string");
+    }
+
+    return string;
+}
+
+
+std::size_t Json::size() const
+{
+    return items().size();
+}
+
+
+const Json & Json::operator[](std::size_t index) const
+{
+    const std::vector<Json> & values = items();
+
+    if (values.size() <= index)
+    {
+        fail("at least " + std::to_string(index + 1) + " elements");
+    }
+
+    return values[index];
+}
+
+
+const std::vector<Json> & Json::items() const
+{
+    if (valueType != Type::kArray)
+    {
+        fail("an array");
+    }
+
+    return array;
+}
+
+
+const Json * Json::find(const std::string & key) const
+{
+    for (const auto & [name, value] : members())
+    {
+        if (name == key)
+        {
+            return &value;
+        }
+    }
+
+    return nullptr;
+}
+
+
+const Json & Json::operator[](const std::string & key) const
+{
+    if (const Json * pValue = find(key))
+    {
+        return *pValue;
+    }
+
+    fail("a member \"" + key + "\"");
+}
+
+
+const std::vector<std::pair<std::string, Json>> & Json::members() const
+{
+    if (valueType != Type::kObject)
+    {
+        fail("an object");
+    }
+
+    return object;
+}
+
+
+float Json::get(const std::string & key, float fallback) const
+{
+    const Json * pValue = find(key);
+    return pValue ? pValue->asFloat() : fallback;
+}
+
+
+int Json::get(const std::string & key, int fallback) const
+{
+    const Json * pValue = find(key);
+    return pValue ? pValue->asInt() : fallback;
+}
+
+
+bool Json::get(const std::string & key, bool fallback) const
+{
+    const Json * pValue = find(key);
+    return pValue ? pValue->asBool() : fallback;
+}
+
+
+std::string Json::get(const std::string & key, const char * fallback) const
+{
+    const Json * pValue = find(key);
+    return pValue ? pValue->asString() : fallback;
+}
+
+
+void Json::fail(const std::string & expected) const
+{
+    throw std::runtime_error((location.empty() ? std::string("document root") : location) + ": expected " + expected);
+}
@@ -0,0 +1,861 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <queue>
+#include <unordered_map>
+
+#include "util/MeshSimplifier.h"
+#include "util/Parallel.h"
+
+
+namespace
+{
+
+// Constraint planes on open boundaries weigh this much more than surface planes.
+constexpr double kBoundaryWeight = 100.0;
+
+// Meshes below this many triangles are not worth splitting across threads.
+constexpr std::size_t kParallelMinTriangles = 16384;
+
+// A collapse may not turn a triangle normal by more than about 78 degrees.
+constexpr double kMinNormalCosine = 0.2;
+
+constexpr std::uint32_t kNoVertex = 0xFFFFFFFFU;
+
+
+/// Symmetric 4x4 error quadric (upper triangle): the sum of squared distances to a set of planes.
+struct Quadric
+{
+    static Quadric plane(double a, double b, double c, double d, double weight)
+    {
+        return {{weight * a * a, weight * a * b, weight * a * c, weight * a * d,
+                 weight * b * b, weight * b * c, weight * b * d,
+                 weight * c * c, weight * c * d,
+                 weight * d * d}};
+    }
+
+    Quadric & operator+=(const Quadric & rhs)
+    {
+        for (std::size_t i = 0; i != q.size(); ++i)
+        {
+            q[i] += rhs.q[i];
+        }
+
+        return *this;
+    }
+
+    [[nodiscard]] Quadric operator+(const Quadric & rhs) const
+    {
+        Quadric sum = *this;
+        sum += rhs;
+        return sum;
+    }
+
+    [[nodiscard]] double error(const glm::vec3 & p) const
+    {
+        double x = p.x;
+        double y = p.y;
+        double z = p.z;
+
+        return q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x
+               + q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y
+               + q[7] * z * z + 2.0 * q[8] * z
+               + q[9];
+    }
+
+    // Point of least error, if the quadric is well conditioned enough to have one.
+    [[nodiscard]] bool optimum(glm::vec3 & out) const
+    {
+        // Cramer's rule on A x = -b with A the upper-left 3x3 block.
+        double a00 = q[0], a01 = q[1], a02 = q[2];
+        double a11 = q[4], a12 = q[5], a22 = q[7];
+        double b0 = -q[3], b1 = -q[6], b2 = -q[8];
+
+        double c00 = a11 * a22 - a12 * a12;
+        double c01 = a02 * a12 - a01 * a22;
+        double c02 = a01 * a12 - a02 * a11;
+        double det = a00 * c00 + a01 * c01 + a02 * c02;
+
+        double scale = std::abs(a00) + std::abs(a11) + std::abs(a22);
+
+        if (std::abs(det) <= 1e-12 * scale * scale * scale)
+        {
+            return false;
+        }
+
+        double c11 = a00 * a22 - a02 * a02;
+        double c12 = a01 * a02 - a00 * a12;
+        double c22 = a00 * a11 - a01 * a01;
+
+        out = glm::vec3(static_cast<float>((c00 * b0 + c01 * b1 + c02 * b2) / det),
+                        static_cast<float>((c01 * b0 + c11 * b1 + c12 * b2) / det),
+                        static_cast<float>((c02 * b0 + c12 * b1 + c22 * b2) / det));
+
+        return true;
+    }
+
+    std::array<double, 10> q {};
+};
+
+
+/// Welded triangle mesh the simplifier works on.
+struct IndexedMesh
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec3> colors;
+    std::vector<char> locked;
+
+    // Index of the vertex in the mesh this one was cut from (see simplifyIndexed), or kNoVertex.
+    std::vector<std::uint32_t> origin;
+
+    std::vector<std::array<std::uint32_t, 3>> triangles;
+
+    // Normals are recomputed per face on output instead of interpolated.
+    bool flatShaded {true};
+
+    std::uint32_t addVertex(const glm::vec3 & position, const glm::vec3 & normal, const glm::vec3 & color,
+                            bool isLocked, std::uint32_t originIndex)
+    {
+        positions.push_back(position);
+        normals.push_back(normal);
+        colors.push_back(color);
+        locked.push_back(isLocked ? 1 : 0);
+        origin.push_back(originIndex);
+
+        return static_cast<std::uint32_t>(positions.size() - 1);
+    }
+};
+
+
+struct WeldKey
+{
+    bool operator==(const WeldKey & rhs) const
+    {
+        return values == rhs.values;
+    }
+
+    std::array<float, 9> values;
+};
+
+
+struct WeldKeyHash
+{
+    std::size_t operator()(const WeldKey & key) const
+    {
+        std::size_t seed = 0;
+
+        for (float value : key.values)
+        {
+            std::uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            seed ^= std::hash<std::uint32_t>()(bits) + 0x9E3779B9U + (seed << 6U) + (seed >> 2U);
+        }
+
+        return seed;
+    }
+};
+
+
+WeldKey weldKey(const glm::vec3 & position, const glm::vec3 & normal, const glm::vec3 & color)
+{
+    // + 0.0f folds -0.0f into 0.0f so both hash alike.
+    return {{position.x + 0.0f, position.y + 0.0f, position.z + 0.0f,
+             normal.x + 0.0f, normal.y + 0.0f, normal.z + 0.0f,
+             color.x + 0.0f, color.y + 0.0f, color.z + 0.0f}};
+}
+
+
+IndexedMesh weld(const std::vector<Mesh::Vertex> & triangles)
+{
+    IndexedMesh mesh;
+
+    for (std::size_t i = 0; i + 2 < triangles.size() && mesh.flatShaded; i += 3)
+    {
+        const glm::vec3 & n = triangles[i].normal;
+
+        // Degenerate triangles carry NaN face normals; they are dropped below anyway.
+        if (!std::isfinite(n.x) || !std::isfinite(n.y) || !std::isfinite(n.z))
+        {
+            continue;
+        }
+
+        mesh.flatShaded = n == triangles[i + 1].normal && n == triangles[i + 2].normal;
+    }
+
+    std::unordered_map<WeldKey, std::uint32_t, WeldKeyHash> indices;
+
+    for (std::size_t i = 0; i + 2 < triangles.size(); i += 3)
+    {
+        std::array<std::uint32_t, 3> triangle {};
+
+        for (std::size_t k = 0; k != 3; ++k)
+        {
+            const Mesh::Vertex & v = triangles[i + k];
+            glm::vec3 normal = mesh.flatShaded ? glm::vec3(0.0f) : v.normal;
+
+            auto [it, inserted] = indices.try_emplace(weldKey(v.position, normal, v.color), 0U);
+
+            if (inserted)
+            {
+                it->second = mesh.addVertex(v.position, normal, v.color, false, kNoVertex);
+            }
+
+            triangle[k] = it->second;
+        }
+
+        if (triangle[0] != triangle[1] && triangle[1] != triangle[2] && triangle[2] != triangle[0])
+        {
+            mesh.triangles.push_back(triangle);
+        }
+    }
+
+    // Vertices sharing a position but not attributes sit on a seam; they may not move.
+    std::unordered_map<WeldKey, std::uint32_t, WeldKeyHash> firstAtPosition;
+
+    for (std::uint32_t v = 0; v != mesh.positions.size(); ++v)
+    {
+        auto [it, inserted] = firstAtPosition.try_emplace(weldKey(mesh.positions[v], {}, {}), v);
+
+        if (!inserted)
+        {
+            mesh.locked[v] = 1;
+            mesh.locked[it->second] = 1;
+        }
+    }
+
+    return mesh;
+}
+
+
+std::vector<Mesh::Vertex> unweld(const IndexedMesh & mesh)
+{
+    std::vector<Mesh::Vertex> triangles;
+    triangles.reserve(mesh.triangles.size() * 3);
+
+    for (const auto & triangle : mesh.triangles)
+    {
+        const glm::vec3 & p0 = mesh.positions[triangle[0]];
+        const glm::vec3 & p1 = mesh.positions[triangle[1]];
+        const glm::vec3 & p2 = mesh.positions[triangle[2]];
+        glm::vec3 faceNormal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+
+        for (std::uint32_t v : triangle)
+        {
+            glm::vec3 normal = mesh.flatShaded ? faceNormal : glm::normalize(mesh.normals[v]);
+            triangles.emplace_back(mesh.positions[v], normal, mesh.colors[v]);
+        }
+    }
+
+    return triangles;
+}
+
+
+/// Greedy edge-collapse simplification of one IndexedMesh.
+class Collapser
+{
+public:
+    Collapser(IndexedMesh & mesh, bool lockBoundary) : mesh(mesh)
+    {
+        std::size_t vertexCount = mesh.positions.size();
+
+        quadrics.resize(vertexCount);
+        vertexTriangles.resize(vertexCount);
+        version.resize(vertexCount, 0U);
+        vertexRemoved.resize(vertexCount, 0);
+        triangleRemoved.resize(mesh.triangles.size(), 0);
+        liveTriangles = mesh.triangles.size();
+
+        // (edge key, triangle) for every triangle side, to find unique and boundary edges.
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> sides;
+        sides.reserve(mesh.triangles.size() * 3);
+
+        for (std::uint32_t t = 0; t != mesh.triangles.size(); ++t)
+        {
+            const auto & triangle = mesh.triangles[t];
+            glm::vec3 n = faceNormal(t);
+
+            if (glm::length(n) > 0.0f)
+            {
+                n = glm::normalize(n);
+                Quadric plane = Quadric::plane(n.x, n.y, n.z, -glm::dot(n, mesh.positions[triangle[0]]), 1.0);
+
+                for (std::uint32_t v : triangle)
+                {
+                    quadrics[v] += plane;
+                }
+            }
+
+            for (std::size_t k = 0; k != 3; ++k)
+            {
+                vertexTriangles[triangle[k]].push_back(t);
+                sides.emplace_back(edgeKey(triangle[k], triangle[(k + 1) % 3]), t);
+            }
+        }
+
+        std::sort(sides.begin(), sides.end());
+
+        for (std::size_t i = 0; i != sides.size();)
+        {
+            std::size_t j = i;
+
+            while (j != sides.size() && sides[j].first == sides[i].first)
+            {
+                ++j;
+            }
+
+            auto a = static_cast<std::uint32_t>(sides[i].first >> 32U);
+            auto b = static_cast<std::uint32_t>(sides[i].first & 0xFFFFFFFFU);
+
+            if (j - i == 1)
+            {
+                addBoundary(a, b, sides[i].second, lockBoundary);
+            }
+
+            i = j;
+        }
+
+        for (std::size_t i = 0; i != sides.size(); ++i)
+        {
+            if (i == 0 || sides[i].first != sides[i - 1].first)
+            {
+                push(static_cast<std::uint32_t>(sides[i].first >> 32U),
+                     static_cast<std::uint32_t>(sides[i].first & 0xFFFFFFFFU));
+            }
+        }
+    }
+
+    // Collapses edges until targetTriangles remain or the next one would exceed maxError.
+    // Returns the largest error of any collapse taken.
+    float run(std::size_t targetTriangles, float maxError)
+    {
+        double maxCost = static_cast<double>(maxError) * static_cast<double>(maxError);
+        double worst = 0.0;
+
+        while (targetTriangles < liveTriangles && !heap.empty())
+        {
+            Candidate candidate = heap.top();
+            heap.pop();
+
+            if (maxCost < candidate.cost)
+            {
+                break;
+            }
+
+            if (vertexRemoved[candidate.keep] || vertexRemoved[candidate.remove] ||
+                version[candidate.keep] != candidate.keepVersion ||
+                version[candidate.remove] != candidate.removeVersion)
+            {
+                continue;
+            }
+
+            if (!collapse(candidate))
+            {
+                continue;
+            }
+
+            worst = std::max(worst, candidate.cost);
+        }
+
+        return static_cast<float>(std::sqrt(worst));
+    }
+
+    // Drops removed triangles and unreferenced vertices from the mesh.
+    void compact()
+    {
+        IndexedMesh result;
+        result.flatShaded = mesh.flatShaded;
+
+        std::vector<std::uint32_t> remap(mesh.positions.size(), kNoVertex);
+
+        for (std::uint32_t t = 0; t != mesh.triangles.size(); ++t)
+        {
+            if (triangleRemoved[t])
+            {
+                continue;
+            }
+
+            std::array<std::uint32_t, 3> triangle {};
+
+            for (std::size_t k = 0; k != 3; ++k)
+            {
+                std::uint32_t v = mesh.triangles[t][k];
+
+                if (remap[v] == kNoVertex)
+                {
+                    remap[v] = result.addVertex(mesh.positions[v], mesh.normals[v], mesh.colors[v],
+                                                mesh.locked[v] != 0, mesh.origin[v]);
+                }
+
+                triangle[k] = remap[v];
+            }
+
+            result.triangles.push_back(triangle);
+        }
+
+        mesh = std::move(result);
+    }
+
+private:
+    struct Candidate
+    {
+        bool operator>(const Candidate & rhs) const
+        {
+            return cost > rhs.cost;
+        }
+
+        double cost;
+        std::uint32_t keep;
+        std::uint32_t remove;
+        std::uint32_t keepVersion;
+        std::uint32_t removeVersion;
+        glm::vec3 target;
+    };
+
+    static std::uint64_t edgeKey(std::uint32_t a, std::uint32_t b)
+    {
+        return (static_cast<std::uint64_t>(std::min(a, b)) << 32U) | std::max(a, b);
+    }
+
+    [[nodiscard]] glm::vec3 faceNormal(std::uint32_t t) const
+    {
+        const auto & triangle = mesh.triangles[t];
+        const glm::vec3 & p0 = mesh.positions[triangle[0]];
+
+        return glm::cross(mesh.positions[triangle[1]] - p0, mesh.positions[triangle[2]] - p0);
+    }
+
+    void addBoundary(std::uint32_t a, std::uint32_t b, std::uint32_t t, bool lockBoundary)
+    {
+        if (lockBoundary)
+        {
+            mesh.locked[a] = 1;
+            mesh.locked[b] = 1;
+            return;
+        }
+
+        // Plane through the edge, perpendicular to its face: keeps the boundary where it is.
+        glm::vec3 edge = mesh.positions[b] - mesh.positions[a];
+        glm::vec3 n = glm::cross(edge, faceNormal(t));
+
+        if (glm::length(n) == 0.0f)
+        {
+            return;
+        }
+
+        n = glm::normalize(n);
+        Quadric plane = Quadric::plane(n.x, n.y, n.z, -glm::dot(n, mesh.positions[a]), kBoundaryWeight);
+
+        quadrics[a] += plane;
+        quadrics[b] += plane;
+    }
+
+    void push(std::uint32_t a, std::uint32_t b)
+    {
+        if (mesh.locked[a] && mesh.locked[b])
+        {
+            return;
+        }
+
+        // A locked vertex stays put and takes the other one in.
+        if (mesh.locked[b])
+        {
+            std::swap(a, b);
+        }
+
+        Quadric q = quadrics[a] + quadrics[b];
+        const glm::vec3 & pa = mesh.positions[a];
+        const glm::vec3 & pb = mesh.positions[b];
+
+        glm::vec3 target = pa;
+
+        if (!mesh.locked[a])
+        {
+            glm::vec3 optimum;
+            glm::vec3 mid = (pa + pb) * 0.5f;
+
+            // Far-off optima of nearly flat quadrics are numerically meaningless.
+            if (q.optimum(optimum) && glm::length(optimum - mid) <= 2.0f * glm::length(pb - pa))
+            {
+                target = optimum;
+            }
+            else
+            {
+                target = q.error(pb) < q.error(pa) ? pb : pa;
+                target = q.error(mid) < q.error(target) ? mid : target;
+            }
+        }
+
+        heap.push({std::max(0.0, q.error(target)), a, b, version[a], version[b], target});
+    }
+
+    // Applies the collapse unless it would fold or pinch the surface.
+    bool collapse(const Candidate & candidate)
+    {
+        std::uint32_t keep = candidate.keep;
+        std::uint32_t remove = candidate.remove;
+
+        pruneTriangles(keep);
+        pruneTriangles(remove);
+
+        // Link condition: the only vertices adjacent to both ends are the ones opposite the edge.
+        std::vector<std::uint32_t> keepRing = ring(keep);
+        std::vector<std::uint32_t> removeRing = ring(remove);
+        std::vector<std::uint32_t> common;
+        std::set_intersection(keepRing.begin(), keepRing.end(), removeRing.begin(), removeRing.end(),
+                              std::back_inserter(common));
+
+        std::size_t shared = 0;
+
+        for (std::uint32_t t : vertexTriangles[remove])
+        {
+            shared += contains(t, keep) ? 1 : 0;
+        }
+
+        if (shared == 0 || common.size() != shared)
+        {
+            return false;
+        }
+
+        if (flips(keep, remove, candidate.target) || flips(remove, keep, candidate.target))
+        {
+            return false;
+        }
+
+        // Attributes follow the position along the edge.
+        glm::vec3 edge = mesh.positions[remove] - mesh.positions[keep];
+        float length2 = glm::dot(edge, edge);
+        float t = length2 > 0.0f ? glm::clamp(glm::dot(candidate.target - mesh.positions[keep], edge) / length2, 0.0f, 1.0f) : 0.0f;
+
+        mesh.positions[keep] = candidate.target;
+        mesh.normals[keep] = glm::mix(mesh.normals[keep], mesh.normals[remove], t);
+        mesh.colors[keep] = glm::mix(mesh.colors[keep], mesh.colors[remove], t);
+        quadrics[keep] += quadrics[remove];
+
+        for (std::uint32_t tri : vertexTriangles[remove])
+        {
+            if (contains(tri, keep))
+            {
+                triangleRemoved[tri] = 1;
+                --liveTriangles;
+                continue;
+            }
+
+            for (std::uint32_t & v : mesh.triangles[tri])
+            {
+                v = v == remove ? keep : v;
+            }
+
+            vertexTriangles[keep].push_back(tri);
+        }
+
+        vertexTriangles[remove].clear();
+        vertexRemoved[remove] = 1;
+        ++version[keep];
+
+        pruneTriangles(keep);
+
+        for (std::uint32_t neighbor : ring(keep))
+        {
+            push(keep, neighbor);
+        }
+
+        return true;
+    }
+
+    // Whether moving moved to target turns any of its triangles (other than those on
+    // the edge to other) over or degenerates it.
+    [[nodiscard]] bool flips(std::uint32_t moved, std::uint32_t other, const glm::vec3 & target) const
+    {
+        for (std::uint32_t t : vertexTriangles[moved])
+        {
+            if (contains(t, other))
+            {
+                continue;
+            }
+
+            glm::vec3 before = faceNormal(t);
+
+            std::array<glm::vec3, 3> p {};
+
+            for (std::size_t k = 0; k != 3; ++k)
+            {
+                std::uint32_t v = mesh.triangles[t][k];
+                p[k] = v == moved ? target : mesh.positions[v];
+            }
+
+            glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+            double lengths = static_cast<double>(glm::length(before)) * glm::length(after);
+
+            if (lengths <= 0.0 || glm::dot(before, after) < kMinNormalCosine * lengths)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    [[nodiscard]] bool contains(std::uint32_t t, std::uint32_t v) const
+    {
+        const auto & triangle = mesh.triangles[t];
+        return triangle[0] == v || triangle[1] == v || triangle[2] == v;
+    }
+
+    // Sorted vertices sharing a live triangle with v.
+    [[nodiscard]] std::vector<std::uint32_t> ring(std::uint32_t v) const
+    {
+        std::vector<std::uint32_t> neighbors;
+
+        for (std::uint32_t t : vertexTriangles[v])
+        {
+            for (std::uint32_t u : mesh.triangles[t])
+            {
+                if (u != v)
+                {
+                    neighbors.push_back(u);
+                }
+            }
+        }
+
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+
+        return neighbors;
+    }
+
+    void pruneTriangles(std::uint32_t v)
+    {
+        std::vector<std::uint32_t> & list = vertexTriangles[v];
+        list.erase(std::remove_if(list.begin(), list.end(), [this](std::uint32_t t) { return triangleRemoved[t] != 0; }),
+                   list.end());
+    }
+
+    IndexedMesh & mesh;
+
+    std::vector<Quadric> quadrics;
+    std::vector<std::vector<std::uint32_t>> vertexTriangles;
+    std::vector<std::uint32_t> version;
+    std::vector<char> vertexRemoved;
+    std::vector<char> triangleRemoved;
+    std::size_t liveTriangles {0};
+
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> heap;
+};
+
+
+// Simplifies mesh in place, see MeshSimplifier. Returns the largest collapse error.
+float simplifyIndexed(IndexedMesh & mesh, std::size_t targetTriangles, float maxError, bool lockBoundary, unsigned threads)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    float error = 0.0f;
+    std::size_t triangleCount = mesh.triangles.size();
+
+    if (1 < threads && kParallelMinTriangles <= triangleCount && targetTriangles < triangleCount)
+    {
+        // Cut into slabs of equal triangle count along the longest axis of the bounding box.
+        glm::vec3 lo = mesh.positions.front();
+        glm::vec3 hi = lo;
+
+        for (const glm::vec3 & p : mesh.positions)
+        {
+            lo = glm::min(lo, p);
+            hi = glm::max(hi, p);
+        }
+
+        glm::vec3 extent = hi - lo;
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+        std::vector<std::pair<float, std::uint32_t>> order(triangleCount);
+
+        for (std::uint32_t t = 0; t != triangleCount; ++t)
+        {
+            const auto & triangle = mesh.triangles[t];
+            order[t] = {mesh.positions[triangle[0]][axis] + mesh.positions[triangle[1]][axis] + mesh.positions[triangle[2]][axis], t};
+        }
+
+        std::sort(order.begin(), order.end());
+
+        std::size_t slabs = threads;
+        std::vector<std::uint32_t> triangleSlab(triangleCount);
+
+        for (std::size_t i = 0; i != triangleCount; ++i)
+        {
+            triangleSlab[order[i].second] = static_cast<std::uint32_t>(i * slabs / triangleCount);
+        }
+
+        // Vertices used by more than one slab are on a border.
+        std::vector<std::uint32_t> vertexSlab(mesh.positions.size(), kNoVertex);
+        std::vector<char> border(mesh.positions.size(), 0);
+
+        for (std::uint32_t t = 0; t != triangleCount; ++t)
+        {
+            for (std::uint32_t v : mesh.triangles[t])
+            {
+                if (vertexSlab[v] == kNoVertex)
+                {
+                    vertexSlab[v] = triangleSlab[t];
+                }
+                else if (vertexSlab[v] != triangleSlab[t])
+                {
+                    border[v] = 1;
+                }
+            }
+        }
+
+        std::vector<IndexedMesh> parts(slabs);
+        std::vector<float> partErrors(slabs, 0.0f);
+
+        parallelFor(0, slabs, [&](std::size_t slab)
+        {
+            IndexedMesh & part = parts[slab];
+            part.flatShaded = mesh.flatShaded;
+
+            std::unordered_map<std::uint32_t, std::uint32_t> local;
+
+            for (std::uint32_t t = 0; t != triangleCount; ++t)
+            {
+                if (triangleSlab[t] != slab)
+                {
+                    continue;
+                }
+
+                std::array<std::uint32_t, 3> triangle {};
+
+                for (std::size_t k = 0; k != 3; ++k)
+                {
+                    std::uint32_t v = mesh.triangles[t][k];
+                    auto [it, inserted] = local.try_emplace(v, 0U);
+
+                    if (inserted)
+                    {
+                        // Border vertices remember where they came from, to stitch the slabs back.
+                        it->second = part.addVertex(mesh.positions[v], mesh.normals[v], mesh.colors[v],
+                                                    mesh.locked[v] || border[v], border[v] ? v : kNoVertex);
+                    }
+
+                    triangle[k] = it->second;
+                }
+
+                part.triangles.push_back(triangle);
+            }
+
+            std::size_t partTarget = targetTriangles * part.triangles.size() / triangleCount;
+
+            Collapser collapser(part, lockBoundary);
+            partErrors[slab] = collapser.run(partTarget, maxError);
+            collapser.compact();
+        }, 1, threads);
+
+        IndexedMesh merged;
+        merged.flatShaded = mesh.flatShaded;
+
+        std::unordered_map<std::uint32_t, std::uint32_t> borderVertices;
+
+        for (const IndexedMesh & part : parts)
+        {
+            std::vector<std::uint32_t> remap(part.positions.size());
+
+            for (std::uint32_t v = 0; v != part.positions.size(); ++v)
+            {
+                std::uint32_t from = part.origin[v];
+
+                if (from == kNoVertex)
+                {
+                    remap[v] = merged.addVertex(part.positions[v], part.normals[v], part.colors[v],
+                                                part.locked[v] != 0, kNoVertex);
+                    continue;
+                }
+
+                auto [it, inserted] = borderVertices.try_emplace(from, 0U);
+
+                if (inserted)
+                {
+                    it->second = merged.addVertex(mesh.positions[from], mesh.normals[from], mesh.colors[from],
+                                                  mesh.locked[from] != 0, kNoVertex);
+                }
+
+                remap[v] = it->second;
+            }
+
+            for (const auto & triangle : part.triangles)
+            {
+                merged.triangles.push_back({remap[triangle[0]], remap[triangle[1]], remap[triangle[2]]});
+            }
+        }
+
+        mesh = std::move(merged);
+        error = *std::max_element(partErrors.begin(), partErrors.end());
+    }
+
+    // Serial pass (or the whole job for small meshes): also collapses across the slab borders.
+    Collapser collapser(mesh, lockBoundary);
+    error = std::max(error, collapser.run(targetTriangles, maxError));
+    collapser.compact();
+
+    return error;
+}
+
+}  // namespace
+
+
+LodMesh::Level MeshSimplifier::simplify(const std::vector<Mesh::Vertex> & triangles, const Options & options)
+{
+    IndexedMesh mesh = weld(triangles);
+
+    if (mesh.triangles.empty())
+    {
+        return {triangles, 0.0f};
+    }
+
+    float error = simplifyIndexed(mesh, options.targetTriangles, options.maxError, options.lockBoundary, options.threads);
+
+    return {unweld(mesh), error};
+}
+
+
+std::vector<LodMesh::Level> MeshSimplifier::buildLodChain(const std::vector<Mesh::Vertex> & triangles,
+                                                          const ChainOptions & options)
+{
+    std::vector<LodMesh::Level> chain {{triangles, 0.0f}};
+
+    IndexedMesh mesh = weld(triangles);
+    float error = 0.0f;
+
+    for (int level = 0; level != options.levels && !mesh.triangles.empty(); ++level)
+    {
+        std::size_t before = mesh.triangles.size();
+        auto target = static_cast<std::size_t>(static_cast<float>(before) * options.ratio);
+
+        if (target < options.minTriangles)
+        {
+            break;
+        }
+
+        IndexedMesh coarser = mesh;
+        float levelError = simplifyIndexed(coarser, target, options.maxError - error, options.lockBoundary, options.threads);
+
+        // Nothing left to remove within the error budget.
+        if (coarser.triangles.size() == before)
+        {
+            break;
+        }
+
+        mesh = std::move(coarser);
+        error += levelError;
+        chain.push_back({unweld(mesh), error});
+    }
+
+    std::reverse(chain.begin(), chain.end());
+
+    return chain;
+}
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+#include "util/NormalGenerator.h"
+#include "util/Parallel.h"
+
+
+namespace
+{
+
+constexpr std::size_t kGrain {4096};
+
+
+// Maps each corner to a welded vertex id; corners within tolerance share an id.
+std::vector<std::uint32_t> weld(const GeometrySoA & geometry, float tolerance, std::uint32_t & vertexCount)
+{
+    const std::size_t count = geometry.size();
+
+    // Cells as wide as the tolerance: any match lies in one of the 27 cells around a point.
+    const float inverseCell = 1.0f / tolerance;
+    const float toleranceSquared = tolerance * tolerance;
+
+    auto cellOf = [inverseCell](float value)
+    {
+        return static_cast<std::int64_t>(std::floor(value * inverseCell));
+    };
+
+    auto key = [](std::int64_t x, std::int64_t y, std::int64_t z)
+    {
+        // 21 bits per axis is plenty for a tolerance of 1e-5 of the diagonal.
+        constexpr std::uint64_t kMask = (1ULL << 21U) - 1U;
+        return (static_cast<std::uint64_t>(x) & kMask)
+             | (static_cast<std::uint64_t>(y) & kMask) << 21U
+             | (static_cast<std::uint64_t>(z) & kMask) << 42U;
+    };
+
+    // Per cell, the latest vertex added; older ones chain through next.
+    std::unordered_map<std::uint64_t, std::uint32_t> cellHead;
+    cellHead.reserve(count);
+
+    std::vector<std::uint32_t> next;
+    std::vector<std::uint32_t> representative;  // corner holding each vertex's position
+    std::vector<std::uint32_t> ids(count);
+
+    constexpr std::uint32_t kNone = ~0U;
+
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        const float x = geometry.px[i];
+        const float y = geometry.py[i];
+        const float z = geometry.pz[i];
+        const std::int64_t cx = cellOf(x);
+        const std::int64_t cy = cellOf(y);
+        const std::int64_t cz = cellOf(z);
+
+        std::uint32_t match = kNone;
+
+        for (std::int64_t dz = -1; dz <= 1 && match == kNone; ++dz)
+        {
+            for (std::int64_t dy = -1; dy <= 1 && match == kNone; ++dy)
+            {
+                for (std::int64_t dx = -1; dx <= 1 && match == kNone; ++dx)
+                {
+                    auto it = cellHead.find(key(cx + dx, cy + dy, cz + dz));
+
+                    for (std::uint32_t v = it == cellHead.end() ? kNone : it->second; v != kNone; v = next[v])
+                    {
+                        const std::uint32_t r = representative[v];
+                        const float ex = geometry.px[r] - x;
+                        const float ey = geometry.py[r] - y;
+                        const float ez = geometry.pz[r] - z;
+
+                        if (ex * ex + ey * ey + ez * ez <= toleranceSquared)
+                        {
+                            match = v;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (match == kNone)
+        {
+            match = static_cast<std::uint32_t>(representative.size());
+            representative.push_back(static_cast<std::uint32_t>(i));
+
+            auto [it, inserted] = cellHead.try_emplace(key(cx, cy, cz), match);
+            next.push_back(inserted ? kNone : it->second);
+            it->second = match;
+        }
+
+        ids[i] = match;
+    }
+
+    vertexCount = static_cast<std::uint32_t>(representative.size());
+
+    return ids;
+}
+
+}  // namespace
+
+
+void NormalGenerator::generate(GeometrySoA & geometry, const Options & options)
+{
+    const std::size_t triangleCount = geometry.size() / 3;
+    const std::size_t count = triangleCount * 3;
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    GeometrySoA::Bounds bounds = geometry.bounds();
+    float diagonal = glm::length(bounds.max - bounds.min);
+    float tolerance = std::max(options.weldTolerance * diagonal, 1e-12f);
+
+    std::uint32_t vertexCount = 0;
+    std::vector<std::uint32_t> ids = weld(geometry, tolerance, vertexCount);
+
+    // Unit face normals, face areas and corner angles. Faces with two corners welded
+    // together (e.g., slivers at a sphere pole) count as degenerate and get none.
+    std::vector<glm::vec3> faceNormal(triangleCount, glm::vec3(0.0f));
+    std::vector<float> faceArea(triangleCount, 0.0f);
+    std::vector<float> cornerAngle(count, 0.0f);
+
+    auto position = [&geometry](std::size_t i)
+    {
+        return glm::vec3(geometry.px[i], geometry.py[i], geometry.pz[i]);
+    };
+
+    parallelFor(0, triangleCount, [&](std::size_t t)
+    {
+        if (ids[3 * t] == ids[3 * t + 1] || ids[3 * t + 1] == ids[3 * t + 2] || ids[3 * t + 2] == ids[3 * t])
+        {
+            return;
+        }
+
+        const glm::vec3 p[3] {position(3 * t), position(3 * t + 1), position(3 * t + 2)};
+
+        glm::vec3 cross = glm::cross(p[1] - p[0], p[2] - p[0]);
+        float length = glm::length(cross);
+
+        faceNormal[t] = 0.0f < length ? cross / length : glm::vec3(0.0f);
+        faceArea[t] = 0.5f * length;
+
+        for (int k = 0; k != 3; ++k)
+        {
+            glm::vec3 e1 = p[(k + 1) % 3] - p[k];
+            glm::vec3 e2 = p[(k + 2) % 3] - p[k];
+            cornerAngle[3 * t + k] = std::atan2(glm::length(glm::cross(e1, e2)), glm::dot(e1, e2));
+        }
+    }, kGrain, options.threads);
+
+    // List the corners of each vertex (counting sort).
+    std::vector<std::uint32_t> firstCorner(vertexCount + 1, 0U);
+
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        ++firstCorner[ids[i] + 1];
+    }
+
+    for (std::uint32_t v = 0; v != vertexCount; ++v)
+    {
+        firstCorner[v + 1] += firstCorner[v];
+    }
+
+    std::vector<std::uint32_t> corners(count);
+    std::vector<std::uint32_t> fill(firstCorner.begin(), firstCorner.end() - 1);
+
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        corners[fill[ids[i]]++] = static_cast<std::uint32_t>(i);
+    }
+
+    // Each corner averages the faces around its vertex that lie within the crease angle of its own.
+    const float cosCrease = std::cos(options.creaseAngle);
+    const bool byAngle = options.weighting == Weighting::kAngle;
+
+    parallelFor(0, count, [&](std::size_t i)
+    {
+        const glm::vec3 & own = faceNormal[i / 3];
+        const std::uint32_t v = ids[i];
+        glm::vec3 sum {0.0f};
+
+        // Degenerate faces have no normal of their own and take all their neighbours'.
+        const float threshold = own == glm::vec3(0.0f) ? -2.0f : cosCrease;
+
+        for (std::uint32_t c = firstCorner[v]; c != firstCorner[v + 1]; ++c)
+        {
+            const std::uint32_t j = corners[c];
+            const glm::vec3 & other = faceNormal[j / 3];
+
+            if (threshold <= glm::dot(own, other))
+            {
+                sum += (byAngle ? cornerAngle[j] : faceArea[j / 3]) * other;
+            }
+        }
+
+        float length = glm::length(sum);
+        glm::vec3 normal = 0.0f < length ? sum / length : own;
+
+        geometry.nx[i] = normal.x;
+        geometry.ny[i] = normal.y;
+        geometry.nz[i] = normal.z;
+    }, kGrain, options.threads);
+}
+
+
+void NormalGenerator::generate(std::vector<Mesh::Vertex> & triangles, const Options & options)
+{
+    GeometrySoA geometry {triangles};
+    generate(geometry, options);
+
+    for (std::size_t i = 0; i != triangles.size(); ++i)
+    {
+        triangles[i].normal = {geometry.nx[i], geometry.ny[i], geometry.nz[i]};
+    }
+}
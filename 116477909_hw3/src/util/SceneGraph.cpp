@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <utility>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define SCENEGRAPH_SSE 1
+#endif
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "util/SceneGraph.h"
+
+
+namespace
+{
+
+// out = a * b for column-major 4x4 matrices; out must not alias a or b.
+inline void multiply(const float * a, const float * b, float * out)
+{
+#ifdef SCENEGRAPH_SSE
+    const __m128 a0 = _mm_loadu_ps(a);
+    const __m128 a1 = _mm_loadu_ps(a + 4);
+    const __m128 a2 = _mm_loadu_ps(a + 8);
+    const __m128 a3 = _mm_loadu_ps(a + 12);
+
+    for (int column = 0; column != 4; ++column)
+    {
+        const float * pB = b + 4 * column;
+
+        __m128 sum = _mm_mul_ps(a0, _mm_set1_ps(pB[0]));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(pB[1])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(pB[2])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(pB[3])));
+
+        _mm_storeu_ps(out + 4 * column, sum);
+    }
+#else
+    for (int column = 0; column != 4; ++column)
+    {
+        for (int row = 0; row != 4; ++row)
+        {
+            out[4 * column + row] = a[row] * b[4 * column]
+                                  + a[4 + row] * b[4 * column + 1]
+                                  + a[8 + row] * b[4 * column + 2]
+                                  + a[12 + row] * b[4 * column + 3];
+        }
+    }
+#endif  // SCENEGRAPH_SSE
+}
+
+}  // namespace
+
+
+glm::mat4 SceneGraph::Transform::matrix() const
+{
+    glm::mat4 result = glm::mat4_cast(rotation);
+
+    result[0] *= scale.x;
+    result[1] *= scale.y;
+    result[2] *= scale.z;
+    result[3] = glm::vec4(translation, 1.0f);
+
+    return result;
+}
+
+
+SceneGraph::NodeId SceneGraph::create(NodeId parent, const Transform & local)
+{
+    const auto node = static_cast<NodeId>(indexOf.size());
+
+    // Last in the parent's subtree, which keeps the arrays depth-first.
+    std::uint32_t parentIndex = parent == kNone ? kNone : indexOf[parent];
+    std::uint32_t index = parent == kNone ? static_cast<std::uint32_t>(nodeAt.size())
+                                          : parentIndex + subtreeSize[parentIndex];
+
+    locals.insert(locals.begin() + index, local);
+    localMatrices.insert(localMatrices.begin() + index, local.matrix());
+    worlds.insert(worlds.begin() + index, glm::mat4(1.0f));
+    parentAt.insert(parentAt.begin() + index, parentIndex);
+    subtreeSize.insert(subtreeSize.begin() + index, 1U);
+    nodeAt.insert(nodeAt.begin() + index, node);
+    indexOf.push_back(index);
+
+    // Everything after the insertion point moved up by one.
+    for (std::size_t i = index + 1; i != nodeAt.size(); ++i)
+    {
+        indexOf[nodeAt[i]] = static_cast<std::uint32_t>(i);
+
+        if (parentAt[i] != kNone && index <= parentAt[i])
+        {
+            ++parentAt[i];
+        }
+    }
+
+    for (std::uint32_t ancestor = parentIndex; ancestor != kNone; ancestor = parentAt[ancestor])
+    {
+        ++subtreeSize[ancestor];
+    }
+
+    dirty.push_back(node);
+
+    return node;
+}
+
+
+void SceneGraph::setLocal(NodeId node, const Transform & local)
+{
+    std::uint32_t index = indexOf[node];
+
+    locals[index] = local;
+    localMatrices[index] = local.matrix();
+
+    dirty.push_back(node);
+}
+
+
+void SceneGraph::update()
+{
+    changedNodes.clear();
+
+    if (dirty.empty())
+    {
+        return;
+    }
+
+    // Subtrees are nested or disjoint: sorted by start, a range starting inside the previous one is covered by it.
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> ranges;
+    ranges.reserve(dirty.size());
+
+    for (NodeId node : dirty)
+    {
+        std::uint32_t index = indexOf[node];
+        ranges.emplace_back(index, index + subtreeSize[index]);
+    }
+
+    dirty.clear();
+    std::sort(ranges.begin(), ranges.end());
+
+    std::uint32_t covered = 0;
+
+    for (const auto & [begin, end] : ranges)
+    {
+        if (begin < covered)
+        {
+            continue;
+        }
+
+        for (std::uint32_t i = begin; i != end; ++i)
+        {
+            if (parentAt[i] == kNone)
+            {
+                worlds[i] = localMatrices[i];
+            }
+            else
+            {
+                multiply(glm::value_ptr(worlds[parentAt[i]]), glm::value_ptr(localMatrices[i]), glm::value_ptr(worlds[i]));
+            }
+
+            changedNodes.push_back(nodeAt[i]);
+        }
+
+        covered = end;
+    }
+}
+
+
+SceneGraph::NodeId SceneGraph::parent(NodeId node) const
+{
+    std::uint32_t index = parentAt[indexOf[node]];
+    return index == kNone ? kNone : nodeAt[index];
+}
@@ -0,0 +1,131 @@
+#include <iostream>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif  // __linux__
+
+#include "util/Shader.h"
+#include "util/ShaderWatcher.h"
+
+
+ShaderWatcher::ShaderWatcher(std::string directory) : directory(std::move(directory))
+{
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_CLOEXEC);
+
+    if (inotifyFd < 0)
+    {
+        std::cerr << "shader hot-reload disabled: inotify_init1 failed\n";
+        return;
+    }
+
+    // Editors either rewrite the file in place (IN_CLOSE_WRITE) or write a temporary and rename it (IN_MOVED_TO).
+    if (inotify_add_watch(inotifyFd, this->directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0 || pipe(wakeFd) != 0)
+    {
+        std::cerr << "shader hot-reload disabled: cannot watch " << this->directory << '\n';
+        close(inotifyFd);
+        inotifyFd = -1;
+        return;
+    }
+
+    running = true;
+    worker = std::thread(&ShaderWatcher::watchLoop, this);
+#endif  // __linux__
+}
+
+
+ShaderWatcher::~ShaderWatcher() noexcept
+{
+#ifdef __linux__
+    if (running.exchange(false))
+    {
+        // Wake the poll() in watchLoop.
+        char byte = 0;
+        [[maybe_unused]] ssize_t written = write(wakeFd[1], &byte, 1);
+        worker.join();
+    }
+
+    for (int fd : {inotifyFd, wakeFd[0], wakeFd[1]})
+    {
+        if (0 <= fd)
+        {
+            close(fd);
+        }
+    }
+#endif  // __linux__
+}
+
+
+void ShaderWatcher::watch(Shader * pShader)
+{
+    shaders.emplace_back(pShader);
+}
+
+
+bool ShaderWatcher::update()
+{
+    std::unordered_set<std::string> changed;
+
+    {
+        std::lock_guard lock(changedMutex);
+        changed.swap(changedFiles);
+    }
+
+    bool swapped = false;
+
+    for (Shader * pShader : shaders)
+    {
+        for (const Shader::Stage & stage : pShader->getStages())
+        {
+            if (changed.count(stage.path))
+            {
+                pShader->reload();
+                break;
+            }
+        }
+
+        if (pShader->finishReload())
+        {
+            std::cout << "reloaded shader " << pShader->getStages().front().path << '\n';
+            swapped = true;
+        }
+    }
+
+    return swapped;
+}
+
+
+void ShaderWatcher::watchLoop()
+{
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+
+    pollfd fds[2] {{inotifyFd, POLLIN, 0}, {wakeFd[0], POLLIN, 0}};
+
+    while (running)
+    {
+        if (poll(fds, 2, -1) <= 0 || (fds[1].revents & POLLIN))
+        {
+            continue;
+        }
+
+        ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+
+        std::lock_guard lock(changedMutex);
+
+        for (ssize_t offset = 0; offset < length; )
+        {
+            const auto * event = reinterpret_cast<const inotify_event *>(buffer + offset);
+
+            if (event->len)
+            {
+                changedFiles.emplace(directory + '/' + event->name);
+            }
+
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+    }
+#endif  // __linux__
+}
@@ -0,0 +1,48 @@
+#include "util/NormalGenerator.h"
+#include "util/Subdivision.h"
+
+
+std::vector<Mesh::Vertex> Subdivision::subdivide(const std::vector<Mesh::Vertex> & triangles, glm::vec3 scale)
+{
+    std::vector<Mesh::Vertex> finer;
+    finer.reserve(triangles.size() * 4);
+
+    for (std::size_t i = 0; i + 2 < triangles.size(); i += 3)
+    {
+        glm::vec3 v0 = triangles[i + 0].position;
+        glm::vec3 v1 = triangles[i + 1].position;
+        glm::vec3 v2 = triangles[i + 2].position;
+
+        // Find midpoints of the edges of the triangle
+        glm::vec3 mid01 = scale * glm::normalize((v0 + v1) * 0.5f);
+        glm::vec3 mid12 = scale * glm::normalize((v1 + v2) * 0.5f);
+        glm::vec3 mid20 = scale * glm::normalize((v2 + v0) * 0.5f);
+
+        glm::vec3 color = triangles[i + 0].color;
+
+        // Each corner child goes corner, next midpoint, previous midpoint, like v0 -> v1 -> v2;
+        // normals follow below
+        glm::vec3 none {0.0f};
+
+        finer.push_back(Mesh::Vertex {v0, none, color});
+        finer.push_back(Mesh::Vertex {mid01, none, color});
+        finer.push_back(Mesh::Vertex {mid20, none, color});
+
+        finer.push_back(Mesh::Vertex {v1, none, color});
+        finer.push_back(Mesh::Vertex {mid12, none, color});
+        finer.push_back(Mesh::Vertex {mid01, none, color});
+
+        finer.push_back(Mesh::Vertex {v2, none, color});
+        finer.push_back(Mesh::Vertex {mid20, none, color});
+        finer.push_back(Mesh::Vertex {mid12, none, color});
+
+        finer.push_back(Mesh::Vertex {mid01, none, color});
+        finer.push_back(Mesh::Vertex {mid12, none, color});
+        finer.push_back(Mesh::Vertex {mid20, none, color});
+    }
+
+    // Smooth normals from the new surface itself, not from its direction from the origin
+    NormalGenerator::generate(finer, NormalGenerator::Options {});
+
+    return finer;
+}
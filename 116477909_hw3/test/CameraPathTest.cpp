@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "util/CameraPath.h"
+
+
+namespace
+{
+
+int check(bool passed, const char * what)
+{
+    if (!passed)
+    {
+        std::cerr << "CameraPathTest: " << what << '\n';
+    }
+
+    return passed ? 0 : 1;
+}
+
+
+// Angle between the orientations a and b, either sign of either quaternion.
+float angleBetween(const glm::quat & a, const glm::quat & b)
+{
+    float cosine = std::min(std::abs(glm::dot(glm::normalize(a), glm::normalize(b))), 1.0f);
+    return 2.0f * std::acos(cosine);
+}
+
+
+CameraPath::Pose pose(glm::vec3 position, float angle, glm::vec3 axis)
+{
+    return {position, glm::angleAxis(angle, glm::normalize(axis))};
+}
+
+
+// Keys spaced very unevenly along a curve, so equal spline parameter steps are far from
+// equal distances.
+std::vector<CameraPath::Pose> curve()
+{
+    return {
+        pose({0.0f, 0.0f, 0.0f}, 0.0f, {0.0f, 1.0f, 0.0f}),
+        pose({0.5f, 0.0f, 0.0f}, 0.6f, {0.0f, 1.0f, 0.0f}),
+        pose({6.0f, 1.0f, -2.0f}, 1.4f, {0.2f, 1.0f, 0.0f}),
+        pose({7.0f, 4.0f, -3.0f}, 2.9f, {0.0f, 1.0f, 0.3f}),
+        pose({2.0f, 5.0f, -9.0f}, 2.2f, {1.0f, 0.0f, 0.0f}),
+    };
+}
+
+
+int straightLine()
+{
+    CameraPath path({pose({0.0f, 0.0f, 0.0f}, 0.0f, {0.0f, 1.0f, 0.0f}),
+                     pose({1.0f, 0.0f, 0.0f}, 0.0f, {0.0f, 1.0f, 0.0f}),
+                     pose({10.0f, 0.0f, 0.0f}, 0.0f, {0.0f, 1.0f, 0.0f})});
+
+    float worst = 0.0f;
+
+    for (int i = 0; i <= 100; ++i)
+    {
+        float fraction = static_cast<float>(i) / 100.0f;
+        worst = std::max(worst, std::abs(path.atFraction(fraction).position.x - 10.0f * fraction));
+    }
+
+    return check(std::abs(path.length() - 10.0f) < 1e-3f, "length of a straight path")
+         + check(worst < 1e-2f, "a straight path is not traversed at constant speed");
+}
+
+
+int constantSpeed()
+{
+    CameraPath path(curve());
+
+    // Chords between poses at even fractions of the length agree to a few percent; the
+    // parameter table is interpolated linearly between its samples.
+    constexpr int kSteps {400};
+    const float step = path.length() / kSteps;
+
+    float shortest = path.length();
+    float longest = 0.0f;
+    glm::vec3 previous = path.atFraction(0.0f).position;
+
+    for (int i = 1; i <= kSteps; ++i)
+    {
+        glm::vec3 next = path.atFraction(static_cast<float>(i) / kSteps).position;
+        float chord = glm::length(next - previous);
+        shortest = std::min(shortest, chord);
+        longest = std::max(longest, chord);
+        previous = next;
+    }
+
+    std::vector<CameraPath::Pose> keys = curve();
+
+    return check(0.95f * step < shortest && longest < 1.05f * step, "uneven speed along the arc length")
+         + check(glm::length(path.atFraction(0.0f).position - keys.front().position) < 1e-4f, "start off the first key")
+         + check(glm::length(path.atFraction(1.0f).position - keys.back().position) < 1e-3f, "end off the last key")
+         + check(glm::length(path.atSegmentFraction(2, 0.0f).position - keys[2].position) < 1e-2f,
+                 "segment start off its key");
+}
+
+
+int squad()
+{
+    std::vector<CameraPath::Pose> keys = curve();
+    CameraPath path(keys);
+
+    int failures = 0;
+
+    for (std::size_t segment = 0; segment != path.segmentCount(); ++segment)
+    {
+        failures += check(angleBetween(path.at(segment, 0.0f).rotation, keys[segment].rotation) < 1e-3f,
+                          "squad does not start at its key")
+                  + check(angleBetween(path.at(segment, 1.0f).rotation, keys[segment + 1].rotation) < 1e-3f,
+                          "squad does not end at its key");
+
+        for (int i = 0; i <= 20; ++i)
+        {
+            float length = glm::length(path.at(segment, static_cast<float>(i) / 20.0f).rotation);
+            failures += check(std::abs(length - 1.0f) < 1e-4f, "squad left the unit quaternions");
+        }
+    }
+
+    // Shoemake's control rotations keep the angular velocity continuous across inner keys,
+    // so equal parameter steps before and after a key turn by about the same angle.
+    const float h = 1e-2f;
+
+    for (std::size_t key = 1; key + 1 < keys.size(); ++key)
+    {
+        float before = angleBetween(path.at(key - 1, 1.0f - h).rotation, keys[key].rotation);
+        float after = angleBetween(keys[key].rotation, path.at(key, h).rotation);
+
+        failures += check(std::abs(before - after) < 0.1f * std::max(before, after) + 1e-4f,
+                          "angular velocity jumps at a key");
+    }
+
+    CameraPath single({keys[3]});
+
+    return failures
+         + check(single.segmentCount() == 0 && single.length() == 0.0f, "a single key has length")
+         + check(angleBetween(single.atFraction(0.5f).rotation, keys[3].rotation) < 1e-6f,
+                 "a single key is not the only pose");
+}
+
+}  // namespace
+
+
+int main()
+{
+    int failures = straightLine()
+                 + constantSpeed()
+                 + squad();
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
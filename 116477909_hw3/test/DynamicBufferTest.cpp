@@ -0,0 +1,109 @@
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "util/DynamicBuffer.h"
+
+
+namespace
+{
+
+using Ranges = std::vector<std::pair<std::size_t, std::size_t>>;
+
+// What the stand-ins for the GL functions below saw; no context is needed.
+Ranges written;
+
+
+void APIENTRY bindBuffer(GLenum, GLuint)
+{
+
+}
+
+
+void APIENTRY bufferSubData(GLenum, GLintptr offset, GLsizeiptr size, const void *)
+{
+    written.emplace_back(static_cast<std::size_t>(offset), static_cast<std::size_t>(offset + size));
+}
+
+
+int check(bool passed, const char * what)
+{
+    if (!passed)
+    {
+        std::cerr << "DynamicBufferTest: " << what << '\n';
+    }
+
+    return passed ? 0 : 1;
+}
+
+
+// The ranges a static buffer of 1000 bytes writes after marking each of marks dirty.
+Ranges flushed(const Ranges & marks)
+{
+    static const std::vector<unsigned char> contents(1000);
+
+    DynamicBuffer buffer(GL_ARRAY_BUFFER, DynamicBuffer::Usage::kStatic);
+    buffer.attach(1U, contents.size());
+
+    for (const auto & [offset, count] : marks)
+    {
+        buffer.markDirty(offset, count);
+    }
+
+    written.clear();
+    buffer.flush(contents.data());
+
+    return written;
+}
+
+}  // namespace
+
+
+int main()
+{
+    glad_glBindBuffer = bindBuffer;
+    glad_glBufferSubData = bufferSubData;
+
+    // 17 disjoint ranges, one more than kMaxRanges.
+    Ranges scattered;
+
+    for (std::size_t i = 0; i != 17; ++i)
+    {
+        scattered.emplace_back(10 + 50 * i, 5);
+    }
+
+    bool outOfRange = false;
+
+    try
+    {
+        DynamicBuffer buffer(GL_ARRAY_BUFFER, DynamicBuffer::Usage::kStatic);
+        buffer.attach(1U, 100);
+        buffer.markDirty(90, 11);
+    }
+    catch (const std::out_of_range &)
+    {
+        outOfRange = true;
+    }
+
+    int failures = check(flushed({}).empty(), "a clean buffer wrote")
+                 + check(flushed({{10, 0}}).empty(), "an empty range wrote")
+                 + check(flushed({{300, 10}, {100, 10}}) == Ranges {{100, 110}, {300, 310}}, "ranges not sorted")
+                 + check(flushed({{100, 10}, {105, 20}}) == Ranges {{100, 125}}, "overlapping ranges not merged")
+                 + check(flushed({{100, 10}, {110, 10}}) == Ranges {{100, 120}}, "touching ranges not merged")
+                 + check(flushed({{100, 10}, {111, 10}}) == Ranges {{100, 110}, {111, 121}}, "disjoint ranges merged")
+                 + check(flushed({{100, 10}, {200, 10}, {300, 10}, {50, 300}}) == Ranges {{50, 350}},
+                         "a range spanning several not merged with them")
+                 + check(flushed({{100, 10}, {200, 10}, {300, 10}, {205, 100}}) == Ranges {{100, 110}, {200, 310}},
+                         "a range bridging two not merged with both")
+                 + check(flushed(Ranges(scattered.begin(), scattered.end() - 1)).size() == 16,
+                         "kMaxRanges ranges merged")
+                 + check(flushed(scattered) == Ranges {{10, 815}}, "more than kMaxRanges ranges not merged into one")
+                 + check(flushed({{990, 10}}) == Ranges {{990, 1000}}, "a range at the end")
+                 + check(outOfRange, "a range past the end of the contents accepted");
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,235 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "util/JobSystem.h"
+
+
+namespace
+{
+
+std::atomic<long> postedSum {0};
+
+
+void addPosted(const void * pArguments)
+{
+    postedSum.fetch_add(*static_cast<const int *>(pArguments));
+}
+
+
+int check(bool passed, const char * what)
+{
+    if (!passed)
+    {
+        std::cerr << "JobSystemTest: " << what << '\n';
+    }
+
+    return passed ? 0 : 1;
+}
+
+
+// Splits into two child jobs down to depth 0, so workers push to and pop from their own
+// deques while the others steal from them.
+void spawn(JobSystem & jobs, int depth, std::atomic<int> & leaves, JobSystem::Counter & counter)
+{
+    if (depth == 0)
+    {
+        leaves.fetch_add(1);
+        return;
+    }
+
+    for (int child = 0; child != 2; ++child)
+    {
+        jobs.submit([&jobs, depth, &leaves, &counter] { spawn(jobs, depth - 1, leaves, counter); }, &counter);
+    }
+}
+
+
+int deques(JobSystem & jobs)
+{
+    // Far more than kInitialCapacity jobs on the creating thread's deque at once, so it grows
+    // while the workers steal from it.
+    constexpr int kJobs {10000};
+    std::atomic<int> ran {0};
+    JobSystem::Counter counter;
+
+    for (int i = 0; i != kJobs; ++i)
+    {
+        jobs.submit([&ran] { ran.fetch_add(1); }, &counter);
+    }
+
+    jobs.wait(counter);
+
+    std::atomic<int> leaves {0};
+    JobSystem::Counter tree;
+    jobs.submit([&jobs, &leaves, &tree] { spawn(jobs, 12, leaves, tree); }, &tree);
+    jobs.wait(tree);
+
+    return check(ran.load() == kJobs, "submitted jobs lost or run twice")
+         + check(leaves.load() == 1 << 12, "jobs submitted by jobs lost or run twice");
+}
+
+
+int parallelFor(JobSystem & jobs)
+{
+    constexpr std::size_t kCount {100000};
+    std::vector<std::atomic<int>> visits(kCount);
+
+    jobs.parallelFor(0, kCount, [&visits](std::size_t i) { visits[i].fetch_add(1); }, 64);
+
+    int wrong = 0;
+
+    for (const std::atomic<int> & count : visits)
+    {
+        wrong += count.load() != 1 ? 1 : 0;
+    }
+
+    bool rethrown = false;
+
+    try
+    {
+        jobs.parallelFor(0, kCount, [](std::size_t i)
+        {
+            if (i == 4321)
+            {
+                throw std::runtime_error("body");
+            }
+        }, 16);
+    }
+    catch (const std::runtime_error &)
+    {
+        rethrown = true;
+    }
+
+    return check(wrong == 0, "parallelFor missed an index or visited it twice")
+         + check(rethrown, "parallelFor swallowed the exception of its body");
+}
+
+
+int after(JobSystem & jobs)
+{
+    std::atomic<int> finished {0};
+    std::atomic<int> seenByContinuation {-1};
+    JobSystem::Counter first;
+    JobSystem::Counter second;
+
+    for (int i = 0; i != 8; ++i)
+    {
+        jobs.submit([&finished]
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            finished.fetch_add(1);
+        }, &first);
+    }
+
+    jobs.after(first, [&finished, &seenByContinuation] { seenByContinuation = finished.load(); }, &second);
+    jobs.wait(second);
+
+    // A dependency that is already done queues the job at once.
+    std::atomic<bool> ranAtOnce {false};
+    JobSystem::Counter third;
+    jobs.after(first, [&ranAtOnce] { ranAtOnce = true; }, &third);
+    jobs.wait(third);
+
+    return check(seenByContinuation.load() == 8, "after() ran before its dependency was done")
+         + check(ranAtOnce.load(), "after() on a done counter never ran");
+}
+
+
+int post(JobSystem & jobs)
+{
+    constexpr int kThreads {4};
+    constexpr int kPerThread {1000};
+
+    std::vector<std::thread> producers;
+
+    for (int t = 0; t != kThreads; ++t)
+    {
+        producers.emplace_back([&jobs]
+        {
+            for (int i = 1; i <= kPerThread; ++i)
+            {
+                // A full ring rejects the job; the caller decides whether to try again.
+                while (!jobs.post(addPosted, &i, sizeof(i)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (std::thread & producer : producers)
+    {
+        producer.join();
+    }
+
+    const long expected = static_cast<long>(kThreads) * kPerThread * (kPerThread + 1) / 2;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+    while (postedSum.load() != expected && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    bool rejected = false;
+
+    try
+    {
+        unsigned char tooLarge[JobSystem::kPostBytes + 1] {};
+        jobs.post(addPosted, tooLarge, sizeof(tooLarge));
+    }
+    catch (const std::invalid_argument &)
+    {
+        rejected = true;
+    }
+
+    return check(postedSum.load() == expected, "posted jobs lost or run twice")
+         + check(rejected, "post() took more than kPostBytes of arguments");
+}
+
+
+int shutdown()
+{
+    JobSystem jobs(2);
+    std::atomic<int> ran {0};
+
+    for (int i = 0; i != 1000; ++i)
+    {
+        jobs.submit([&ran] { ran.fetch_add(1); });
+    }
+
+    jobs.shutdown();
+    int queuedRan = ran.load();
+
+    // Later submissions run inline, before submit() returns.
+    jobs.submit([&ran] { ran.fetch_add(1); });
+    int inlineRan = ran.load();
+
+    jobs.shutdown();
+
+    int value = 1;
+
+    return check(queuedRan == 1000, "shutdown() returned before the queued jobs ran")
+         + check(inlineRan == 1001, "a job submitted after shutdown() did not run inline")
+         + check(!jobs.post(addPosted, &value, sizeof(value)), "post() queued a job after shutdown()");
+}
+
+}  // namespace
+
+
+int main()
+{
+    JobSystem jobs(3);
+
+    int failures = deques(jobs)
+                 + parallelFor(jobs)
+                 + after(jobs)
+                 + post(jobs)
+                 + shutdown();
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
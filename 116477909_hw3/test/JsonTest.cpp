@@ -0,0 +1,148 @@
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "util/Json.h"
+
+
+namespace
+{
+
+int check(bool passed, const std::string & what)
+{
+    if (!passed)
+    {
+        std::cerr << "JsonTest: " << what << '\n';
+    }
+
+    return passed ? 0 : 1;
+}
+
+
+// Message of the std::runtime_error that parsing text throws; empty if it parses.
+std::string parseError(const std::string & text)
+{
+    try
+    {
+        (void) Json::parse(text);
+    }
+    catch (const std::runtime_error & error)
+    {
+        return error.what();
+    }
+
+    return {};
+}
+
+
+int rejects(const std::string & text, const std::string & expected)
+{
+    std::string message = parseError(text);
+
+    return check(message.find(expected) != std::string::npos,
+                 "parsing " + text + " gave \"" + message + "\", not \"" + expected + "\"");
+}
+
+
+int values()
+{
+    Json document = Json::parse(R"({
+        "name": "scene",
+        "count": -12,
+        "scale": 2.5e-1,
+        "flags": [true, false, null],
+        "nested": {"empty": [], "object": {}}
+    })");
+
+    const Json & flags = document["flags"];
+    const Json & nested = document["nested"];
+
+    return check(document.isObject() && document.members().size() == 5, "top-level object")
+         + check(document.members().front().first == "name", "members out of file order")
+         + check(document["name"].asString() == "scene", "string member")
+         + check(document["count"].asInt() == -12, "integer member")
+         + check(document["scale"].asFloat() == 0.25f, "number with exponent")
+         + check(flags.size() == 3 && flags[0].asBool() && !flags[1].asBool() && flags[2].isNull(), "array")
+         + check(nested["empty"].isArray() && nested["empty"].size() == 0, "empty array")
+         + check(nested["object"].isObject() && nested["object"].members().empty(), "empty object")
+         + check(document.get("missing", 7) == 7 && document.get("count", 0) == -12, "get() fallback")
+         + check(document.find("missing") == nullptr, "find() of a missing member")
+         + check(flags[1].path() == "flags[1]" && nested["object"].path() == "nested.object", "paths");
+}
+
+
+int strings()
+{
+    Json escapes = Json::parse(R"(["a\"b\\c\/d\n\t", "é", "€", "😀"])");
+
+    return check(escapes[0].asString() == "a\"b\\c/d\n\t", "simple escapes")
+         + check(escapes[1].asString() == "\xC3\xA9", "two-byte UTF-8")
+         + check(escapes[2].asString() == "\xE2\x82\xAC", "three-byte UTF-8")
+         + check(escapes[3].asString() == "\xF0\x9F\x98\x80", "surrogate pair")
+         + rejects(R"("\uD83D")", "a low surrogate escape")
+         + rejects(R"("\uD83DA")", "a low surrogate")
+         + rejects(R"("\uDC00")", "a high surrogate before a low surrogate")
+         + rejects("\"tab\there\"", "no control characters in strings")
+         + rejects(R"("\x")", "a valid escape sequence");
+}
+
+
+int errors()
+{
+    // Depth counts the arrays and objects around a value.
+    std::string deepest(Json::kMaxDepth, '[');
+    deepest += std::string(Json::kMaxDepth, ']');
+    std::string tooDeep = '[' + deepest + ']';
+
+    int failures = check(parseError(deepest).empty(), "kMaxDepth nested arrays rejected")
+                 + rejects(tooDeep, "at most 256 nested arrays and objects");
+
+    bool mismatch = false;
+
+    try
+    {
+        (void) Json::parse(R"({"a": {"b": "text"}})")["a"]["b"].asInt();
+    }
+    catch (const std::runtime_error & error)
+    {
+        mismatch = std::string(error.what()) == "a.b: expected a number";
+    }
+
+    bool outOfRange = false;
+
+    try
+    {
+        (void) Json::parse("[4294967296]")[0].asInt();
+    }
+    catch (const std::runtime_error &)
+    {
+        outOfRange = true;
+    }
+
+    return failures
+         + rejects("{\n  \"a\": 1,\n  \"b\" 2\n}", "line 3, column 7")
+         + rejects("[1, 2,]", "line 1, column 7")
+         + rejects("01", "line 1, column 2")
+         + rejects("1.", "digits after '.'")
+         + rejects("1e", "exponent digits")
+         + rejects("+1", "a value")
+         + rejects("1e999", "a number within the range of a double")
+         + rejects("[-1e400]", "line 1, column 2")
+         + rejects("[1] 2", "line 1, column 5")
+         + check(parseError("1e-999").empty(), "an underflowing number rejected")
+         + check(mismatch, "a type mismatch did not name the member's path")
+         + check(outOfRange, "asInt() took a number outside the range of int");
+}
+
+}  // namespace
+
+
+int main()
+{
+    int failures = values()
+                 + strings()
+                 + errors();
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
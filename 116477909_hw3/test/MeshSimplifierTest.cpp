@@ -0,0 +1,232 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "util/MeshSimplifier.h"
+
+
+namespace
+{
+
+const glm::vec3 kColor {1.0f};
+
+
+int check(bool passed, const char * what)
+{
+    if (!passed)
+    {
+        std::cerr << "MeshSimplifierTest: " << what << '\n';
+    }
+
+    return passed ? 0 : 1;
+}
+
+
+glm::vec3 faceNormal(const std::vector<Mesh::Vertex> & triangles, std::size_t first)
+{
+    glm::vec3 a = triangles[first + 0].position;
+    glm::vec3 b = triangles[first + 1].position;
+    glm::vec3 c = triangles[first + 2].position;
+
+    return glm::cross(b - a, c - a);
+}
+
+
+// Unit square in the xy plane, cells by cells, two flat shaded triangles facing +z per cell.
+std::vector<Mesh::Vertex> grid(int cells)
+{
+    const glm::vec3 up {0.0f, 0.0f, 1.0f};
+    std::vector<Mesh::Vertex> triangles;
+
+    auto corner = [cells](int x, int y)
+    {
+        return glm::vec3(static_cast<float>(x) / cells, static_cast<float>(y) / cells, 0.0f);
+    };
+
+    for (int y = 0; y != cells; ++y)
+    {
+        for (int x = 0; x != cells; ++x)
+        {
+            for (glm::vec3 position : {corner(x, y), corner(x + 1, y), corner(x + 1, y + 1),
+                                       corner(x, y), corner(x + 1, y + 1), corner(x, y + 1)})
+            {
+                triangles.emplace_back(position, up, kColor);
+            }
+        }
+    }
+
+    return triangles;
+}
+
+
+// Closed unit sphere of rings by 2 * rings quads, smooth shaded.
+std::vector<Mesh::Vertex> sphere(int rings)
+{
+    const float pi = 3.14159265f;
+    std::vector<Mesh::Vertex> triangles;
+
+    auto point = [rings, pi](int ring, int segment)
+    {
+        float theta = pi * static_cast<float>(ring) / rings;
+        float phi = pi * static_cast<float>(segment) / rings;
+        return glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+    };
+
+    auto add = [&triangles](glm::vec3 a, glm::vec3 b, glm::vec3 c)
+    {
+        for (glm::vec3 position : {a, b, c})
+        {
+            triangles.emplace_back(position, position, kColor);
+        }
+    };
+
+    for (int ring = 0; ring != rings; ++ring)
+    {
+        for (int segment = 0; segment != 2 * rings; ++segment)
+        {
+            glm::vec3 a = point(ring, segment);
+            glm::vec3 b = point(ring, segment + 1);
+            glm::vec3 c = point(ring + 1, segment + 1);
+            glm::vec3 d = point(ring + 1, segment);
+
+            // The poles would give degenerate triangles.
+            if (ring != 0)
+            {
+                add(a, b, c);
+            }
+
+            if (ring + 1 != rings)
+            {
+                add(a, c, d);
+            }
+        }
+    }
+
+    return triangles;
+}
+
+
+int plane()
+{
+    MeshSimplifier::Options options;
+    options.targetTriangles = 32;
+
+    LodMesh::Level level = MeshSimplifier::simplify(grid(32), options);
+    std::size_t triangles = level.vertices.size() / 3;
+
+    // A flat square collapses without error; the open boundary slides along itself, so the
+    // remaining triangles still cover the square exactly once, none flipped.
+    float area = 0.0f;
+    int flipped = 0;
+    int offPlane = 0;
+
+    for (std::size_t first = 0; first < level.vertices.size(); first += 3)
+    {
+        glm::vec3 normal = faceNormal(level.vertices, first);
+        area += 0.5f * normal.z;
+        flipped += normal.z <= 0.0f ? 1 : 0;
+
+        for (std::size_t corner = first; corner != first + 3; ++corner)
+        {
+            offPlane += level.vertices[corner].position.z != 0.0f ? 1 : 0;
+        }
+    }
+
+    return check(level.vertices.size() % 3 == 0, "not a triangle list")
+         + check(0 < triangles && triangles <= 32, "target triangle count missed")
+         + check(level.error < 1e-5f, "error on a flat mesh")
+         + check(std::abs(area - 1.0f) < 1e-4f, "area of the square changed")
+         + check(flipped == 0, "flipped triangles")
+         + check(offPlane == 0, "vertices left the plane");
+}
+
+
+int lockedBoundary()
+{
+    MeshSimplifier::Options options;
+    options.targetTriangles = 2;
+    options.lockBoundary = true;
+
+    LodMesh::Level level = MeshSimplifier::simplify(grid(8), options);
+
+    // All 32 boundary vertices stay, so at least 30 triangles do too.
+    int boundary = 0;
+
+    for (int i = 0; i != 8; ++i)
+    {
+        for (glm::vec3 expected : {glm::vec3(i / 8.0f, 0.0f, 0.0f), glm::vec3(1.0f, i / 8.0f, 0.0f),
+                                   glm::vec3(1.0f - i / 8.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f - i / 8.0f, 0.0f)})
+        {
+            for (const Mesh::Vertex & vertex : level.vertices)
+            {
+                if (glm::length(vertex.position - expected) < 1e-6f)
+                {
+                    ++boundary;
+                    break;
+                }
+            }
+        }
+    }
+
+    return check(boundary == 32, "a locked boundary vertex moved")
+         + check(30 <= level.vertices.size() / 3, "fewer triangles than a locked boundary allows");
+}
+
+
+int chain()
+{
+    std::vector<Mesh::Vertex> input = sphere(24);
+
+    MeshSimplifier::ChainOptions options;
+    options.levels = 4;
+    options.ratio = 0.5f;
+    options.minTriangles = 64;
+
+    std::vector<LodMesh::Level> levels = MeshSimplifier::buildLodChain(input, options);
+
+    if (levels.size() < 2)
+    {
+        return check(false, "no levels below the input");
+    }
+
+    int failures = check(levels.size() <= 5, "more levels than asked for")
+                 + check(levels.back().vertices.size() == input.size() && levels.back().error == 0.0f,
+                         "the finest level is not the input");
+
+    for (std::size_t i = 0; i + 1 != levels.size(); ++i)
+    {
+        const LodMesh::Level & coarse = levels[i];
+        const LodMesh::Level & fine = levels[i + 1];
+
+        failures += check(coarse.vertices.size() < fine.vertices.size(), "levels not coarsest first")
+                  + check(64 <= coarse.vertices.size() / 3, "a level below minTriangles")
+                  + check(fine.error <= coarse.error, "errors not decreasing toward the input");
+
+        // Every vertex stays within the level's error of the sphere.
+        float worst = 0.0f;
+
+        for (const Mesh::Vertex & vertex : coarse.vertices)
+        {
+            worst = std::max(worst, std::abs(glm::length(vertex.position) - 1.0f));
+        }
+
+        failures += check(worst <= coarse.error + 1e-4f, "a vertex further from the surface than the error");
+    }
+
+    return failures;
+}
+
+}  // namespace
+
+
+int main()
+{
+    int failures = plane()
+                 + lockedBoundary()
+                 + chain();
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
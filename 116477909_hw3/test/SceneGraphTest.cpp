@@ -0,0 +1,136 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "util/SceneGraph.h"
+
+
+namespace
+{
+
+using NodeId = SceneGraph::NodeId;
+
+
+int check(bool passed, const char * what)
+{
+    if (!passed)
+    {
+        std::cerr << "SceneGraphTest: " << what << '\n';
+    }
+
+    return passed ? 0 : 1;
+}
+
+
+SceneGraph::Transform moved(glm::vec3 translation, float angle = 0.0f)
+{
+    SceneGraph::Transform transform;
+    transform.translation = translation;
+    transform.rotation = glm::angleAxis(angle, glm::vec3(0.0f, 1.0f, 0.0f));
+    return transform;
+}
+
+
+bool near(const glm::mat4 & a, const glm::mat4 & b)
+{
+    for (int column = 0; column != 4; ++column)
+    {
+        for (int row = 0; row != 4; ++row)
+        {
+            if (1e-4f < std::abs(a[column][row] - b[column][row]))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+// World matrix by walking up the parents, independent of the flat arrays.
+glm::mat4 expectedWorld(const SceneGraph & graph, NodeId node)
+{
+    glm::mat4 world = graph.local(node).matrix();
+
+    for (NodeId parent = graph.parent(node); parent != SceneGraph::kNone; parent = graph.parent(parent))
+    {
+        world = graph.local(parent).matrix() * world;
+    }
+
+    return world;
+}
+
+
+int worldsMatch(const SceneGraph & graph, const char * what)
+{
+    int wrong = 0;
+
+    for (NodeId node = 0; node != graph.size(); ++node)
+    {
+        wrong += near(graph.world(node), expectedWorld(graph, node)) ? 0 : 1;
+    }
+
+    return check(wrong == 0, what);
+}
+
+}  // namespace
+
+
+int main()
+{
+    SceneGraph graph;
+
+    NodeId a = graph.create(SceneGraph::kNone, moved({1.0f, 0.0f, 0.0f}, 0.5f));
+    NodeId b = graph.create(a, moved({0.0f, 2.0f, 0.0f}, 1.0f));
+    NodeId c = graph.create(b, moved({0.0f, 0.0f, 3.0f}));
+    NodeId d = graph.create(SceneGraph::kNone, moved({-4.0f, 0.0f, 0.0f}));
+
+    // Inserted into the middle of the arrays: after c, before d.
+    NodeId e = graph.create(a, moved({5.0f, 0.0f, 0.0f}, -0.3f));
+    NodeId f = graph.create(b, moved({0.0f, 1.0f, 0.0f}));
+
+    graph.update();
+
+    int failures = check(graph.size() == 6, "size")
+                 + check(graph.parent(a) == SceneGraph::kNone && graph.parent(d) == SceneGraph::kNone, "roots")
+                 + check(graph.parent(b) == a && graph.parent(c) == b && graph.parent(e) == a && graph.parent(f) == b,
+                         "parents after insertion")
+                 + check(graph.changed() == std::vector<NodeId> {a, b, c, f, e, d},
+                         "created nodes not all updated in depth-first order")
+                 + worldsMatch(graph, "world matrices after insertion");
+
+    graph.update();
+    failures += check(graph.changed().empty(), "an update without changes recomputed nodes");
+
+    // b's subtree only; e and d stay as they are.
+    graph.setLocal(b, moved({0.0f, 2.0f, 1.0f}, 0.2f));
+    graph.update();
+
+    failures += check(graph.changed() == std::vector<NodeId> {b, c, f}, "dirty range of a subtree")
+              + worldsMatch(graph, "world matrices after moving a subtree");
+
+    // Nested dirty subtrees are computed once; disjoint ones each.
+    graph.setLocal(c, moved({0.0f, 0.0f, 4.0f}));
+    graph.setLocal(a, moved({1.0f, 1.0f, 0.0f}, 0.7f));
+    graph.setLocal(d, moved({-4.0f, 1.0f, 0.0f}));
+    graph.setLocal(c, moved({0.0f, 0.0f, 5.0f}));
+    graph.update();
+
+    failures += check(graph.changed() == std::vector<NodeId> {a, b, c, f, e, d}, "nested and disjoint dirty ranges")
+              + check(graph.local(c).translation.z == 5.0f, "the last setLocal() wins")
+              + worldsMatch(graph, "world matrices after moving nested subtrees");
+
+    // A node added under a leaf is dirty alone.
+    NodeId g = graph.create(c, moved({0.0f, 0.0f, 1.0f}));
+    graph.update();
+
+    failures += check(graph.changed() == std::vector<NodeId> {g}, "a new leaf dirtied more than itself")
+              + worldsMatch(graph, "world matrices after adding a leaf");
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
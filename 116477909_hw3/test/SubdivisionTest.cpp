@@ -0,0 +1,105 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "util/Subdivision.h"
+
+
+namespace
+{
+
+glm::vec3 faceNormal(const std::vector<Mesh::Vertex> & triangles, std::size_t first)
+{
+    glm::vec3 a = triangles[first + 0].position;
+    glm::vec3 b = triangles[first + 1].position;
+    glm::vec3 c = triangles[first + 2].position;
+
+    return glm::cross(b - a, c - a);
+}
+
+
+// Octahedron on the unit sphere; every other face is wound inward, so the check below
+// cannot pass by all children merely facing outward.
+std::vector<Mesh::Vertex> octahedron()
+{
+    const glm::vec3 x {1.0f, 0.0f, 0.0f};
+    const glm::vec3 y {0.0f, 1.0f, 0.0f};
+    const glm::vec3 z {0.0f, 0.0f, 1.0f};
+    const glm::vec3 none {0.0f};
+    const glm::vec3 color {1.0f};
+
+    std::vector<Mesh::Vertex> triangles;
+
+    for (float sx : {1.0f, -1.0f})
+    {
+        for (float sy : {1.0f, -1.0f})
+        {
+            for (float sz : {1.0f, -1.0f})
+            {
+                triangles.push_back(Mesh::Vertex {sx * x, none, color});
+                triangles.push_back(Mesh::Vertex {sy * y, none, color});
+                triangles.push_back(Mesh::Vertex {sz * z, none, color});
+            }
+        }
+    }
+
+    return triangles;
+}
+
+
+// Number of children of triangles whose normal points away from their parent's.
+int flippedChildren(const std::vector<Mesh::Vertex> & triangles, glm::vec3 scale)
+{
+    std::vector<Mesh::Vertex> finer = Subdivision::subdivide(triangles, scale);
+
+    if (finer.size() != triangles.size() * 4)
+    {
+        std::cerr << "SubdivisionTest: " << finer.size() << " vertices from " << triangles.size() << '\n';
+        return 1;
+    }
+
+    int flipped = 0;
+
+    for (std::size_t parent = 0; parent < triangles.size(); parent += 3)
+    {
+        glm::vec3 expected = faceNormal(triangles, parent);
+
+        for (std::size_t child = 0; child != 4; ++child)
+        {
+            if (glm::dot(faceNormal(finer, parent * 4 + child * 3), expected) <= 0.0f)
+            {
+                std::cerr << "SubdivisionTest: child " << child << " of triangle " << parent / 3
+                          << " is wound against its parent\n";
+                ++flipped;
+            }
+        }
+    }
+
+    return flipped;
+}
+
+}  // namespace
+
+
+int main()
+{
+    std::vector<Mesh::Vertex> coarse = octahedron();
+    std::vector<Mesh::Vertex> finer = Subdivision::subdivide(coarse);
+
+    // Ellipsoids subdivide with their corners already on the scaled sphere.
+    const glm::vec3 scale {2.0f, 1.0f, 0.5f};
+    std::vector<Mesh::Vertex> ellipsoid = coarse;
+
+    for (Mesh::Vertex & vertex : ellipsoid)
+    {
+        vertex.position *= scale;
+    }
+
+    int failures = flippedChildren(coarse, glm::vec3(1.0f))
+                 + flippedChildren(finer, glm::vec3(1.0f))
+                 + flippedChildren(ellipsoid, scale);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}